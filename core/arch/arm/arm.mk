@@ -151,6 +151,66 @@ endif
 ifeq ($(CFG_CORE_FFA)-$(CFG_WITH_PAGER),y-y)
 $(error CFG_CORE_FFA and CFG_WITH_PAGER are not compatible)
 endif
+
+# CFG_RPC_BATCH, when enabled and normal world announces
+# OPTEE_SMC_NSEC_CAP_RPC_BATCH, RPCs which result isn't needed and which
+# may be delayed, such as freeing shared memory, are queued and sent
+# several at a time with OPTEE_RPC_CMD_BATCH. Only supported with the SMC
+# ABI.
+ifeq ($(CFG_CORE_FFA),y)
+$(call force,CFG_RPC_BATCH,n)
+else
+CFG_RPC_BATCH ?= y
+endif
+
+# CFG_RPC_PAYLOAD_CACHE, when enabled, RPC payload buffers freed by a
+# thread are kept for reuse by the next allocation of the same thread,
+# saving the OPTEE_RPC_CMD_SHM_ALLOC and OPTEE_RPC_CMD_SHM_FREE round
+# trips. One buffer is kept per buffer type and power of two size class,
+# the CFG_RPC_PAYLOAD_CACHE_NUM_CLASSES classes ranging from 4 KiB up to
+# 4 KiB << (CFG_RPC_PAYLOAD_CACHE_NUM_CLASSES - 1). The cache is only used
+# while the prealloc RPC cache (CFG_PREALLOC_RPC_CACHE) is enabled by
+# normal world, disabling it empties the cache too. Only supported with
+# the SMC ABI.
+ifeq ($(CFG_CORE_FFA),y)
+$(call force,CFG_RPC_PAYLOAD_CACHE,n)
+else
+CFG_RPC_PAYLOAD_CACHE ?= $(CFG_PREALLOC_RPC_CACHE)
+endif
+CFG_RPC_PAYLOAD_CACHE_NUM_CLASSES ?= 5
+
+# CFG_CORE_SGMEM, when enabled, normal world may pass a memory reference
+# as a list of segments of registered shared memory with
+# OPTEE_MSG_ATTR_TYPE_SGMEM_*, announced with OPTEE_SMC_SEC_CAP_SGMEM. The
+# segments are mapped virtually contiguous for the TA, so all segments but
+# the first must start on a page boundary and all but the last must end on
+# one. At most CFG_CORE_SGMEM_MAX_SEGS segments are accepted per
+# parameter. Only supported with the SMC ABI.
+ifeq ($(CFG_CORE_FFA),y)
+$(call force,CFG_CORE_SGMEM,n)
+else
+CFG_CORE_SGMEM ?= $(CFG_CORE_DYN_SHM)
+endif
+CFG_CORE_SGMEM_MAX_SEGS ?= 64
+
+# CFG_TA_TIME_PAGE, when enabled, maps a read-only page into each user TA
+# with the counter frequency and the last REE time fetched from normal
+# world, see struct utee_time_page. TEE_GetSystemTime() and
+# TEE_GetREETime() are then served by libutee from the counter without a
+# system call, the REE time is fetched again once the last sample is older
+# than CFG_TA_TIME_PAGE_REE_PERIOD_MS. Not supported with
+# CFG_NS_VIRTUALIZATION where each guest has its own time.
+# Note that this gives all user TAs direct access to the high resolution
+# physical counter (and the virtual counter with CFG_CORE_SEL2_SPMC=y),
+# which otherwise only is enabled with CFG_FTRACE_SUPPORT=y. A precise
+# timer makes timing side channel attacks from a TA easier, so it's
+# disabled by default.
+ifeq ($(CFG_NS_VIRTUALIZATION),y)
+$(call force,CFG_TA_TIME_PAGE,n)
+else
+CFG_TA_TIME_PAGE ?= n
+endif
+CFG_TA_TIME_PAGE_REE_PERIOD_MS ?= 1000
 ifeq ($(CFG_GIC),y)
 ifeq ($(CFG_ARM_GICV3),y)
 $(call force,CFG_CORE_IRQ_IS_NATIVE_INTR,y)
@@ -434,6 +434,19 @@ static inline void thread_user_clear_vfp(struct user_mode_ctx *uctx __unused)
 }
 #endif
 
+/*
+ * thread_user_clear_vfp_state() - Clears a vfp state
+ * @uvfp:	pointer to the saved state to clear
+ */
+#ifdef CFG_WITH_VFP
+void thread_user_clear_vfp_state(struct thread_user_vfp_state *uvfp);
+#else
+static inline void
+thread_user_clear_vfp_state(struct thread_user_vfp_state *uvfp __unused)
+{
+}
+#endif
+
 #ifdef ARM64
 /*
  * thread_get_saved_thread_sp() - Returns the saved sp of current thread
@@ -488,10 +501,11 @@ static inline void thread_get_user_kdata(struct mobj **mobj, size_t *offset,
  * Disables and empties the prealloc RPC cache one reference at a time. If
  * all threads are idle this function returns true and a cookie of one shm
  * object which was removed from the cache. When the cache is empty *cookie
- * is set to 0 and the cache is disabled else a valid cookie value. If one
+ * is set to 0 and the cache is disabled else a valid cookie value and
+ * *shm_type is set to the OPTEE_RPC_SHM_TYPE_* of the shm object. If one
  * thread isn't idle this function returns false.
  */
-bool thread_disable_prealloc_rpc_cache(uint64_t *cookie);
+bool thread_disable_prealloc_rpc_cache(uint64_t *cookie, uint32_t *shm_type);
 
 /*
  * Enabled the prealloc RPC cache. If all threads are idle the cache is
@@ -500,6 +514,31 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie);
  */
 bool thread_enable_prealloc_rpc_cache(void);
 
+/*
+ * Enables or disables batching of RPCs with OPTEE_RPC_CMD_BATCH depending
+ * on the capabilities announced by normal world.
+ */
+#ifdef CFG_RPC_BATCH
+void thread_rpc_batch_enable(bool enable);
+#else
+static inline void thread_rpc_batch_enable(bool enable __unused)
+{
+}
+#endif
+
+/*
+ * Selects if RPC payload buffers of all OPTEE_RPC_SHM_TYPE_* types are
+ * cached or only OPTEE_RPC_SHM_TYPE_KERNEL buffers, depending on the
+ * capabilities announced by normal world.
+ */
+#ifdef CFG_RPC_PAYLOAD_CACHE
+void thread_rpc_payload_cache_all_types(bool enable);
+#else
+static inline void thread_rpc_payload_cache_all_types(bool enable __unused)
+{
+}
+#endif
+
 unsigned long thread_hvc(unsigned long func_id, unsigned long a1,
 			 unsigned long a2, unsigned long a3);
 unsigned long thread_smc(unsigned long func_id, unsigned long a1,
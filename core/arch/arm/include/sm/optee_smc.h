@@ -299,6 +299,13 @@
  */
 /* Normal world works as a uniprocessor system */
 #define OPTEE_SMC_NSEC_CAP_UNIPROCESSOR		BIT(0)
+/* Normal world can execute OPTEE_RPC_CMD_BATCH */
+#define OPTEE_SMC_NSEC_CAP_RPC_BATCH		BIT(1)
+/*
+ * Normal world can free any OPTEE_RPC_SHM_TYPE_* buffer returned by
+ * OPTEE_SMC_DISABLE_SHM_CACHE
+ */
+#define OPTEE_SMC_NSEC_CAP_RPC_PAYLOAD_CACHE	BIT(2)
 /* Secure world has reserved shared memory for normal world to use */
 #define OPTEE_SMC_SEC_CAP_HAVE_RESERVED_SHM	BIT(0)
 /* Secure world can communicate via previously unregistered shared memory */
@@ -318,6 +325,13 @@
 #define OPTEE_SMC_SEC_CAP_RPC_ARG		BIT(6)
 /* Secure world supports probing for RPMB device if needed */
 #define OPTEE_SMC_SEC_CAP_RPMB_PROBE		BIT(7)
+/*
+ * Secure world may send OPTEE_RPC_CMD_BATCH, only if normal world
+ * announced OPTEE_SMC_NSEC_CAP_RPC_BATCH
+ */
+#define OPTEE_SMC_SEC_CAP_RPC_BATCH		BIT(8)
+/* Secure world supports OPTEE_MSG_ATTR_TYPE_SGMEM_* memory references */
+#define OPTEE_SMC_SEC_CAP_SGMEM			BIT(9)
 
 #define OPTEE_SMC_FUNCID_EXCHANGE_CAPABILITIES	U(9)
 #define OPTEE_SMC_EXCHANGE_CAPABILITIES \
@@ -332,6 +346,12 @@
  * cache and free all cached objects this function has to be called until
  * it returns OPTEE_SMC_RETURN_ENOTAVAIL.
  *
+ * Payload buffers allocated with OPTEE_RPC_CMD_SHM_ALLOC may also be
+ * cached. Unless normal world has announced
+ * OPTEE_SMC_NSEC_CAP_RPC_PAYLOAD_CACHE only buffers of type
+ * OPTEE_RPC_SHM_TYPE_KERNEL, allocated the same way as RPC arguments, are
+ * cached.
+ *
  * Call register usage:
  * a0	SMC Function ID, OPTEE_SMC_DISABLE_SHM_CACHE
  * a1-6	Not used
@@ -341,7 +361,9 @@
  * a0	OPTEE_SMC_RETURN_OK
  * a1	Upper 32 bits of a 64-bit Shared memory cookie
  * a2	Lower 32 bits of a 64-bit Shared memory cookie
- * a3-7	Preserved
+ * a3	OPTEE_RPC_SHM_TYPE_* of the shared memory object, RPC arguments
+ *	are OPTEE_RPC_SHM_TYPE_KERNEL
+ * a4-7	Preserved
  *
  * Cache empty return register usage:
  * a0	OPTEE_SMC_RETURN_ENOTAVAIL
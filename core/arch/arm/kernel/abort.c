@@ -397,8 +397,13 @@ static void handle_user_mode_panic(struct abort_info *ai)
 static void handle_user_mode_vfp(void)
 {
 	struct ts_session *s = ts_get_current_session();
+	struct thread_user_vfp_state *uvfp = &to_user_mode_ctx(s->ctx)->vfp;
 
-	thread_user_enable_vfp(&to_user_mode_ctx(s->ctx)->vfp);
+#ifdef CFG_TA_CONCURRENT
+	if (s->user_vfp)
+		uvfp = s->user_vfp;
+#endif
+	thread_user_enable_vfp(uvfp);
 }
 #endif /*CFG_WITH_VFP*/
 
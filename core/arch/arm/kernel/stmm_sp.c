@@ -103,7 +103,7 @@ static struct stmm_ctx *stmm_alloc_ctx(const TEE_UUID *uuid)
 	}
 
 	spc->ta_ctx.ref_count = 1;
-	condvar_init(&spc->ta_ctx.busy_cv);
+	tee_ta_ctx_init_busy(&spc->ta_ctx);
 
 	return spc;
 }
@@ -2,6 +2,7 @@ srcs-y += rpc_io_i2c.c
 srcs-y += idle.c
 
 srcs-$(CFG_SECURE_TIME_SOURCE_CNTPCT) += tee_time_arm_cntpct.c
+srcs-$(CFG_TA_TIME_PAGE) += tee_time_page.c
 ifeq ($(CFG_CALLOUT),y)
 srcs-$(CFG_ARM64_core) += generic_timer.c
 endif
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <arm.h>
+#include <initcall.h>
+#include <kernel/panic.h>
+#include <kernel/spinlock.h>
+#include <kernel/tee_time.h>
+#include <mm/mobj.h>
+#include <utee_defines.h>
+#include <utee_types.h>
+#include <util.h>
+
+/*
+ * The page is mapped read-only into each user mode context, the rest of
+ * the page must not hold anything else.
+ */
+static union {
+	struct utee_time_page tp;
+	uint8_t data[SMALL_PAGE_SIZE];
+} time_page __aligned(SMALL_PAGE_SIZE);
+
+static unsigned int time_page_lock = SPINLOCK_UNLOCK;
+
+void tee_time_page_get(struct mobj **mobj, size_t *offs, size_t *sz)
+{
+	*mobj = mobj_tee_ram_rw;
+	*sz = sizeof(time_page);
+	*offs = (vaddr_t)&time_page - (vaddr_t)mobj_get_va(*mobj, 0, *sz);
+}
+
+void tee_time_page_set_ree_time(const TEE_Time *time)
+{
+	struct utee_time_page *tp = &time_page.tp;
+	uint64_t cnt = barrier_read_counter_timer();
+	uint32_t exceptions = cpu_spin_lock_xsave(&time_page_lock);
+
+	/* An odd sequence count tells readers that an update is ongoing */
+	__atomic_store_n(&tp->seq, tp->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	tp->ree_cnt = cnt;
+	tp->ree_seconds = time->seconds;
+	tp->ree_millis = time->millis;
+	tp->flags |= UTEE_TIME_PAGE_REE_VALID;
+
+	__atomic_store_n(&tp->seq, tp->seq + 1, __ATOMIC_RELEASE);
+
+	cpu_spin_unlock_xrestore(&time_page_lock, exceptions);
+}
+
+static TEE_Result time_page_init(void)
+{
+	struct utee_time_page *tp = &time_page.tp;
+
+	tp->cnt_freq = read_cntfrq();
+	if (!tp->cnt_freq)
+		panic();
+	tp->ree_max_age = tp->cnt_freq * CFG_TA_TIME_PAGE_REE_PERIOD_MS /
+			  TEE_TIME_MILLIS_BASE;
+	if (IS_ENABLED(CFG_SECURE_TIME_SOURCE_CNTPCT))
+		tp->flags |= UTEE_TIME_PAGE_SYS_VALID;
+
+	return TEE_SUCCESS;
+}
+
+early_init(time_page_init);
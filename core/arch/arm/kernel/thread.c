@@ -222,26 +222,24 @@ static void __thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2,
 				   void *pc, uint32_t flags)
 {
 	struct thread_core_local *l = thread_get_core_local();
-	bool found_thread = false;
-	size_t n = 0;
+	short int n = 0;
 
 	assert(l->curr_thread == THREAD_ID_INVALID);
 
-	thread_lock_global();
+	n = thread_claim_id();
+	if (n == THREAD_ID_INVALID)
+		return;
 
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state == THREAD_STATE_FREE) {
-			threads[n].state = THREAD_STATE_ACTIVE;
-			found_thread = true;
-			break;
-		}
+	if (!thread_alloc_stack(n)) {
+		thread_release_id(n);
+		return;
 	}
 
+	thread_lock_global();
+	assert(threads[n].state == THREAD_STATE_FREE);
+	threads[n].state = THREAD_STATE_ACTIVE;
 	thread_unlock_global();
 
-	if (!found_thread)
-		return;
-
 	l->curr_thread = n;
 
 	threads[n].flags = flags;
@@ -456,12 +454,14 @@ void thread_state_free(void)
 	tee_pager_release_phys(
 		(void *)(threads[ct].stack_va_end - STACK_THREAD_SIZE),
 		STACK_THREAD_SIZE);
+	thread_free_stack(ct);
 
 	thread_lock_global();
 
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
 	threads[ct].state = THREAD_STATE_FREE;
 	threads[ct].flags = 0;
+	thread_release_id(ct);
 	l->curr_thread = THREAD_ID_INVALID;
 
 	if (IS_ENABLED(CFG_NS_VIRTUALIZATION))
@@ -777,14 +777,18 @@ void thread_init_per_cpu(void)
 
 	thread_init_vbar(get_excp_vect());
 
-#ifdef CFG_FTRACE_SUPPORT
+#if defined(CFG_FTRACE_SUPPORT) || defined(CFG_TA_TIME_PAGE)
 	/*
 	 * Enable accesses to frequency register and physical counter
 	 * register in EL0/PL0 required for timestamping during
-	 * function tracing.
+	 * function tracing and for reading the time in libutee.
 	 */
 	write_cntkctl(read_cntkctl() | CNTKCTL_PL0PCTEN);
 #endif
+#if defined(CFG_TA_TIME_PAGE) && defined(CFG_CORE_SEL2_SPMC)
+	/* barrier_read_counter_timer() uses the virtual counter */
+	write_cntkctl(read_cntkctl() | CNTKCTL_PL0VCTEN);
+#endif
 }
 
 #ifdef CFG_WITH_VFP
@@ -904,9 +908,8 @@ void thread_user_save_vfp(void)
 	tuv->lazy_saved = true;
 }
 
-void thread_user_clear_vfp(struct user_mode_ctx *uctx)
+void thread_user_clear_vfp_state(struct thread_user_vfp_state *uvfp)
 {
-	struct thread_user_vfp_state *uvfp = &uctx->vfp;
 	struct thread_ctx *thr = threads + thread_get_id();
 
 	if (uvfp == thr->vfp_state.uvfp)
@@ -914,6 +917,11 @@ void thread_user_clear_vfp(struct user_mode_ctx *uctx)
 	uvfp->lazy_saved = false;
 	uvfp->saved = false;
 }
+
+void thread_user_clear_vfp(struct user_mode_ctx *uctx)
+{
+	thread_user_clear_vfp_state(&uctx->vfp);
+}
 #endif /*CFG_WITH_VFP*/
 
 #ifdef ARM32
@@ -1023,6 +1031,9 @@ uint32_t thread_enter_user_mode(unsigned long a0, unsigned long a1,
 	struct thread_ctx_regs *regs = NULL;
 	struct thread_pauth_keys *keys = NULL;
 
+	/* Deliver queued RPCs before possibly running for a long time */
+	thread_rpc_flush();
+
 	tee_ta_update_session_utime_resume();
 
 	keys = thread_get_pauth_keys();
@@ -1132,6 +1143,7 @@ void __weak thread_scall_handler(struct thread_scall_regs *regs)
 	assert(sess && sess->handle_scall);
 	if (sess->handle_scall(regs)) {
 		/* We're about to switch back to user mode */
+		thread_rpc_flush();
 		gprof_set_status(sess, TS_GPROF_RESUME);
 	} else {
 		/* We're returning from __thread_enter_user_mode() */
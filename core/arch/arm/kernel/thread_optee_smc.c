@@ -26,6 +26,27 @@
 static bool thread_prealloc_rpc_cache;
 static unsigned int thread_rpc_pnum;
 
+#ifdef CFG_RPC_PAYLOAD_CACHE
+#define PAYLOAD_CACHE_NUM_TYPES		(OPTEE_RPC_SHM_TYPE_GLOBAL + 1)
+#define PAYLOAD_CACHE_NUM_CLASSES	CFG_RPC_PAYLOAD_CACHE_NUM_CLASSES
+
+/*
+ * struct payload_cache - payload buffers freed by a thread
+ * @mobj:	one buffer per OPTEE_RPC_SHM_TYPE_* and size class, size
+ *		class n holds a buffer of at least SMALL_PAGE_SIZE << n bytes
+ *
+ * Buffers are only cached while the prealloc RPC cache is enabled since
+ * that's when normal world calls OPTEE_SMC_DISABLE_SHM_CACHE to empty the
+ * cache.
+ */
+struct payload_cache {
+	struct mobj *mobj[PAYLOAD_CACHE_NUM_TYPES][PAYLOAD_CACHE_NUM_CLASSES];
+};
+
+static struct payload_cache thread_payload_cache[CFG_NUM_THREADS];
+static bool thread_payload_cache_all_types;
+#endif
+
 static_assert(NOTIF_VALUE_DO_BOTTOM_HALF ==
 	      OPTEE_SMC_ASYNC_NOTIF_VALUE_DO_BOTTOM_HALF);
 
@@ -168,6 +189,8 @@ static uint32_t call_entry_std(struct optee_msg_arg *arg, size_t num_params,
 		rv = OPTEE_SMC_RETURN_OK;
 
 	thread_rpc_shm_cache_clear(&thr->shm_cache);
+	/* Batched RPCs must be sent before the RPC arg struct is released */
+	thread_rpc_flush();
 	if (rpc_arg)
 		thr->rpc_arg = NULL;
 
@@ -301,7 +324,144 @@ uint32_t __weak __thread_std_smc_entry(uint32_t a0, uint32_t a1, uint32_t a2,
 	return std_smc_entry(a0, a1, a2, a3);
 }
 
-bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
+#ifdef CFG_RPC_PAYLOAD_CACHE
+void thread_rpc_payload_cache_all_types(bool enable)
+{
+	thread_payload_cache_all_types = enable;
+}
+
+static bool payload_cache_enabled(unsigned int bt)
+{
+	/* Threads aren't tied to a guest, buffers mustn't be shared */
+	if (IS_ENABLED(CFG_NS_VIRTUALIZATION) ||
+	    !IS_ENABLED(CFG_PREALLOC_RPC_CACHE) || !thread_prealloc_rpc_cache)
+		return false;
+
+	if (bt == OPTEE_RPC_SHM_TYPE_KERNEL)
+		return true;
+
+	return thread_payload_cache_all_types && bt < PAYLOAD_CACHE_NUM_TYPES;
+}
+
+/* Returns the smallest size class of at least @size bytes, or -1 */
+static int payload_cache_alloc_class(size_t size)
+{
+	int n = 0;
+
+	for (n = 0; n < PAYLOAD_CACHE_NUM_CLASSES; n++)
+		if (size <= (SMALL_PAGE_SIZE << n))
+			return n;
+
+	return -1;
+}
+
+/* Returns the largest size class of at most @size bytes, or -1 */
+static int payload_cache_free_class(size_t size)
+{
+	int n = 0;
+
+	if (size < SMALL_PAGE_SIZE ||
+	    size >= (SMALL_PAGE_SIZE << PAYLOAD_CACHE_NUM_CLASSES))
+		return -1;
+
+	for (n = PAYLOAD_CACHE_NUM_CLASSES - 1; n > 0; n--)
+		if (size >= (SMALL_PAGE_SIZE << n))
+			break;
+
+	return n;
+}
+
+/*
+ * Returns a cached buffer of type @bt large enough for @size bytes, or
+ * NULL with *@alloc_size updated to the size to allocate for the buffer
+ * to be cacheable once freed.
+ */
+static struct mobj *payload_cache_get(unsigned int bt, size_t *alloc_size)
+{
+	struct payload_cache *pc = thread_payload_cache + thread_get_id();
+	struct mobj *mobj = NULL;
+	int cls = 0;
+
+	if (!payload_cache_enabled(bt))
+		return NULL;
+
+	cls = payload_cache_alloc_class(*alloc_size);
+	if (cls < 0)
+		return NULL;
+
+	mobj = pc->mobj[bt][cls];
+	pc->mobj[bt][cls] = NULL;
+	if (!mobj)
+		*alloc_size = SMALL_PAGE_SIZE << cls;
+
+	return mobj;
+}
+
+/* Returns true if @mobj of type @bt was taken over by the cache */
+static bool payload_cache_put(unsigned int bt, struct mobj *mobj)
+{
+	struct payload_cache *pc = thread_payload_cache + thread_get_id();
+	int cls = 0;
+
+	if (!mobj || !payload_cache_enabled(bt))
+		return false;
+
+	cls = payload_cache_free_class(mobj->size);
+	if (cls < 0 || pc->mobj[bt][cls])
+		return false;
+
+	pc->mobj[bt][cls] = mobj;
+
+	return true;
+}
+
+/* Removes one cached buffer, returns its cookie or 0 if none is cached */
+static uint64_t payload_cache_pop(uint32_t *shm_type)
+{
+	struct mobj *mobj = NULL;
+	uint64_t cookie = 0;
+	size_t n = 0;
+	size_t t = 0;
+	size_t c = 0;
+
+	for (n = 0; n < CFG_NUM_THREADS; n++) {
+		for (t = 0; t < PAYLOAD_CACHE_NUM_TYPES; t++) {
+			for (c = 0; c < PAYLOAD_CACHE_NUM_CLASSES; c++) {
+				mobj = thread_payload_cache[n].mobj[t][c];
+				if (!mobj)
+					continue;
+
+				thread_payload_cache[n].mobj[t][c] = NULL;
+				cookie = mobj_get_cookie(mobj);
+				mobj_put(mobj);
+				*shm_type = t;
+				return cookie;
+			}
+		}
+	}
+
+	return 0;
+}
+#else
+static struct mobj *payload_cache_get(unsigned int bt __unused,
+				      size_t *alloc_size __unused)
+{
+	return NULL;
+}
+
+static bool payload_cache_put(unsigned int bt __unused,
+			      struct mobj *mobj __unused)
+{
+	return false;
+}
+
+static uint64_t payload_cache_pop(uint32_t *shm_type __unused)
+{
+	return 0;
+}
+#endif /*CFG_RPC_PAYLOAD_CACHE*/
+
+bool thread_disable_prealloc_rpc_cache(uint64_t *cookie, uint32_t *shm_type)
 {
 	bool rv = false;
 	size_t n = 0;
@@ -322,12 +482,17 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 		for (n = 0; n < CFG_NUM_THREADS; n++) {
 			if (threads[n].rpc_arg) {
 				*cookie = mobj_get_cookie(threads[n].rpc_mobj);
+				*shm_type = OPTEE_RPC_SHM_TYPE_KERNEL;
 				mobj_put(threads[n].rpc_mobj);
 				threads[n].rpc_arg = NULL;
 				threads[n].rpc_mobj = NULL;
 				goto out;
 			}
 		}
+
+		*cookie = payload_cache_pop(shm_type);
+		if (*cookie)
+			goto out;
 	}
 
 	*cookie = 0;
@@ -457,9 +622,9 @@ static bool set_tmem(struct optee_msg_param *param,
 	return true;
 }
 
-static uint32_t get_rpc_arg(uint32_t cmd, size_t num_params,
-			    struct thread_param *params, void **arg_ret,
-			    uint64_t *carg_ret)
+static uint32_t fill_rpc_arg(uint32_t cmd, size_t num_params,
+			     struct thread_param *params, void **arg_ret,
+			     uint64_t *carg_ret)
 {
 	struct thread_ctx *thr = threads + thread_get_id();
 	struct optee_msg_arg *arg = thr->rpc_arg;
@@ -531,6 +696,98 @@ static uint32_t get_rpc_arg(uint32_t cmd, size_t num_params,
 	return TEE_SUCCESS;
 }
 
+static uint32_t get_rpc_arg(uint32_t cmd, size_t num_params,
+			    struct thread_param *params, void **arg_ret,
+			    uint64_t *carg_ret)
+{
+	/*
+	 * Queued RPCs are sent first, both to keep the order of the RPCs
+	 * and since they use the same RPC arg struct.
+	 */
+	thread_rpc_flush();
+
+	return fill_rpc_arg(cmd, num_params, params, arg_ret, carg_ret);
+}
+
+#ifdef CFG_RPC_BATCH
+/*
+ * struct rpc_batch - RPCs queued by a thread
+ * @count:	number of used elements in @params
+ * @params:	one parameter per queued RPC as described by
+ *		OPTEE_RPC_CMD_BATCH
+ */
+struct rpc_batch {
+	size_t count;
+	struct thread_param params[THREAD_RPC_MAX_NUM_PARAMS];
+};
+
+static struct rpc_batch thread_rpc_batch[CFG_NUM_THREADS];
+static bool thread_rpc_batch_enabled;
+
+void thread_rpc_batch_enable(bool enable)
+{
+	thread_rpc_batch_enabled = enable;
+}
+
+void thread_rpc_flush(void)
+{
+	uint32_t rpc_args[THREAD_RPC_NUM_ARGS] = { OPTEE_SMC_RETURN_RPC_CMD };
+	struct rpc_batch *b = thread_rpc_batch + thread_get_id();
+	struct thread_param params[THREAD_RPC_MAX_NUM_PARAMS] = { };
+	struct thread_param param = { };
+	size_t count = b->count;
+	void *arg = NULL;
+	uint64_t carg = 0;
+	size_t n = 0;
+
+	if (!count)
+		return;
+
+	/* Results are ignored, the RPCs in the batch don't need them */
+	if (!fill_rpc_arg(OPTEE_RPC_CMD_BATCH, count, b->params, &arg,
+			  &carg)) {
+		reg_pair_from_64(carg, rpc_args + 1, rpc_args + 2);
+		thread_rpc(rpc_args);
+		b->count = 0;
+		return;
+	}
+
+	/*
+	 * Without room for the batch the RPCs are sent one by one instead,
+	 * dropping them would leak the shared memory they free. The queue
+	 * is emptied first since thread_rpc_cmd() flushes it.
+	 */
+	memcpy(params, b->params, count * sizeof(*params));
+	b->count = 0;
+	for (n = 0; n < count; n++) {
+		param = THREAD_PARAM_VALUE(IN, params[n].u.value.b,
+					   params[n].u.value.c, 0);
+		thread_rpc_cmd(params[n].u.value.a, 1, &param);
+	}
+}
+
+uint32_t thread_rpc_cmd_batched(uint32_t cmd, struct thread_param *param)
+{
+	struct rpc_batch *b = NULL;
+
+	assert(param->attr == THREAD_PARAM_ATTR_VALUE_IN &&
+	       !param->u.value.c);
+
+	if (!thread_rpc_batch_enabled)
+		return thread_rpc_cmd(cmd, 1, param);
+
+	b = thread_rpc_batch + thread_get_id();
+	if (b->count == ARRAY_SIZE(b->params))
+		thread_rpc_flush();
+
+	b->params[b->count] = THREAD_PARAM_VALUE(IN, cmd, param->u.value.a,
+						 param->u.value.b);
+	b->count++;
+
+	return TEE_SUCCESS;
+}
+#endif /*CFG_RPC_BATCH*/
+
 static uint32_t get_rpc_arg_res(struct optee_msg_arg *arg, size_t num_params,
 				struct thread_param *params)
 {
@@ -591,19 +848,15 @@ uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
  */
 static void thread_rpc_free(unsigned int bt, uint64_t cookie, struct mobj *mobj)
 {
-	uint32_t rpc_args[THREAD_RPC_NUM_ARGS] = { OPTEE_SMC_RETURN_RPC_CMD };
-	void *arg = NULL;
-	uint64_t carg = 0;
 	struct thread_param param = THREAD_PARAM_VALUE(IN, bt, cookie, 0);
-	uint32_t ret = get_rpc_arg(OPTEE_RPC_CMD_SHM_FREE, 1, &param,
-				   &arg, &carg);
+
+	if (payload_cache_put(bt, mobj))
+		return;
 
 	mobj_put(mobj);
 
-	if (!ret) {
-		reg_pair_from_64(carg, rpc_args + 1, rpc_args + 2);
-		thread_rpc(rpc_args);
-	}
+	/* The buffer isn't accessed any longer so freeing it can wait */
+	thread_rpc_cmd_batched(OPTEE_RPC_CMD_SHM_FREE, &param);
 }
 
 static struct mobj *get_rpc_alloc_res(struct optee_msg_arg *arg,
@@ -658,12 +911,18 @@ err:
 static struct mobj *thread_rpc_alloc(size_t size, size_t align, unsigned int bt)
 {
 	uint32_t rpc_args[THREAD_RPC_NUM_ARGS] = { OPTEE_SMC_RETURN_RPC_CMD };
+	struct thread_param param = { };
+	struct mobj *mobj = NULL;
 	void *arg = NULL;
 	uint64_t carg = 0;
-	struct thread_param param = THREAD_PARAM_VALUE(IN, bt, size, align);
-	uint32_t ret = get_rpc_arg(OPTEE_RPC_CMD_SHM_ALLOC, 1, &param,
-				   &arg, &carg);
+	uint32_t ret = 0;
+
+	mobj = payload_cache_get(bt, &size);
+	if (mobj)
+		return mobj;
 
+	param = THREAD_PARAM_VALUE(IN, bt, size, align);
+	ret = get_rpc_arg(OPTEE_RPC_CMD_SHM_ALLOC, 1, &param, &arg, &carg);
 	if (ret)
 		return NULL;
 
@@ -23,6 +23,7 @@
 #include <mm/fobj.h>
 #include <mm/tee_mm.h>
 #include <mm/tee_pager.h>
+#include <pta_stats.h>
 #include <stdlib.h>
 #include <sys/queue.h>
 #include <tee_api_defines.h>
@@ -74,6 +75,14 @@ static struct tee_pager_pmem_head tee_pager_lock_pmem_head =
 /* number of pages hidden */
 #define TEE_PAGER_NHIDE (tee_pager_npages / 3)
 
+/*
+ * With CFG_PAGER_CLOCK the head of tee_pager_pmem_head is the hand of a
+ * clock (second chance) replacement policy instead of hiding
+ * TEE_PAGER_NHIDE pages after each fault, see pager_select_victim().
+ */
+#define PAGER_POLICY	(IS_ENABLED(CFG_PAGER_CLOCK) ? \
+			 STATS_PAGER_POLICY_CLOCK : STATS_PAGER_POLICY_FIFO)
+
 /* Number of registered physical pages, used hiding pages. */
 static size_t tee_pager_npages;
 
@@ -82,8 +91,16 @@ static struct vm_paged_region *pager_iv_region;
 /* Used by make_iv_available(), see make_iv_available() for details. */
 static struct tee_pager_pmem *pager_spare_pmem;
 
+/*
+ * Maximum number of pages populated ahead of a fault, see
+ * pager_read_ahead() for details.
+ */
+#define PAGER_READ_AHEAD_MAX	CFG_PAGER_READ_AHEAD_MAX
+
 #ifdef CFG_WITH_STATS
 static struct tee_pager_stats pager_stats;
+/* Kept apart so STATS_CMD_PAGER_STATS doesn't reset them */
+static struct tee_pager_policy_stats pager_policy_stats;
 
 static inline void incr_ro_hits(void)
 {
@@ -98,6 +115,7 @@ static inline void incr_rw_hits(void)
 static inline void incr_hidden_hits(void)
 {
 	pager_stats.hidden_hits++;
+	pager_policy_stats.hidden_hits++;
 }
 
 static inline void incr_zi_released(void)
@@ -110,6 +128,25 @@ static inline void incr_npages_all(void)
 	pager_stats.npages_all++;
 }
 
+static inline void incr_ra_pages(size_t n)
+{
+	pager_stats.ra_pages += n;
+	if (n > pager_stats.ra_window_max)
+		pager_stats.ra_window_max = n;
+}
+
+static inline void incr_evictions(void)
+{
+	pager_stats.evictions++;
+	pager_policy_stats.evictions++;
+}
+
+static inline void incr_pages_hidden(void)
+{
+	pager_stats.pages_hidden++;
+	pager_policy_stats.pages_hidden++;
+}
+
 static inline void set_npages(void)
 {
 	pager_stats.npages = tee_pager_npages;
@@ -117,12 +154,36 @@ static inline void set_npages(void)
 
 void tee_pager_get_stats(struct tee_pager_stats *stats)
 {
+	struct fobj_compr_stats cs = { };
+
+	fobj_get_compr_stats(&cs);
+
 	*stats = pager_stats;
+	stats->policy = PAGER_POLICY;
+	stats->compr_pages = cs.pages;
+	stats->compr_bytes = cs.bytes;
+	stats->compr_pool_size = cs.pool_size;
+	stats->compr_loads = cs.loads;
+	stats->compr_load_us = cs.load_us;
 
 	pager_stats.hidden_hits = 0;
 	pager_stats.ro_hits = 0;
 	pager_stats.rw_hits = 0;
 	pager_stats.zi_released = 0;
+	pager_stats.ra_pages = 0;
+	pager_stats.ra_window_max = 0;
+	pager_stats.evictions = 0;
+	pager_stats.pages_hidden = 0;
+}
+
+void tee_pager_get_policy_stats(struct tee_pager_policy_stats *stats)
+{
+	*stats = pager_policy_stats;
+	stats->policy = PAGER_POLICY;
+
+	pager_policy_stats.evictions = 0;
+	pager_policy_stats.pages_hidden = 0;
+	pager_policy_stats.hidden_hits = 0;
 }
 
 #else /* CFG_WITH_STATS */
@@ -131,12 +192,20 @@ static inline void incr_rw_hits(void) { }
 static inline void incr_hidden_hits(void) { }
 static inline void incr_zi_released(void) { }
 static inline void incr_npages_all(void) { }
+static inline void incr_ra_pages(size_t n __unused) { }
+static inline void incr_evictions(void) { }
+static inline void incr_pages_hidden(void) { }
 static inline void set_npages(void) { }
 
 void tee_pager_get_stats(struct tee_pager_stats *stats)
 {
 	memset(stats, 0, sizeof(struct tee_pager_stats));
 }
+
+void tee_pager_get_policy_stats(struct tee_pager_policy_stats *stats)
+{
+	memset(stats, 0, sizeof(struct tee_pager_policy_stats));
+}
 #endif /* CFG_WITH_STATS */
 
 #define TBL_NUM_ENTRIES	(CORE_MMU_PGDIR_SIZE / SMALL_PAGE_SIZE)
@@ -1281,6 +1350,14 @@ static bool tee_pager_unhide_page(struct vm_paged_region *reg, vaddr_t page_va)
 	return true;
 }
 
+static void incr_region_hits(struct vm_paged_region *reg)
+{
+	if (reg->type == PAGED_REGION_TYPE_RO)
+		incr_ro_hits();
+	else if (reg->type == PAGED_REGION_TYPE_RW)
+		incr_rw_hits();
+}
+
 static void tee_pager_hide_pages(void)
 {
 	struct tee_pager_pmem *pmem = NULL;
@@ -1300,7 +1377,45 @@ static void tee_pager_hide_pages(void)
 
 		pmem->flags |= PMEM_FLAG_HIDDEN;
 		pmem_unmap(pmem, NULL);
+		incr_pages_hidden();
+	}
+}
+
+/*
+ * Returns the pmem to reuse for the next page to load, the pmem is left
+ * in tee_pager_pmem_head.
+ *
+ * With the FIFO policy that's simply the oldest pmem, recently used pages
+ * have been moved towards the tail when unhidden.
+ *
+ * With the clock policy a hidden pmem serves as a page with a cleared
+ * reference bit. A mapped pmem at the hand has been referenced since it
+ * was loaded or last passed by the hand, so it's hidden and moved to the
+ * tail to get a second chance. Any access to it before the hand comes
+ * around again unhides it. After one lap all pmems are hidden, so the
+ * search is bounded by the number of pmems.
+ */
+static struct tee_pager_pmem *pager_select_victim(void)
+{
+	struct tee_pager_pmem *pmem = NULL;
+	size_t n = 0;
+
+	if (!IS_ENABLED(CFG_PAGER_CLOCK))
+		return TAILQ_FIRST(&tee_pager_pmem_head);
+
+	for (n = 0; n < tee_pager_npages; n++) {
+		pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+		if (!pmem || !pmem->fobj || pmem_is_hidden(pmem))
+			return pmem;
+
+		pmem->flags |= PMEM_FLAG_HIDDEN;
+		pmem_unmap(pmem, NULL);
+		incr_pages_hidden();
+		TAILQ_REMOVE(&tee_pager_pmem_head, pmem, link);
+		TAILQ_INSERT_TAIL(&tee_pager_pmem_head, pmem, link);
 	}
+
+	return TAILQ_FIRST(&tee_pager_pmem_head);
 }
 
 static unsigned int __maybe_unused
@@ -1388,7 +1503,6 @@ static void pager_deploy_page(struct tee_pager_pmem *pmem,
 	switch (reg->type) {
 	case PAGED_REGION_TYPE_RO:
 		TAILQ_INSERT_TAIL(&tee_pager_pmem_head, pmem, link);
-		incr_ro_hits();
 		/* Forbid write to aliases for read-only (maybe exec) pages */
 		attr_alias &= ~TEE_MATTR_PW;
 		core_mmu_set_entry(ti, idx_alias, pa_alias, attr_alias);
@@ -1398,7 +1512,6 @@ static void pager_deploy_page(struct tee_pager_pmem *pmem,
 		TAILQ_INSERT_TAIL(&tee_pager_pmem_head, pmem, link);
 		if (writable && (attr & (TEE_MATTR_PW | TEE_MATTR_UW)))
 			pmem->flags |= PMEM_FLAG_DIRTY;
-		incr_rw_hits();
 		break;
 	case PAGED_REGION_TYPE_LOCK:
 		/* Move page to lock list */
@@ -1538,6 +1651,7 @@ static void make_iv_available(struct fobj *fobj, unsigned int fobj_pgidx,
 
 		pager_deploy_page(pmem, reg, page_va,
 				  false /*!clean_user_cache*/, writable);
+		incr_region_hits(reg);
 	} else if (writable && !(attr & TEE_MATTR_PW)) {
 		pmem = pmem_find(reg, page_va);
 		/* Note that pa is valid since TEE_MATTR_VALID_BLOCK is set */
@@ -1559,7 +1673,7 @@ static void pager_get_page(struct vm_paged_region *reg, struct abort_info *ai,
 	 * the corresponding IV page is available.
 	 */
 	while (true) {
-		pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+		pmem = pager_select_victim();
 		if (!pmem) {
 			EMSG("No pmem entries");
 			abort_print(ai);
@@ -1567,6 +1681,7 @@ static void pager_get_page(struct vm_paged_region *reg, struct abort_info *ai,
 		}
 
 		if (pmem->fobj) {
+			incr_evictions();
 			pmem_unmap(pmem, NULL);
 			if (pmem_is_dirty(pmem)) {
 				uint8_t *va = pmem->va_alias;
@@ -1651,6 +1766,83 @@ static void pager_get_page(struct vm_paged_region *reg, struct abort_info *ai,
 		writable = false;
 
 	pager_deploy_page(pmem, reg, page_va, clean_user_cache, writable);
+	incr_region_hits(reg);
+}
+
+/*
+ * Populates one page ahead of a fault. Only free physical pages are used,
+ * a speculative load never evicts a page that is in use.
+ */
+static bool read_ahead_one(struct vm_paged_region *reg, vaddr_t page_va,
+			   bool clean_user_cache)
+{
+	struct tblidx tblidx = region_va2tblidx(reg, page_va);
+	struct tee_pager_pmem *pmem = TAILQ_FIRST(&tee_pager_pmem_head);
+	uint32_t attr = 0;
+
+	if (!pmem || pmem->fobj || !tblidx.pgt)
+		return false;
+
+	/* Already mapped, or loaded but hidden */
+	tblidx_get_entry(tblidx, NULL, &attr);
+	if ((attr & TEE_MATTR_VALID_BLOCK) || pmem_find(reg, page_va))
+		return false;
+
+	TAILQ_REMOVE(&tee_pager_pmem_head, pmem, link);
+	pmem_assign_fobj_page(pmem, reg, page_va);
+	make_iv_available(pmem->fobj, pmem->fobj_pgidx, false /*!writable*/);
+	if (IS_ENABLED(CFG_CORE_PAGE_TAG_AND_IV) && !pager_spare_pmem) {
+		/*
+		 * The spare pmem was used by make_iv_available(), replace
+		 * it with this pmem and stop reading ahead.
+		 */
+		pmem_clear(pmem);
+		pager_spare_pmem = pmem;
+		return false;
+	}
+
+	pager_deploy_page(pmem, reg, page_va, clean_user_cache,
+			  false /*!writable*/);
+	return true;
+}
+
+/*
+ * Adaptive read-ahead for sequential faults within a region.
+ *
+ * When a fault hits the page following the last page populated by the
+ * previous fault in the same region the access pattern is considered
+ * sequential and the read-ahead window is doubled, up to
+ * PAGER_READ_AHEAD_MAX pages. Any other fault closes the window again.
+ *
+ * Pages read ahead are mapped read-only, RW pages are made dirty on
+ * first write as usual. Locked regions are never read ahead since their
+ * pages aren't returned to the pool.
+ */
+static void pager_read_ahead(struct vm_paged_region *reg, vaddr_t page_va,
+			     bool clean_user_cache)
+{
+	unsigned int window = 0;
+	unsigned int n = 0;
+	vaddr_t va = 0;
+
+	if (!PAGER_READ_AHEAD_MAX || reg->type == PAGED_REGION_TYPE_LOCK)
+		return;
+
+	if (page_va == reg->ra_next_va) {
+		window = MAX(2 * reg->ra_window, 1U);
+		window = MIN(window, (unsigned int)PAGER_READ_AHEAD_MAX);
+	}
+
+	for (n = 0; n < window; n++) {
+		va = page_va + (n + 1) * SMALL_PAGE_SIZE;
+		if (va - reg->base >= reg->size ||
+		    !read_ahead_one(reg, va, clean_user_cache))
+			break;
+	}
+
+	reg->ra_window = window;
+	reg->ra_next_va = page_va + (n + 1) * SMALL_PAGE_SIZE;
+	incr_ra_pages(n);
 }
 
 static bool pager_update_permissions(struct vm_paged_region *reg,
@@ -1814,9 +2006,11 @@ bool tee_pager_handle_fault(struct abort_info *ai)
 	}
 
 	pager_get_page(reg, ai, clean_user_cache);
+	pager_read_ahead(reg, page_va, clean_user_cache);
 
 out_success:
-	tee_pager_hide_pages();
+	if (!IS_ENABLED(CFG_PAGER_CLOCK))
+		tee_pager_hide_pages();
 	ret = true;
 out:
 	pager_unlock(exceptions);
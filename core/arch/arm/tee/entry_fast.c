@@ -67,6 +67,7 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 {
 	bool res_shm_en = IS_ENABLED(CFG_CORE_RESERVED_SHM);
 	bool dyn_shm_en __maybe_unused = false;
+	bool rpc_batch_en = false;
 
 	/*
 	 * Currently we ignore OPTEE_SMC_NSEC_CAP_UNIPROCESSOR.
@@ -81,12 +82,25 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 	 * OPTEE_SMC_NSEC_CAP_UNIPROCESSOR.
 	 */
 
-	if (args->a1 & ~OPTEE_SMC_NSEC_CAP_UNIPROCESSOR) {
+	if (args->a1 & ~(OPTEE_SMC_NSEC_CAP_UNIPROCESSOR |
+			 OPTEE_SMC_NSEC_CAP_RPC_BATCH |
+			 OPTEE_SMC_NSEC_CAP_RPC_PAYLOAD_CACHE)) {
 		/* Unknown capability. */
 		args->a0 = OPTEE_SMC_RETURN_ENOTAVAIL;
 		return;
 	}
 
+	/*
+	 * The batching state is global, with ns-virtualization guests
+	 * could announce different capabilities.
+	 */
+	rpc_batch_en = IS_ENABLED(CFG_RPC_BATCH) &&
+		       !IS_ENABLED(CFG_NS_VIRTUALIZATION) &&
+		       (args->a1 & OPTEE_SMC_NSEC_CAP_RPC_BATCH);
+	thread_rpc_batch_enable(rpc_batch_en);
+	thread_rpc_payload_cache_all_types(args->a1 &
+					   OPTEE_SMC_NSEC_CAP_RPC_PAYLOAD_CACHE);
+
 	args->a0 = OPTEE_SMC_RETURN_OK;
 	args->a1 = 0;
 
@@ -101,6 +115,9 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 #endif
 	IMSG("Dynamic shared memory is %sabled", dyn_shm_en ? "en" : "dis");
 
+	if (IS_ENABLED(CFG_CORE_SGMEM) && dyn_shm_en)
+		args->a1 |= OPTEE_SMC_SEC_CAP_SGMEM;
+
 	if (IS_ENABLED(CFG_NS_VIRTUALIZATION))
 		args->a1 |= OPTEE_SMC_SEC_CAP_VIRTUALIZATION;
 	IMSG("Normal World virtualization support is %sabled",
@@ -120,13 +137,18 @@ static void tee_entry_exchange_capabilities(struct thread_smc_args *args)
 
 	if (IS_ENABLED(CFG_RPMB_ANNOUNCE_PROBE_CAP))
 		args->a1 |= OPTEE_SMC_SEC_CAP_RPMB_PROBE;
+
+	if (rpc_batch_en)
+		args->a1 |= OPTEE_SMC_SEC_CAP_RPC_BATCH;
+	DMSG("Batched RPC is %sabled", rpc_batch_en ? "en" : "dis");
 }
 
 static void tee_entry_disable_shm_cache(struct thread_smc_args *args)
 {
+	uint32_t shm_type = 0;
 	uint64_t cookie;
 
-	if (!thread_disable_prealloc_rpc_cache(&cookie)) {
+	if (!thread_disable_prealloc_rpc_cache(&cookie, &shm_type)) {
 		args->a0 = OPTEE_SMC_RETURN_EBUSY;
 		return;
 	}
@@ -139,6 +161,7 @@ static void tee_entry_disable_shm_cache(struct thread_smc_args *args)
 	args->a0 = OPTEE_SMC_RETURN_OK;
 	args->a1 = cookie >> 32;
 	args->a2 = cookie;
+	args->a3 = shm_type;
 }
 
 static void tee_entry_enable_shm_cache(struct thread_smc_args *args)
@@ -196,6 +196,14 @@ static inline void thread_user_clear_vfp(struct user_mode_ctx *uctx __unused)
 {
 }
 #endif
+#ifdef CFG_WITH_VFP
+void thread_user_clear_vfp_state(struct thread_user_vfp_state *uvfp);
+#else
+static inline void
+thread_user_clear_vfp_state(struct thread_user_vfp_state *uvfp __unused)
+{
+}
+#endif
 
 vaddr_t thread_get_saved_thread_sp(void);
 uint32_t thread_get_hartid_by_hartindex(uint32_t hartidx);
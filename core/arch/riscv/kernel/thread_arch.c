@@ -231,26 +231,24 @@ static void __thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2,
 				   void *pc)
 {
 	struct thread_core_local *l = thread_get_core_local();
-	bool found_thread = false;
-	size_t n = 0;
+	short int n = 0;
 
 	assert(l->curr_thread == THREAD_ID_INVALID);
 
-	thread_lock_global();
+	n = thread_claim_id();
+	if (n == THREAD_ID_INVALID)
+		return;
 
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state == THREAD_STATE_FREE) {
-			threads[n].state = THREAD_STATE_ACTIVE;
-			found_thread = true;
-			break;
-		}
+	if (!thread_alloc_stack(n)) {
+		thread_release_id(n);
+		return;
 	}
 
+	thread_lock_global();
+	assert(threads[n].state == THREAD_STATE_FREE);
+	threads[n].state = THREAD_STATE_ACTIVE;
 	thread_unlock_global();
 
-	if (!found_thread)
-		return;
-
 	l->curr_thread = n;
 
 	threads[n].flags = 0;
@@ -400,12 +398,14 @@ void thread_state_free(void)
 	assert(ct != THREAD_ID_INVALID);
 
 	thread_lazy_restore_ns_vfp();
+	thread_free_stack(ct);
 
 	thread_lock_global();
 
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
 	threads[ct].state = THREAD_STATE_FREE;
 	threads[ct].flags = 0;
+	thread_release_id(ct);
 	l->curr_thread = THREAD_ID_INVALID;
 
 	if (IS_ENABLED(CFG_NS_VIRTUALIZATION))
@@ -4,6 +4,20 @@ CFG_CRYPTO ?= y
 # Note: the compiler flag -Os is not set here but by CFG_CC_OPT_LEVEL
 CFG_CRYPTO_SIZE_OPTIMIZATION ?= y
 
+# With CFG_CRYPTO_CTX_POOL=y crypto contexts released with
+# crypto_recycle_ctx() are wiped and kept for the next allocation of the
+# same algorithm, for up to CFG_CRYPTO_CTX_POOL_ALGOS algorithms with at
+# most CFG_CRYPTO_CTX_POOL_DEPTH contexts each.
+CFG_CRYPTO_CTX_POOL ?= y
+CFG_CRYPTO_CTX_POOL_ALGOS ?= 8
+CFG_CRYPTO_CTX_POOL_DEPTH ?= 2
+
+# With CFG_CRYPTO_KEY_CACHE=y a MAC or IV-less cipher operation of a TA
+# initialized again with the same key copies a keyed context instead of
+# expanding the key again, for instance HMAC ipad/opad or an AES key
+# schedule.
+CFG_CRYPTO_KEY_CACHE ?= y
+
 ifeq (y,$(CFG_CRYPTO))
 
 ###############################################################
@@ -10,14 +10,73 @@
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
 #include <stdlib.h>
 #include <utee_defines.h>
+#include <util.h>
+
+#ifdef CFG_CRYPTO_CTX_POOL
+/*
+ * struct ctx_pool - recycled contexts of one algorithm
+ * @algo:	algorithm of the contexts, 0 if the entry is unused
+ * @pristine:	context which never has been initialized, its state is
+ *		copied into recycled contexts to wipe them
+ * @count:	number of contexts in @ctx
+ * @ctx:	wiped contexts ready to be allocated again
+ */
+struct ctx_pool {
+	uint32_t algo;
+	void *pristine;
+	size_t count;
+	void *ctx[CFG_CRYPTO_CTX_POOL_DEPTH];
+};
+
+static struct ctx_pool ctx_pools[CFG_CRYPTO_CTX_POOL_ALGOS];
+static unsigned int ctx_pool_lock = SPINLOCK_UNLOCK;
+
+static struct ctx_pool *find_pool(uint32_t algo)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(ctx_pools); n++)
+		if (ctx_pools[n].algo == algo)
+			return ctx_pools + n;
+
+	return NULL;
+}
+
+static bool ctx_pool_get(uint32_t algo, void **ctx)
+{
+	struct ctx_pool *pool = NULL;
+	uint32_t exceptions = 0;
+	bool ret = false;
+
+	exceptions = cpu_spin_lock_xsave(&ctx_pool_lock);
+	pool = find_pool(algo);
+	if (pool && pool->count) {
+		pool->count--;
+		*ctx = pool->ctx[pool->count];
+		ret = true;
+	}
+	cpu_spin_unlock_xrestore(&ctx_pool_lock, exceptions);
+
+	return ret;
+}
+#else
+static bool ctx_pool_get(uint32_t algo __unused, void **ctx __unused)
+{
+	return false;
+}
+#endif
 
 TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
 	struct crypto_hash_ctx *c = NULL;
 
+	if (ctx_pool_get(algo, ctx))
+		return TEE_SUCCESS;
+
 	/*
 	 * Use default cryptographic implementation if no matching
 	 * drvcrypt device.
@@ -116,6 +175,9 @@ TEE_Result crypto_cipher_alloc_ctx(void **ctx, uint32_t algo)
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
 	struct crypto_cipher_ctx *c = NULL;
 
+	if (ctx_pool_get(algo, ctx))
+		return TEE_SUCCESS;
+
 	/*
 	 * Use default cryptographic implementation if no matching
 	 * drvcrypt device.
@@ -247,6 +309,9 @@ TEE_Result crypto_mac_alloc_ctx(void **ctx, uint32_t algo)
 	TEE_Result res = TEE_SUCCESS;
 	struct crypto_mac_ctx *c = NULL;
 
+	if (ctx_pool_get(algo, ctx))
+		return TEE_SUCCESS;
+
 	/*
 	 * Use default cryptographic implementation if no matching
 	 * drvcrypt device.
@@ -366,6 +431,9 @@ TEE_Result crypto_authenc_alloc_ctx(void **ctx, uint32_t algo)
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
 	struct crypto_authenc_ctx *c = NULL;
 
+	if (ctx_pool_get(algo, ctx))
+		return TEE_SUCCESS;
+
 	/*
 	 * Use default authenc implementation if no matching
 	 * drvcrypt device.
@@ -476,6 +544,151 @@ void crypto_authenc_copy_state(void *dst_ctx, void *src_ctx)
 	ae_ops(dst_ctx)->copy_state(dst_ctx, src_ctx);
 }
 
+static void free_ctx(uint32_t algo, void *ctx)
+{
+	switch (TEE_ALG_GET_CLASS(algo)) {
+	case TEE_OPERATION_DIGEST:
+		crypto_hash_free_ctx(ctx);
+		break;
+	case TEE_OPERATION_CIPHER:
+		crypto_cipher_free_ctx(ctx);
+		break;
+	case TEE_OPERATION_MAC:
+		crypto_mac_free_ctx(ctx);
+		break;
+	case TEE_OPERATION_AE:
+		crypto_authenc_free_ctx(ctx);
+		break;
+	default:
+		assert(!ctx);
+	}
+}
+
+#ifdef CFG_CRYPTO_CTX_POOL
+static TEE_Result alloc_ctx(uint32_t algo, void **ctx)
+{
+	switch (TEE_ALG_GET_CLASS(algo)) {
+	case TEE_OPERATION_DIGEST:
+		return crypto_hash_alloc_ctx(ctx, algo);
+	case TEE_OPERATION_CIPHER:
+		return crypto_cipher_alloc_ctx(ctx, algo);
+	case TEE_OPERATION_MAC:
+		return crypto_mac_alloc_ctx(ctx, algo);
+	case TEE_OPERATION_AE:
+		return crypto_authenc_alloc_ctx(ctx, algo);
+	default:
+		return TEE_ERROR_NOT_IMPLEMENTED;
+	}
+}
+
+/*
+ * Copies the state of @pristine into @ctx, which wipes all keys and data
+ * from @ctx. Returns false if the contexts are from different
+ * implementations or if the implementation can't copy the state.
+ */
+static bool wipe_ctx(uint32_t algo, void *ctx, void *pristine)
+{
+	switch (TEE_ALG_GET_CLASS(algo)) {
+	case TEE_OPERATION_DIGEST:
+		if (hash_ops(ctx) != hash_ops(pristine) ||
+		    !hash_ops(ctx)->copy_state)
+			return false;
+		crypto_hash_copy_state(ctx, pristine);
+		return true;
+	case TEE_OPERATION_CIPHER:
+		if (cipher_ops(ctx) != cipher_ops(pristine) ||
+		    !cipher_ops(ctx)->copy_state)
+			return false;
+		crypto_cipher_copy_state(ctx, pristine);
+		return true;
+	case TEE_OPERATION_MAC:
+		if (mac_ops(ctx) != mac_ops(pristine) ||
+		    !mac_ops(ctx)->copy_state)
+			return false;
+		crypto_mac_copy_state(ctx, pristine);
+		return true;
+	case TEE_OPERATION_AE:
+		if (ae_ops(ctx) != ae_ops(pristine) ||
+		    !ae_ops(ctx)->copy_state)
+			return false;
+		crypto_authenc_copy_state(ctx, pristine);
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Returns the pool of @algo, a new pool is set up with a pristine context
+ * the first time an algorithm is recycled. Returns NULL if all pools are
+ * in use by other algorithms.
+ */
+static struct ctx_pool *get_pool(uint32_t algo)
+{
+	struct ctx_pool *pool = NULL;
+	uint32_t exceptions = 0;
+	void *pristine = NULL;
+
+	exceptions = cpu_spin_lock_xsave(&ctx_pool_lock);
+	pool = find_pool(algo);
+	cpu_spin_unlock_xrestore(&ctx_pool_lock, exceptions);
+	if (pool)
+		return pool;
+
+	if (alloc_ctx(algo, &pristine))
+		return NULL;
+
+	exceptions = cpu_spin_lock_xsave(&ctx_pool_lock);
+	pool = find_pool(algo);
+	if (!pool) {
+		pool = find_pool(0);
+		if (pool) {
+			pool->pristine = pristine;
+			pool->algo = algo;
+			pristine = NULL;
+		}
+	}
+	cpu_spin_unlock_xrestore(&ctx_pool_lock, exceptions);
+
+	/* Another thread set up the pool meanwhile or no pool was free */
+	if (pristine)
+		free_ctx(algo, pristine);
+
+	return pool;
+}
+
+void crypto_recycle_ctx(void *ctx, uint32_t algo)
+{
+	struct ctx_pool *pool = NULL;
+	uint32_t exceptions = 0;
+
+	if (!ctx)
+		return;
+
+	pool = get_pool(algo);
+	if (!pool || !wipe_ctx(algo, ctx, pool->pristine)) {
+		free_ctx(algo, ctx);
+		return;
+	}
+
+	exceptions = cpu_spin_lock_xsave(&ctx_pool_lock);
+	if (pool->count < ARRAY_SIZE(pool->ctx)) {
+		pool->ctx[pool->count] = ctx;
+		pool->count++;
+		ctx = NULL;
+	}
+	cpu_spin_unlock_xrestore(&ctx_pool_lock, exceptions);
+
+	if (ctx)
+		free_ctx(algo, ctx);
+}
+#else
+void crypto_recycle_ctx(void *ctx, uint32_t algo)
+{
+	free_ctx(algo, ctx);
+}
+#endif
+
 #if !defined(CFG_CRYPTO_RSA) && !defined(CFG_CRYPTO_DSA) && \
     !defined(CFG_CRYPTO_DH) && !defined(CFG_CRYPTO_ECC)
 struct bignum *crypto_bignum_allocate(size_t size_bits __unused)
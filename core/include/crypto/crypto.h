@@ -82,6 +82,17 @@ void crypto_authenc_final(void *ctx);
 void crypto_authenc_free_ctx(void *ctx);
 void crypto_authenc_copy_state(void *dst_ctx, void *src_ctx);
 
+/*
+ * crypto_recycle_ctx() - Release a hash, cipher, MAC or authenc context
+ * @ctx:	Context allocated with crypto_*_alloc_ctx(), may be NULL
+ * @algo:	Algorithm @ctx was allocated for
+ *
+ * Frees @ctx like crypto_*_free_ctx(). With CFG_CRYPTO_CTX_POOL=y @ctx may
+ * instead be wiped and handed out again by the next crypto_*_alloc_ctx()
+ * of @algo.
+ */
+void crypto_recycle_ctx(void *ctx, uint32_t algo);
+
 /* Informs crypto that the data in the buffer will be removed from storage */
 TEE_Result crypto_storage_obj_del(struct tee_obj *obj);
 
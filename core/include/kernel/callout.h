@@ -8,14 +8,16 @@
 
 #include <stdbool.h>
 #include <stdint.h>
-#include <sys/queue.h>
 
 /*
  * struct callout - callout reference
  * @callback:	  function to be called when a callout expires
  * @expiry_value: callout expiry time counter value
  * @period:	  ticks to next timeout
- * @link:	  linked list element
+ * @child:	  first child in the heap of pending callouts
+ * @sibling:	  next sibling in the heap of pending callouts
+ * @prev:	  previous sibling, or parent if first child, NULL if not
+ *		  pending or the first callout to expire
  *
  * @callback is called from an interrupt handler so thread resources must
  * not be used. The main callout service lock is held while @callback is
@@ -25,12 +27,17 @@
  * or false if the callout should be removed and inactivated. Returning
  * false from @callback is the equivalent of calling callout_rem() on the
  * callout reference.
+ *
+ * Pending callouts are kept in a pairing heap ordered by @expiry_value,
+ * @child, @sibling and @prev are only to be used by the callout service.
  */
 struct callout {
 	bool (*callback)(struct callout *co);
 	uint64_t expiry_value;
 	uint64_t period;
-	TAILQ_ENTRY(callout) link;
+	struct callout *child;
+	struct callout *sibling;
+	struct callout *prev;
 };
 
 /*
@@ -22,19 +22,25 @@
 #define ITR_CPU_MASK_TO_OTHER_CPUS	BIT(30)
 
 struct itr_handler;
+struct itr_irq;
+struct itr_irq_table;
 
 /*
  * struct itr_chip - Interrupt controller
  *
  * @ops Operation callback functions
  * @name Controller name, for debug purpose
- * @handlers Registered handlers list head
+ * @irq_table Table indexed by interrupt number of the interrupts below
+ * @irqs Interrupts with registered handlers, list head
+ * @link Reference in the list of initialized controllers
  * @dt_get_irq Device tree node parsing function
  */
 struct itr_chip {
 	const struct itr_ops *ops;
 	const char *name;
-	SLIST_HEAD(, itr_handler) handlers;
+	struct itr_irq_table *irq_table;
+	SLIST_HEAD(, itr_irq) irqs;
+	SLIST_ENTRY(itr_chip) link;
 	/*
 	 * dt_get_irq - parse a device tree interrupt property
 	 *
@@ -116,7 +122,7 @@ typedef enum itr_return (*itr_handler_t)(struct itr_handler *h);
  * @flags Property bit flags (ITRF_*) or 0
  * @data Private data for that interrupt handler
  * @chip Interrupt controller chip device
- * @link Reference in controller handler list
+ * @link Reference in the handler list of the interrupt
  */
 struct itr_handler {
 	size_t it;
@@ -545,4 +551,14 @@ static inline TEE_Result interrupt_dt_get(const void *fdt, int node,
 {
 	return interrupt_dt_get_by_index(fdt, node, 0, chip, itr_num);
 }
+
+#ifdef CFG_WITH_STATS
+/*
+ * interrupt_get_stats() - Get statistics of all interrupts with a
+ * registered handler
+ * @buf		Array of struct pta_stats_itr or NULL to query the size
+ * @buf_size	Size of @buf in bytes, updated with the needed size
+ */
+TEE_Result interrupt_get_stats(void *buf, size_t *buf_size);
+#endif
 #endif /*__KERNEL_INTERRUPT_H*/
@@ -60,6 +60,51 @@ msg_param_mobj_from_noncontig(paddr_t buf_ptr __unused, size_t size __unused,
 }
 #endif
 
+/**
+ * msg_param_mobj_from_sgmem() - construct mobj from a list of segments of
+ * registered shared memory
+ *
+ * @sgmem - optee_msg_param.u.sgmem
+ * @size - [out] size of the buffer, the sum of the segment sizes
+ * @seg_mobjs - [out] referenced registered shared memory of each segment,
+ *		to be released with msg_param_put_sgmem_segs() once the
+ *		returned mobj isn't used any longer
+ * @num_seg_mobjs - [out] number of entries in @seg_mobjs
+ *
+ * return:
+ *	mobj or NULL on error
+ */
+#ifdef CFG_CORE_SGMEM
+struct mobj *
+msg_param_mobj_from_sgmem(const struct optee_msg_param_sgmem *sgmem,
+			  size_t *size, struct mobj ***seg_mobjs,
+			  size_t *num_seg_mobjs);
+
+/**
+ * msg_param_put_sgmem_segs() - release the segments of a mobj constructed
+ * with msg_param_mobj_from_sgmem()
+ *
+ * @seg_mobjs - segments returned by msg_param_mobj_from_sgmem() or NULL
+ * @num_seg_mobjs - number of entries in @seg_mobjs
+ */
+void msg_param_put_sgmem_segs(struct mobj **seg_mobjs, size_t num_seg_mobjs);
+#else
+static inline struct mobj *
+msg_param_mobj_from_sgmem(const struct optee_msg_param_sgmem *sgmem __unused,
+			  size_t *size __unused,
+			  struct mobj ***seg_mobjs __unused,
+			  size_t *num_seg_mobjs __unused)
+{
+	return NULL;
+}
+
+static inline void
+msg_param_put_sgmem_segs(struct mobj **seg_mobjs __unused,
+			 size_t num_seg_mobjs __unused)
+{
+}
+#endif
+
 /**
  * msg_param_attr_is_tmem - helper functions that cheks if attribute is tmem
  *
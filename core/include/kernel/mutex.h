@@ -10,10 +10,30 @@
 #include <sys/queue.h>
 #include <types_ext.h>
 
+/*
+ * struct mutex_stats - contention counters of a mutex
+ * @locked:	Number of times the mutex has been locked for writing
+ * @contended:	Number of lock attempts which found the mutex held
+ * @spun:	Number of contended lock attempts which acquired the mutex
+ *		while spinning
+ * @slept:	Number of times a thread has waited in normal world for
+ *		the mutex
+ */
+struct mutex_stats {
+	unsigned int locked;
+	unsigned int contended;
+	unsigned int spun;
+	unsigned int slept;
+};
+
 struct mutex {
 	unsigned spin_lock;	/* used when operating on this struct */
 	struct wait_queue wq;
 	short state;		/* -1: write, 0: unlocked, > 0: readers */
+	short owner;		/* thread holding the write lock */
+#ifdef CFG_WITH_STATS
+	struct mutex_stats stats;
+#endif
 };
 
 #define MUTEX_INITIALIZER { .wq = WAIT_QUEUE_INITIALIZER }
@@ -126,5 +146,10 @@ static inline bool mutex_is_locked(struct mutex *m)
 {
 	return m->state == -1; /* write locked */
 }
+
+#ifdef CFG_WITH_STATS
+/* Returns a snapshot of the contention counters of @m */
+void mutex_get_stats(struct mutex *m, struct mutex_stats *stats);
+#endif
 #endif /*__KERNEL_MUTEX_H*/
 
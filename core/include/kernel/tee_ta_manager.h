@@ -27,6 +27,31 @@
 TAILQ_HEAD(tee_ta_session_head, tee_ta_session);
 TAILQ_HEAD(tee_ta_ctx_head, tee_ta_ctx);
 
+struct tee_ta_busy_waiter;
+TAILQ_HEAD(tee_ta_busy_waiter_head, tee_ta_busy_waiter);
+
+/*
+ * Priority classes of threads waiting for a busy TA context, a lower
+ * number is served first. Calls from other TAs or the core are favoured
+ * since the calling TA context is kept busy while waiting.
+ */
+#define TEE_TA_BUSY_PRIO_TA	0
+#define TEE_TA_BUSY_PRIO_REE	1
+
+#ifdef CFG_TA_BUSY_PRIO
+#define TEE_TA_BUSY_NUM_PRIO	2
+#else
+#define TEE_TA_BUSY_NUM_PRIO	1
+#endif
+
+struct tee_ta_busy_stats {
+	uint32_t queue_depth;		/* Threads currently waiting */
+	uint32_t max_queue_depth;	/* Most threads waiting at once */
+	uint32_t waits;			/* Number of waits */
+	uint32_t total_wait_ms;		/* Accumulated wait time */
+	uint32_t max_wait_ms;		/* Longest wait */
+};
+
 struct mobj;
 
 struct param_val {
@@ -34,10 +59,24 @@ struct param_val {
 	uint32_t b;
 };
 
+/*
+ * struct param_mem - memory reference parameter
+ * @mobj:	Memory object holding the buffer
+ * @size:	Size of the buffer
+ * @offs:	Offset of the buffer in @mobj
+ * @read_only:	Map the buffer read-only in a called user TA, set for
+ *		MEMREF_INPUT parameters in private memory of the calling TA
+ * @seg_mobjs:	Registered shared memory of the segments of a scatter-gather
+ *		parameter from normal world, referenced as long as @mobj
+ * @num_seg_mobjs: Number of entries in @seg_mobjs
+ */
 struct param_mem {
 	struct mobj *mobj;
 	size_t size;
 	size_t offs;
+	bool read_only;
+	struct mobj **seg_mobjs;
+	size_t num_seg_mobjs;
 };
 
 struct tee_ta_param {
@@ -75,11 +114,20 @@ struct tee_ta_ctx {
 	bool busy;		/* Context is busy and cannot be entered */
 	bool is_initializing;	/* Context initialization is not completed */
 	bool is_releasing;	/* Context is about to be released */
-	struct condvar busy_cv;	/* CV used when context is busy */
+	uint8_t busy_skips;	/* Grants passing over a lower class waiter */
+	struct mutex busy_mutex; /* Protects the busy state and waiters */
+	/* Threads waiting for the context to become available */
+	struct tee_ta_busy_waiter_head busy_waiters[TEE_TA_BUSY_NUM_PRIO];
+#ifdef CFG_WITH_STATS
+	struct tee_ta_busy_stats busy_stats;
+#endif
 };
 
 struct tee_ta_session {
 	TAILQ_ENTRY(tee_ta_session) link;
+	LIST_ENTRY(tee_ta_session) hash_link;
+	/* List the session is in, IDs are only unique within a list */
+	struct tee_ta_session_head *open_sessions;
 	struct ts_session ts_sess;
 	uint32_t id;		/* Session handle (0 is invalid) */
 	TEE_Identity clnt_id;	/* Identify of client */
@@ -99,8 +147,12 @@ struct tee_ta_session {
 extern struct tee_ta_ctx_head tee_ctxes;
 
 extern struct mutex tee_ta_mutex;
+extern struct mutex tee_ta_sess_mutex;
 extern struct condvar tee_ta_init_cv;
 
+/* Initialize the busy state of a new TA context */
+void tee_ta_ctx_init_busy(struct tee_ta_ctx *ctx);
+
 TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 			       struct tee_ta_session **sess,
 			       struct tee_ta_session_head *open_sessions,
@@ -173,4 +225,14 @@ static inline struct tee_ta_ctx *__noprof to_ta_ctx(struct ts_ctx *ctx)
 TEE_Result tee_ta_instance_stats(void *buff, size_t *buff_size);
 #endif
 
+#if defined(CFG_WITH_STATS)
+/*
+ * tee_ta_busy_stats() - Get wait queue statistics of all TA contexts
+ * which can't be entered concurrently
+ * @buff:	Array of struct pta_stats_ta_busy or NULL to query the size
+ * @buff_size:	Size of @buff in bytes, updated with the needed size
+ */
+TEE_Result tee_ta_busy_stats(void *buff, size_t *buff_size);
+#endif
+
 #endif
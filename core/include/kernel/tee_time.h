@@ -6,8 +6,12 @@
 #ifndef __KERNEL_TEE_TIME_H
 #define __KERNEL_TEE_TIME_H
 
+#include <compiler.h>
+#include <stddef.h>
 #include "tee_api_types.h"
 
+struct mobj;
+
 TEE_Result tee_time_get_sys_time(TEE_Time *time);
 uint32_t tee_time_get_sys_time_protection_level(void);
 TEE_Result tee_time_get_ta_time(const TEE_UUID *uuid, TEE_Time *time);
@@ -18,4 +22,26 @@ void tee_time_wait(uint32_t milliseconds_delay);
 /* Busy wait */
 void tee_time_busy_wait(uint32_t milliseconds_delay);
 
+#ifdef CFG_TA_TIME_PAGE
+/*
+ * Returns the mobj, offset and size of the read-only struct utee_time_page
+ * to map into user mode contexts
+ */
+void tee_time_page_get(struct mobj **mobj, size_t *offs, size_t *sz);
+/* Records a freshly fetched REE time in the time page */
+void tee_time_page_set_ree_time(const TEE_Time *time);
+#else
+static inline void tee_time_page_get(struct mobj **mobj, size_t *offs,
+				     size_t *sz)
+{
+	*mobj = NULL;
+	*offs = 0;
+	*sz = 0;
+}
+
+static inline void tee_time_page_set_ree_time(const TEE_Time *time __unused)
+{
+}
+#endif
+
 #endif
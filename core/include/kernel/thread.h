@@ -28,6 +28,21 @@
 
 #ifndef __ASSEMBLER__
 
+/*
+ * struct user_access_range - user mode range checked by
+ * vm_check_access_rights() during the current system call
+ * @uctx:	user mode context the range belongs to, NULL if unused
+ * @start:	start of the range
+ * @end:	end of the range, exclusive
+ * @flags:	TEE_MEMORY_ACCESS_* flags the range was checked with
+ */
+struct user_access_range {
+	const struct user_mode_ctx *uctx;
+	uaddr_t start;
+	uaddr_t end;
+	uint32_t flags;
+};
+
 struct thread_specific_data {
 	TAILQ_HEAD(, ts_session) sess_stack;
 	struct ts_ctx *ctx;
@@ -43,6 +58,10 @@ struct thread_specific_data {
 	bool stackcheck_recursion;
 #endif
 	unsigned int syscall_recursion;
+#ifdef CFG_USER_ACCESS_CACHE
+	struct user_access_range access_cache[CFG_USER_ACCESS_CACHE_ENTRIES];
+	unsigned int access_cache_next;
+#endif
 #ifdef CFG_FAULT_MITIGATION
 	struct ftmn_func_arg *ftmn_arg;
 #endif
@@ -106,6 +125,12 @@ short int thread_get_id(void);
  */
 short int thread_get_id_may_fail(void);
 
+/*
+ * Returns true if thread @thread_id is executing on a core. The state is
+ * read without locking so the result is only a hint.
+ */
+bool thread_is_active(short int thread_id);
+
 /* Returns Thread Specific Data (TSD) pointer. */
 struct thread_specific_data *thread_get_tsd(void);
 
@@ -337,6 +362,39 @@ struct thread_param {
 uint32_t thread_rpc_cmd(uint32_t cmd, size_t num_params,
 		struct thread_param *params);
 
+#ifdef CFG_RPC_BATCH
+/**
+ * Does an RPC which result isn't needed, possibly batched with others
+ * @cmd: RPC cmd
+ * @param: RPC parameter, THREAD_PARAM_ATTR_VALUE_IN with value.c 0
+ * @returns TEE_SUCCESS if queued, else RPC return value
+ *
+ * If normal world supports OPTEE_RPC_CMD_BATCH the RPC is queued and sent
+ * later with other queued RPCs. Queued RPCs are sent in order when the
+ * queue is full and at the latest before the next RPC of the thread, when
+ * the thread enters or returns to user mode or when the thread returns to
+ * normal world. That may take arbitrarily long, so RPCs another thread
+ * depends on, such as wakeups, must not be batched.
+ */
+uint32_t thread_rpc_cmd_batched(uint32_t cmd, struct thread_param *param);
+
+/**
+ * Sends the RPCs queued by thread_rpc_cmd_batched() by the current thread,
+ * one by one if the batch can't be sent
+ */
+void thread_rpc_flush(void);
+#else
+static inline uint32_t thread_rpc_cmd_batched(uint32_t cmd,
+					      struct thread_param *param)
+{
+	return thread_rpc_cmd(cmd, 1, param);
+}
+
+static inline void thread_rpc_flush(void)
+{
+}
+#endif
+
 /**
  * Allocate data for payload buffers shared with both user space applications
  * and the non-secure kernel. Ensure consistency with the enumeration
@@ -87,6 +87,40 @@ void thread_check_canaries(void);
 void thread_lock_global(void);
 void thread_unlock_global(void);
 
+/*
+ * thread_claim_id() - Claim a free thread context
+ *
+ * The free thread contexts are tracked in a bitmap updated with atomic
+ * operations so this doesn't need thread_lock_global(). The state of the
+ * claimed thread is left as THREAD_STATE_FREE, it's up to the caller to
+ * update it.
+ *
+ * Returns the ID of the claimed thread or THREAD_ID_INVALID if all
+ * threads are in use.
+ */
+short int thread_claim_id(void);
+
+/* Give back a thread context claimed with thread_claim_id() */
+void thread_release_id(short int thread_id);
+
+/*
+ * thread_alloc_stack() - Make sure a claimed thread has a stack
+ * @thread_id:	ID of the thread
+ *
+ * Only the first CFG_NUM_THREADS_PREALLOC threads have preallocated
+ * stacks, the stacks of the other threads are allocated from the heap
+ * when they are started.
+ *
+ * Returns true if the thread has a stack or false if out of memory.
+ */
+bool thread_alloc_stack(short int thread_id);
+
+/*
+ * Frees the stack allocated by thread_alloc_stack(), must not be called
+ * while executing on that stack
+ */
+void thread_free_stack(short int thread_id);
+
 /* Frees the cache of allocated FS RPC memory */
 void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache);
 #endif /*__ASSEMBLER__*/
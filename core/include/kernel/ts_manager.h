@@ -17,6 +17,7 @@ struct ts_ctx {
 };
 
 struct thread_scall_regs;
+struct thread_user_vfp_state;
 struct ts_session {
 	TAILQ_ENTRY(ts_session) link_tsd;
 	struct ts_ctx *ctx;	/* Generic TS context */
@@ -31,6 +32,13 @@ struct ts_session {
 	 * syscalls to store handlers of opened TA/SP binaries.
 	 */
 	void *user_ctx;
+#if defined(CFG_TA_CONCURRENT) && defined(CFG_WITH_VFP)
+	/*
+	 * VFP state of a concurrently executing invocation, NULL if the
+	 * state of the user mode context is used.
+	 */
+	struct thread_user_vfp_state *user_vfp;
+#endif
 	bool (*handle_scall)(struct thread_scall_regs *regs);
 };
 
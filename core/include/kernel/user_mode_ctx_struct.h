@@ -27,9 +27,12 @@
  *			stack trace
  * @is_32bit:		True if 32-bit TS, false if 64-bit TS
  * @stack_ptr:		Stack pointer
+ * @time_page_va:	User address of the read-only time page
  * @bbuf:		Bounce buffer for user buffers
  * @bbuf_size:		Size of bounce buffer
  * @bbuf_offs:		Offset to unused part of bounce buffer
+ * @pgt_retain:		Prefer keeping the translation tables of this context
+ *			in the shared cache while it's unmapped
  */
 struct user_mode_ctx {
 	struct vm_info vm_info;
@@ -52,9 +55,13 @@ struct user_mode_ctx {
 	uaddr_t ldelf_stack_ptr;
 	bool is_32bit;
 	vaddr_t stack_ptr;
+#ifdef CFG_TA_TIME_PAGE
+	uaddr_t time_page_va;
+#endif
 	uint8_t *bbuf;
 	size_t bbuf_size;
 	size_t bbuf_offs;
+	bool pgt_retain;
 };
 #endif /*__KERNEL_USER_MODE_CTX_STRUCT_H*/
 
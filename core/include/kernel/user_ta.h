@@ -19,25 +19,88 @@
 
 TAILQ_HEAD(tee_cryp_state_head, tee_cryp_state);
 TAILQ_HEAD(tee_obj_head, tee_obj);
+LIST_HEAD(tee_cryp_state_bucket, tee_cryp_state);
+LIST_HEAD(tee_obj_bucket, tee_obj);
 TAILQ_HEAD(tee_storage_enum_head, tee_storage_enum);
 SLIST_HEAD(load_seg_head, load_seg);
 
+struct user_ta_stack;
+
+#ifdef CFG_TA_CONCURRENT
+/*
+ * struct user_ta_stack - extra stack of a concurrently entered user TA
+ * @link:	Link in the list of free stacks
+ * @stack_ptr:	Initial stack pointer, that is, the top of the stack
+ * @vfp:	VFP state of the invocation using the stack
+ */
+struct user_ta_stack {
+	SLIST_ENTRY(user_ta_stack) link;
+	vaddr_t stack_ptr;
+#if defined(CFG_WITH_VFP)
+	struct thread_user_vfp_state vfp;
+#endif
+};
+
+SLIST_HEAD(user_ta_stack_head, user_ta_stack);
+#endif
+
+#define USER_TA_HANDLE_HASH_SIZE	BIT(CFG_TA_HANDLE_HASH_ORDER)
+
+/*
+ * Returns the hash bucket of a handle of a cryp state or storage object,
+ * the handle is the address of the kernel struct.
+ */
+static inline size_t user_ta_handle_hash(vaddr_t handle)
+{
+	/* Heap allocations are at least 8 bytes aligned */
+	return ((handle >> 3) ^ (handle >> (3 + CFG_TA_HANDLE_HASH_ORDER))) &
+	       (USER_TA_HANDLE_HASH_SIZE - 1);
+}
+
 /*
  * struct user_ta_ctx - user TA context
  * @open_sessions:	List of sessions opened by this TA
  * @cryp_states:	List of cryp states created by this TA
  * @objects:		List of storage objects opened by this TA
+ * @cryp_state_hash:	Cryp states hashed on their handle
+ * @obj_hash:		Storage objects hashed on their handle
  * @storage_enums:	List of storage enumerators opened by this TA
  * @uctx:		Generic user mode context
  * @ctx:		Generic TA context
+ *
+ * When the TA has TA_FLAG_CONCURRENT set and CFG_TA_CONCURRENT=y:
+ * @enter_mutex:	Protects the fields below up to @scall_mutex
+ * @enter_cv:		Signalled when an invocation leaves the TA
+ * @enter_count:	Number of invocations executing in the TA
+ * @excl_waiting:	Number of entries waiting to be alone in the TA
+ * @enter_excl:		True if an entry is alone in the TA
+ * @main_stack_busy:	True if the stack at @uctx.stack_ptr is in use
+ * @free_stacks:	Extra stacks not in use
+ * @num_stacks:		Number of allocated extra stacks
+ * @scall_mutex:	Serializes system calls and other updates of the
+ *			state of the TA instance, such as the bounce buffer
+ *			and the memory mappings
  */
 struct user_ta_ctx {
 	struct tee_ta_session_head open_sessions;
 	struct tee_cryp_state_head cryp_states;
 	struct tee_obj_head objects;
+	struct tee_cryp_state_bucket cryp_state_hash[USER_TA_HANDLE_HASH_SIZE];
+	struct tee_obj_bucket obj_hash[USER_TA_HANDLE_HASH_SIZE];
 	struct tee_storage_enum_head storage_enums;
 	struct user_mode_ctx uctx;
 	struct tee_ta_ctx ta_ctx;
+#ifdef CFG_TA_CONCURRENT
+	struct mutex enter_mutex;
+	struct condvar enter_cv;
+	unsigned int enter_count;
+	unsigned int excl_waiting;
+	bool enter_excl;
+	bool main_stack_busy;
+	struct user_ta_stack_head free_stacks;
+	size_t num_stacks;
+	struct mutex scall_mutex;
+#endif
 };
 
 #ifdef CFG_WITH_USER_TA
@@ -55,6 +118,29 @@ static inline struct user_ta_ctx *to_user_ta_ctx(struct ts_ctx *ctx)
 	return container_of(ctx, struct user_ta_ctx, ta_ctx.ts_ctx);
 }
 
+#ifdef CFG_TA_CONCURRENT
+/*
+ * Returns the mutex serializing the system calls of @ctx if it's a user
+ * TA which can be entered concurrently, else NULL.
+ */
+static inline struct mutex *user_ta_scall_mutex(struct ts_ctx *ctx)
+{
+	struct user_ta_ctx *utc = NULL;
+
+	if (!is_user_ta_ctx(ctx))
+		return NULL;
+	utc = to_user_ta_ctx(ctx);
+	if (!(utc->ta_ctx.flags & TA_FLAG_CONCURRENT))
+		return NULL;
+	return &utc->scall_mutex;
+}
+#else
+static inline struct mutex *user_ta_scall_mutex(struct ts_ctx *ctx __unused)
+{
+	return NULL;
+}
+#endif
+
 #ifdef CFG_WITH_USER_TA
 /*
  * Setup session context for a user TA
@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __KERNEL_WORKQUEUE_H
+#define __KERNEL_WORKQUEUE_H
+
+#include <kernel/callout.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/queue.h>
+#include <tee_api_types.h>
+
+/*
+ * Deferred work
+ *
+ * Interrupt handlers and callout callbacks execute in an atomic context
+ * where thread resources can't be used and where long processing delays
+ * other interrupts. A struct work lets such a context defer processing to
+ * a thread. The work is executed from the NOTIF_EVENT_DO_BOTTOM_HALF
+ * yielding notification of the guest the work was queued for.
+ *
+ * Work is queued on a per-CPU queue of the core queueing it, so cores
+ * queueing work in parallel don't contend on a common lock. The bottom
+ * half is only requested when the first work is queued since the last
+ * bottom half run, all work queued in the meantime is executed by that
+ * single run.
+ *
+ * A work is pending from when it's queued until its callback is about to
+ * be called. Queueing a pending work does nothing, but a work may be
+ * queued again, for instance by its own callback, once the callback has
+ * been called.
+ */
+
+/*
+ * struct work - deferred work
+ * @func:	function called in a yielding context to do the work
+ * @state:	0 if idle, else the CPU queue the work is pending on plus 1
+ * @guest_id:	guest which bottom half should execute the work
+ * @seq:	sequence number in the per-CPU queue
+ * @queued_cnt:	counter value when the work was queued
+ * @link:	link in the per-CPU queue
+ */
+struct work {
+	void (*func)(struct work *work);
+	unsigned int state;
+	uint16_t guest_id;
+	uint32_t seq;
+	uint64_t queued_cnt;
+	TAILQ_ENTRY(work) link;
+};
+
+/*
+ * struct delayed_work - deferred work queued after a delay
+ * @work:	the work
+ * @callout:	callout queueing @work when the delay has expired
+ * @armed:	true while @callout is active
+ */
+struct delayed_work {
+	struct work work;
+	struct callout callout;
+	unsigned int armed;
+};
+
+#ifdef CFG_CORE_WORKQUEUE
+/*
+ * work_init() - Initialize a work
+ * @work:	Work to initialize
+ * @func:	Function to be called when the work is executed
+ *
+ * @work must be in nexus memory and unpaged since it's accessed from
+ * interrupt handlers. @func is called from a thread and may be paged.
+ */
+void work_init(struct work *work, void (*func)(struct work *work));
+
+/*
+ * delayed_work_init() - Initialize a delayed work
+ * @dwork:	Delayed work to initialize
+ * @func:	Function to be called when the work is executed
+ */
+void delayed_work_init(struct delayed_work *dwork,
+		       void (*func)(struct work *work));
+
+/*
+ * work_queue() - Queue a work
+ * @work:	Work to queue
+ * @guest_id:	Guest to execute @work, ignored unless
+ *		CFG_NS_VIRTUALIZATION=y
+ *
+ * May be called from any context, including interrupt handlers and
+ * callout callbacks. The work is executed once normal world has started
+ * asynchronous notifications and serves the bottom half.
+ *
+ * Returns true if @work was queued or false if it was pending already.
+ */
+bool work_queue(struct work *work, uint16_t guest_id);
+
+/*
+ * work_queue_delayed() - Queue a work after a delay
+ * @dwork:	Delayed work to queue
+ * @guest_id:	Guest to execute the work
+ * @ms:		Delay in milliseconds
+ *
+ * Requires CFG_CALLOUT=y and must not be called from a callout callback.
+ * Calls to work_queue_delayed() and work_cancel_delayed() on the same
+ * @dwork must be serialized by the caller.
+ *
+ * Returns TEE_SUCCESS, TEE_ERROR_BUSY if @dwork is armed or pending
+ * already or TEE_ERROR_NOT_SUPPORTED if CFG_CALLOUT isn't enabled.
+ */
+TEE_Result work_queue_delayed(struct delayed_work *dwork, uint16_t guest_id,
+			      uint32_t ms);
+
+/*
+ * work_cancel() - Cancel a pending work
+ * @work:	Work to cancel
+ *
+ * Doesn't wait for a callback which already has been called to return.
+ *
+ * Returns true if @work was pending and has been removed from its queue,
+ * or false if it wasn't pending.
+ */
+bool work_cancel(struct work *work);
+
+/*
+ * work_cancel_delayed() - Cancel a delayed work
+ * @dwork:	Delayed work to cancel
+ *
+ * Must not be called from a callout callback.
+ *
+ * Returns true if @dwork was armed or pending and has been cancelled.
+ */
+bool work_cancel_delayed(struct delayed_work *dwork);
+#else
+static inline void work_init(struct work *work __unused,
+			     void (*func)(struct work *work) __unused)
+{
+}
+
+static inline void
+delayed_work_init(struct delayed_work *dwork __unused,
+		  void (*func)(struct work *work) __unused)
+{
+}
+
+static inline bool work_queue(struct work *work __unused,
+			      uint16_t guest_id __unused)
+{
+	return false;
+}
+
+static inline TEE_Result
+work_queue_delayed(struct delayed_work *dwork __unused,
+		   uint16_t guest_id __unused, uint32_t ms __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline bool work_cancel(struct work *work __unused)
+{
+	return false;
+}
+
+static inline bool work_cancel_delayed(struct delayed_work *dwork __unused)
+{
+	return false;
+}
+#endif
+
+/*
+ * struct workqueue_stats - workqueue statistics since boot
+ * @queued:		Number of times a work was queued
+ * @executed:		Number of work callbacks called
+ * @cancelled:		Number of pending works cancelled
+ * @bh_requests:	Number of bottom halves requested
+ * @bh_runs:		Number of bottom halves executing work
+ * @pending:		Number of currently pending works
+ * @max_latency_us:	Longest time from queueing to execution
+ * @total_latency_us:	Accumulated time from queueing to execution
+ *
+ * Latencies are only measured if CFG_CORE_HAS_GENERIC_TIMER=y.
+ */
+struct workqueue_stats {
+	uint32_t queued;
+	uint32_t executed;
+	uint32_t cancelled;
+	uint32_t bh_requests;
+	uint32_t bh_runs;
+	uint32_t pending;
+	uint32_t max_latency_us;
+	uint64_t total_latency_us;
+};
+
+#ifdef CFG_CORE_WORKQUEUE
+void workqueue_get_stats(struct workqueue_stats *stats);
+#else
+static inline void workqueue_get_stats(struct workqueue_stats *stats)
+{
+	*stats = (struct workqueue_stats){ };
+}
+#endif
+
+#endif /*__KERNEL_WORKQUEUE_H*/
@@ -72,6 +72,32 @@ struct fobj *fobj_locked_paged_alloc(unsigned int num_pages);
  */
 struct fobj *fobj_rw_paged_alloc(unsigned int num_pages);
 
+/*
+ * struct fobj_compr_stats - statistics of the compressed R/W page store
+ * @pages:	Number of pages saved in the store
+ * @bytes:	Number of bytes used by those pages
+ * @pool_size:	Size in bytes of the memory backing the store
+ * @loads:	Compressed pages loaded since last stats dump
+ * @load_us:	Time in microseconds spent decompressing pages since last
+ *		stats dump
+ */
+struct fobj_compr_stats {
+	size_t pages;
+	size_t bytes;
+	size_t pool_size;
+	size_t loads;
+	size_t load_us;
+};
+
+#if defined(CFG_CORE_RWP_COMPRESS) && defined(CFG_WITH_STATS)
+void fobj_get_compr_stats(struct fobj_compr_stats *stats);
+#else
+static inline void fobj_get_compr_stats(struct fobj_compr_stats *stats)
+{
+	*stats = (struct fobj_compr_stats){ };
+}
+#endif
+
 /*
  * fobj_ro_paged_alloc() - Allocate initialized read-only storage
  * @num_pages:	Number of pages covered
@@ -26,6 +26,7 @@ struct pgt {
 	vaddr_t vabase;
 #if !defined(CFG_CORE_PREALLOC_EL0_TBLS)
 	struct ts_ctx *ctx;
+	bool retain;
 #endif
 	bool populated;
 #if defined(CFG_PAGED_USER_TA)
@@ -36,11 +37,32 @@ struct pgt {
 	struct pgt_parent *parent;
 #endif
 	SLIST_ENTRY(pgt) link;
+#if !defined(CFG_CORE_PREALLOC_EL0_TBLS)
+	TAILQ_ENTRY(pgt) lru_link;
+#endif
 };
 
 SLIST_HEAD(pgt_cache, pgt);
 struct user_mode_ctx;
 
+/*
+ * struct pgt_cache_stats - statistics on the shared translation table cache
+ * @hits:	Tables found in the cache when a context was mapped again
+ * @misses:	Tables which had to be taken from the free list or evicted
+ * @evictions:	Tables evicted from the cache to serve another context
+ * @cached:	Number of tables currently in the cache
+ * @size:	Total number of translation tables
+ *
+ * The counters are reset each time they are retrieved.
+ */
+struct pgt_cache_stats {
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+	size_t cached;
+	size_t size;
+};
+
 bool pgt_check_avail(struct user_mode_ctx *uctx);
 
 /*
@@ -82,8 +104,13 @@ void pgt_push_to_cache_list(struct pgt *pgt);
 
 #if defined(CFG_CORE_PREALLOC_EL0_TBLS)
 static inline void pgt_init(void) { }
+static inline void pgt_get_cache_stats(struct pgt_cache_stats *stats)
+{
+	*stats = (struct pgt_cache_stats){ };
+}
 #else
 void pgt_init(void);
+void pgt_get_cache_stats(struct pgt_cache_stats *stats);
 #endif
 
 void pgt_flush(struct user_mode_ctx *uctx);
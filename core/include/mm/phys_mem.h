@@ -20,6 +20,8 @@ tee_mm_entry_t *nex_phys_mem_alloc2(paddr_t base, size_t size);
 void nex_phys_mem_partial_carve_out(paddr_t base, size_t size);
 #ifdef CFG_WITH_STATS
 void nex_phys_mem_stats(struct pta_stats_alloc *stats, bool reset);
+/* Fragmentation of the pools, all zero unless CFG_CORE_PHYS_MEM_BUDDY=y */
+void nex_phys_mem_frag_stats(struct pta_stats_phys_mem *stats);
 #endif
 
 #ifdef CFG_NS_VIRTUALIZATION
@@ -31,6 +33,7 @@ tee_mm_entry_t *phys_mem_ta_alloc(size_t size);
 tee_mm_entry_t *phys_mem_alloc2(paddr_t base, size_t size);
 #ifdef CFG_WITH_STATS
 void phys_mem_stats(struct pta_stats_alloc *stats, bool reset);
+void phys_mem_frag_stats(struct pta_stats_phys_mem *stats);
 #endif
 #else
 static inline void phys_mem_init(paddr_t core_base, paddr_size_t core_size,
@@ -64,6 +67,11 @@ static inline void phys_mem_stats(struct pta_stats_alloc *stats, bool reset)
 {
 	return nex_phys_mem_stats(stats, reset);
 }
+
+static inline void phys_mem_frag_stats(struct pta_stats_phys_mem *stats)
+{
+	nex_phys_mem_frag_stats(stats);
+}
 #endif
 #endif
 
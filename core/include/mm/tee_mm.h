@@ -17,6 +17,8 @@
 /* Flag to indicate that pool should use nex_malloc instead of malloc */
 #define TEE_MM_POOL_NEX_MALLOC          MAF_NEX
 
+struct tee_mm_buddy;
+
 struct _tee_mm_entry_t {
 	struct _tee_mm_pool_t *pool;
 	struct _tee_mm_entry_t *next;
@@ -35,6 +37,9 @@ struct _tee_mm_pool_t {
 #ifdef CFG_WITH_STATS
 	size_t max_allocated;
 #endif
+#ifdef CFG_CORE_PHYS_MEM_BUDDY
+	struct tee_mm_buddy *buddy;	/* Buddy allocator placing entries */
+#endif
 };
 typedef struct _tee_mm_pool_t tee_mm_pool_t;
 
@@ -65,6 +70,20 @@ uintptr_t tee_mm_get_smem(const tee_mm_entry_t *mm);
 bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_size_t size,
 		 uint8_t shift, uint32_t flags);
 
+/*
+ * Let a buddy allocator decide where to place the allocations of an empty
+ * pool to limit fragmentation. Pools allocating from high addresses are
+ * not supported.
+ */
+#ifdef CFG_CORE_PHYS_MEM_BUDDY
+bool tee_mm_enable_buddy(tee_mm_pool_t *pool);
+#else
+static inline bool tee_mm_enable_buddy(tee_mm_pool_t *pool __unused)
+{
+	return false;
+}
+#endif
+
 /* Kill managed memory area*/
 void tee_mm_final(tee_mm_pool_t *pool);
 
@@ -112,6 +131,9 @@ bool tee_mm_is_empty(tee_mm_pool_t *pool);
 #ifdef CFG_WITH_STATS
 void tee_mm_get_pool_stats(tee_mm_pool_t *pool, struct pta_stats_alloc *stats,
 			   bool reset);
+/* Adds the buddy allocator state of the pool, if any, to @stats */
+void tee_mm_get_buddy_stats(tee_mm_pool_t *pool,
+			    struct pta_stats_phys_mem *stats);
 #endif
 
 #endif
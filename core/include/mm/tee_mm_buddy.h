@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#ifndef __MM_TEE_MM_BUDDY_H
+#define __MM_TEE_MM_BUDDY_H
+
+#include <pta_stats.h>
+#include <types_ext.h>
+
+/*
+ * Binary buddy allocator used by tee_mm pools to decide where to place
+ * allocations.
+ *
+ * All offsets and sizes are expressed in units, that is, in pages or
+ * sections of the tee_mm pool using it. Free memory is tracked with one
+ * bitmap per order where a set bit means that the naturally aligned block
+ * of 2^order units is free and isn't part of a larger free block. A
+ * separate bitmap tracks allocated units.
+ *
+ * An allocation of n units takes the smallest free block of at least n
+ * units, splitting larger blocks as needed, and gives back the unused
+ * tail right away so the allocated size is exact. Freed units are
+ * coalesced with their free buddies. If no single free block is large
+ * enough the allocator falls back on first-fit of the allocated bitmap,
+ * so it never fails where a linear allocator would have succeeded.
+ *
+ * The caller is responsible for serializing calls, tee_mm does that with
+ * the pool spinlock.
+ */
+
+struct tee_mm_buddy;
+
+#ifdef CFG_CORE_PHYS_MEM_BUDDY
+/*
+ * tee_mm_buddy_init() - Allocate a buddy allocator with all units free
+ * @nunits:	Number of units to manage
+ * @flags:	MAF_* flags passed on to malloc_flags()
+ *
+ * Returns a buddy allocator on success or NULL if out of memory.
+ */
+struct tee_mm_buddy *tee_mm_buddy_init(uint32_t nunits, uint32_t flags);
+
+/* Free a buddy allocator returned by tee_mm_buddy_init() */
+void tee_mm_buddy_final(struct tee_mm_buddy *b);
+
+/*
+ * tee_mm_buddy_alloc() - Allocate a range of units
+ * @b:		Buddy allocator
+ * @n:		Number of units to allocate
+ * @offs:	Returned offset of the first allocated unit
+ *
+ * Returns true on success or false if there's no free range of @n units.
+ */
+bool tee_mm_buddy_alloc(struct tee_mm_buddy *b, uint32_t n, uint32_t *offs);
+
+/*
+ * tee_mm_buddy_alloc_range() - Allocate a specific range of units
+ * @b:		Buddy allocator
+ * @offs:	Offset of first unit
+ * @n:		Number of units
+ *
+ * Returns true on success or false if some unit in the range is
+ * allocated already or the range is out of bounds.
+ */
+bool tee_mm_buddy_alloc_range(struct tee_mm_buddy *b, uint32_t offs,
+			      uint32_t n);
+
+/*
+ * tee_mm_buddy_free() - Free a range of units
+ * @b:		Buddy allocator
+ * @offs:	Offset of first unit
+ * @n:		Number of units
+ *
+ * Panics if some unit in the range isn't allocated.
+ */
+void tee_mm_buddy_free(struct tee_mm_buddy *b, uint32_t offs, uint32_t n);
+
+/*
+ * tee_mm_buddy_get_stats() - Accumulate statistics
+ * @b:		Buddy allocator
+ * @stats:	Statistics to add the state of @b to
+ *
+ * Free units and free blocks per order are added to @stats, the largest
+ * free order is updated if larger. The fragmentation index is left
+ * untouched, it's up to the caller to compute it once all allocators
+ * have been accounted for.
+ */
+void tee_mm_buddy_get_stats(struct tee_mm_buddy *b,
+			    struct pta_stats_phys_mem *stats);
+#else
+static inline struct tee_mm_buddy *
+tee_mm_buddy_init(uint32_t nunits __unused, uint32_t flags __unused)
+{
+	return NULL;
+}
+
+static inline void tee_mm_buddy_final(struct tee_mm_buddy *b __unused)
+{
+}
+
+static inline bool tee_mm_buddy_alloc(struct tee_mm_buddy *b __unused,
+				      uint32_t n __unused,
+				      uint32_t *offs __unused)
+{
+	return false;
+}
+
+static inline bool tee_mm_buddy_alloc_range(struct tee_mm_buddy *b __unused,
+					    uint32_t offs __unused,
+					    uint32_t n __unused)
+{
+	return false;
+}
+
+static inline void tee_mm_buddy_free(struct tee_mm_buddy *b __unused,
+				     uint32_t offs __unused,
+				     uint32_t n __unused)
+{
+}
+
+static inline void
+tee_mm_buddy_get_stats(struct tee_mm_buddy *b __unused,
+		       struct pta_stats_phys_mem *stats __unused)
+{
+}
+#endif
+
+#endif /*__MM_TEE_MM_BUDDY_H*/
@@ -120,6 +120,8 @@ struct vm_paged_region {
 	vaddr_t base;
 	size_t size;
 	struct pgt **pgt_array;
+	vaddr_t ra_next_va;		/* Next fault address if sequential */
+	unsigned int ra_window;		/* Pages read ahead on last fault */
 	TAILQ_ENTRY(vm_paged_region) link;
 	TAILQ_ENTRY(vm_paged_region) fobj_link;
 };
@@ -263,10 +263,33 @@ struct tee_pager_stats {
 	size_t zi_released;
 	size_t npages;		/* number of load pages */
 	size_t npages_all;	/* number of pages */
+	size_t ra_pages;	/* pages populated by read-ahead */
+	size_t ra_window_max;	/* most pages read ahead by a single fault */
+	size_t policy;		/* STATS_PAGER_POLICY_* replacement policy */
+	size_t evictions;	/* pages in use reclaimed for another page */
+	size_t pages_hidden;	/* pages hidden to sample references */
+	size_t compr_pages;	/* pages in the compressed R/W store */
+	size_t compr_bytes;	/* bytes used by compressed pages */
+	size_t compr_pool_size;	/* bytes backing the compressed store */
+	size_t compr_loads;	/* compressed pages loaded */
+	size_t compr_load_us;	/* time spent decompressing */
+};
+
+/*
+ * Statistics on the pager page replacement policy, these counters are
+ * separate from those in struct tee_pager_stats and only reset by
+ * tee_pager_get_policy_stats()
+ */
+struct tee_pager_policy_stats {
+	size_t policy;		/* STATS_PAGER_POLICY_* replacement policy */
+	size_t evictions;	/* pages in use reclaimed for another page */
+	size_t pages_hidden;	/* pages hidden to sample references */
+	size_t hidden_hits;	/* faults on hidden pages */
 };
 
 #ifdef CFG_WITH_PAGER
 void tee_pager_get_stats(struct tee_pager_stats *stats);
+void tee_pager_get_policy_stats(struct tee_pager_policy_stats *stats);
 bool tee_pager_handle_fault(struct abort_info *ai);
 #else /*CFG_WITH_PAGER*/
 static inline bool tee_pager_handle_fault(struct abort_info *ai __unused)
@@ -278,6 +301,12 @@ static inline void tee_pager_get_stats(struct tee_pager_stats *stats)
 {
 	memset(stats, 0, sizeof(struct tee_pager_stats));
 }
+
+static inline void
+tee_pager_get_policy_stats(struct tee_pager_policy_stats *stats)
+{
+	memset(stats, 0, sizeof(struct tee_pager_policy_stats));
+}
 #endif /*CFG_WITH_PAGER*/
 
 void tee_pager_invalidate_fobj(struct fobj *fobj);
@@ -88,10 +88,29 @@ void *vm_pa2va(const struct user_mode_ctx *uctx, paddr_t pa, size_t pa_size);
 /*
  * Return TEE_SUCCESS or TEE_ERROR_ACCESS_DENIED when buffer exists or return
  * another TEE_Result code.
+ *
+ * With CFG_USER_ACCESS_CACHE=y successfully checked ranges are remembered
+ * by the thread until vm_access_cache_reset() is called, so checking the
+ * same range or a part of it again in the same system call is cheap.
  */
 TEE_Result vm_check_access_rights(const struct user_mode_ctx *uctx,
 				  uint32_t flags, uaddr_t uaddr, size_t len);
 
+/*
+ * Forget the ranges checked by vm_check_access_rights() in this thread.
+ * Called when a system call is entered and left, and when a mapping of a
+ * user mode context is removed or changed. Other threads aren't affected,
+ * so it's also called when a thread releases or takes again the system
+ * call mutex of a concurrent TA, see CFG_TA_CONCURRENT.
+ */
+#ifdef CFG_USER_ACCESS_CACHE
+void vm_access_cache_reset(void);
+#else
+static inline void vm_access_cache_reset(void)
+{
+}
+#endif
+
 /* Set user context @ctx or core privileged context if @ctx is NULL */
 void vm_set_ctx(struct ts_ctx *ctx);
 
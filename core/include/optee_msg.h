@@ -31,6 +31,9 @@
 #define OPTEE_MSG_ATTR_TYPE_TMEM_INPUT		U(0x9)
 #define OPTEE_MSG_ATTR_TYPE_TMEM_OUTPUT		U(0xa)
 #define OPTEE_MSG_ATTR_TYPE_TMEM_INOUT		U(0xb)
+#define OPTEE_MSG_ATTR_TYPE_SGMEM_INPUT		U(0xd)
+#define OPTEE_MSG_ATTR_TYPE_SGMEM_OUTPUT	U(0xe)
+#define OPTEE_MSG_ATTR_TYPE_SGMEM_INOUT		U(0xf)
 
 #define OPTEE_MSG_ATTR_TYPE_MASK		GENMASK_32(7, 0)
 
@@ -147,6 +150,37 @@ struct optee_msg_param_fmem {
 	uint64_t global_id;
 };
 
+/**
+ * struct optee_msg_param_sgmem - scatter-gather memory reference parameter
+ * @offs:	Offset of the segment list into @shm_ref
+ * @num_segs:	Number of struct optee_msg_sgmem_seg in the segment list
+ * @size:	Size of the buffer, must be the sum of the segment sizes
+ * @shm_ref:	Shared memory reference holding the segment list
+ *
+ * The segments are passed to the Trusted Application as one virtually
+ * contiguous buffer. All segments but the first must start on a
+ * OPTEE_MSG_NONCONTIG_PAGE_SIZE boundary and all but the last must end on
+ * one. Only used if secure world announces OPTEE_SMC_SEC_CAP_SGMEM.
+ */
+struct optee_msg_param_sgmem {
+	uint32_t offs;
+	uint32_t num_segs;
+	uint64_t size;
+	uint64_t shm_ref;
+};
+
+/**
+ * struct optee_msg_sgmem_seg - segment of a scatter-gather memory reference
+ * @shm_ref:	Registered shared memory reference holding the segment
+ * @offs:	Offset of the segment into @shm_ref
+ * @size:	Size of the segment
+ */
+struct optee_msg_sgmem_seg {
+	uint64_t shm_ref;
+	uint64_t offs;
+	uint64_t size;
+};
+
 /**
  * struct optee_msg_param_value - opaque value parameter
  *
@@ -164,13 +198,15 @@ struct optee_msg_param_value {
  * @tmem:	parameter by temporary memory reference
  * @rmem:	parameter by registered memory reference
  * @fmem:	parameter by FF-A registered memory reference
+ * @sgmem:	parameter by scatter-gather memory reference
  * @value:	parameter by opaque value
  *
  * @attr & OPTEE_MSG_ATTR_TYPE_MASK indicates if tmem, rmem or value is used in
  * the union. OPTEE_MSG_ATTR_TYPE_VALUE_* indicates value,
  * OPTEE_MSG_ATTR_TYPE_TMEM_* indicates @tmem and
  * OPTEE_MSG_ATTR_TYPE_RMEM_* or the alias PTEE_MSG_ATTR_TYPE_FMEM_* indicates
- * @rmem or @fmem depending on the conduit.
+ * @rmem or @fmem depending on the conduit. OPTEE_MSG_ATTR_TYPE_SGMEM_*
+ * indicates @sgmem.
  * OPTEE_MSG_ATTR_TYPE_NONE indicates that none of the members are used.
  */
 struct optee_msg_param {
@@ -179,6 +215,7 @@ struct optee_msg_param {
 		struct optee_msg_param_tmem tmem;
 		struct optee_msg_param_rmem rmem;
 		struct optee_msg_param_fmem fmem;
+		struct optee_msg_param_sgmem sgmem;
 		struct optee_msg_param_value value;
 	} u;
 };
@@ -218,6 +218,22 @@
  */
 #define OPTEE_RPC_CMD_RPMB_FRAMES	U(24)
 
+/*
+ * Execute a batch of RPC commands
+ *
+ * Only sent if normal world has announced OPTEE_SMC_NSEC_CAP_RPC_BATCH.
+ * Each parameter is a command which only has a single value input
+ * parameter with value[0].c set to 0, currently only
+ * OPTEE_RPC_CMD_SHM_FREE. The commands are to be executed in order, a
+ * failing command doesn't stop the following commands from being
+ * executed.
+ *
+ * [in]     value[n].a	    Command
+ * [in]     value[n].b	    value[0].a of the command
+ * [in]     value[n].c	    value[0].b of the command
+ */
+#define OPTEE_RPC_CMD_BATCH		U(25)
+
 /*
  * Definition of protocol for command OPTEE_RPC_CMD_FS
  */
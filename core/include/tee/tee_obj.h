@@ -15,6 +15,7 @@
 
 struct tee_obj {
 	TAILQ_ENTRY(tee_obj) link;
+	LIST_ENTRY(tee_obj) hash_link;	/* in user_ta_ctx::obj_hash */
 	TEE_ObjectInfo info;
 	bool busy;		/* true if used by an operation */
 	uint32_t have_attrs;	/* bitfield identifying set properties */
@@ -72,6 +72,7 @@ TEE_Result syscall_mask_cancellation(uint32_t *old_mask);
 TEE_Result syscall_wait(unsigned long timeout);
 
 TEE_Result syscall_get_time(unsigned long cat, TEE_Time *time);
+TEE_Result syscall_get_time_page(uint64_t *va);
 TEE_Result syscall_set_ta_time(const TEE_Time *time);
 
 #endif /* __TEE_TEE_SVC_H */
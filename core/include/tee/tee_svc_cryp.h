@@ -73,6 +73,11 @@ TEE_Result syscall_authenc_dec_final(unsigned long state,
 			const void *src_data, size_t src_len, void *dest_data,
 			uint64_t *dest_len, const void *tag, size_t tag_len);
 
+TEE_Result syscall_cryp_oneshot(unsigned long state,
+			struct utee_cryp_oneshot *usr_args);
+TEE_Result syscall_cryp_update_vec(unsigned long state,
+			struct utee_cryp_iov *usr_iov, size_t iov_cnt);
+
 TEE_Result syscall_asymm_operate(unsigned long state,
 			const struct utee_attribute *usr_params,
 			size_t num_params, const void *src_data,
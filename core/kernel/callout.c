@@ -7,37 +7,167 @@
 #include <kernel/misc.h>
 #include <kernel/spinlock.h>
 #include <mm/core_memprot.h>
-
-TAILQ_HEAD(callout_head, callout);
+#include <util.h>
 
 static unsigned int callout_sched_lock __nex_data = SPINLOCK_UNLOCK;
 static size_t callout_sched_core __nex_bss;
 static unsigned int callout_lock __nex_data = SPINLOCK_UNLOCK;
 static const struct callout_timer_desc *callout_desc __nex_bss;
-static struct callout_head callout_head __nex_data =
-	TAILQ_HEAD_INITIALIZER(callout_head);
+/* Root of the pairing heap of pending callouts, the first to expire */
+static struct callout *callout_root __nex_bss;
+static uint64_t callout_slack __nex_bss;
+
+/*
+ * Pending callouts are kept in a pairing heap. Insertion is O(1), removal
+ * of the first or of any other callout is O(log N) amortized. Each callout
+ * has a pointer to its first child, its next sibling and either its
+ * previous sibling or, for a first child, its parent. This is enough to
+ * unlink a callout in constant time and avoids any memory allocation
+ * while holding the callout lock.
+ */
+
+static struct callout *heap_meld(struct callout *a, struct callout *b)
+{
+	struct callout *t = NULL;
+
+	if (!a)
+		return b;
+	if (!b)
+		return a;
+
+	if (b->expiry_value < a->expiry_value) {
+		t = a;
+		a = b;
+		b = t;
+	}
+
+	/* b becomes the first child of a */
+	b->sibling = a->child;
+	if (b->sibling)
+		b->sibling->prev = b;
+	b->prev = a;
+	a->child = b;
+
+	return a;
+}
+
+/* Standard two-pass pairing of a list of siblings into a single heap */
+static struct callout *heap_merge_pairs(struct callout *first)
+{
+	struct callout *pairs = NULL;
+	struct callout *res = NULL;
+	struct callout *next = NULL;
+	struct callout *a = NULL;
+	struct callout *b = NULL;
+
+	/* Meld siblings pairwise left to right, stack the results */
+	while (first) {
+		a = first;
+		b = a->sibling;
+		next = NULL;
+		a->sibling = NULL;
+		a->prev = NULL;
+		if (b) {
+			next = b->sibling;
+			b->sibling = NULL;
+			b->prev = NULL;
+		}
+		a = heap_meld(a, b);
+		a->sibling = pairs;
+		pairs = a;
+		first = next;
+	}
+
+	/* Meld the stacked pairs right to left */
+	while (pairs) {
+		a = pairs;
+		pairs = a->sibling;
+		a->sibling = NULL;
+		res = heap_meld(res, a);
+	}
+
+	return res;
+}
 
 static void insert_callout(struct callout *co)
 {
-	struct callout *co2 = NULL;
+	co->child = NULL;
+	co->sibling = NULL;
+	co->prev = NULL;
+	callout_root = heap_meld(callout_root, co);
+}
 
-	TAILQ_FOREACH(co2, &callout_head, link) {
-		if (co->expiry_value < co2->expiry_value) {
-			TAILQ_INSERT_BEFORE(co2, co, link);
-			return;
+static void remove_callout(struct callout *co)
+{
+	struct callout *sub = heap_merge_pairs(co->child);
+
+	if (co == callout_root) {
+		callout_root = sub;
+	} else {
+		if (co->prev->child == co)
+			co->prev->child = co->sibling;
+		else
+			co->prev->sibling = co->sibling;
+		if (co->sibling)
+			co->sibling->prev = co->prev;
+		callout_root = heap_meld(callout_root, sub);
+	}
+
+	co->child = NULL;
+	co->sibling = NULL;
+	co->prev = NULL;
+}
+
+/* Next node in a pre-order walk of the heap not entering @co's children */
+static struct callout *heap_next_skip_children(struct callout *co)
+{
+	while (co != callout_root) {
+		if (co->sibling)
+			return co->sibling;
+		/* Go back to the first sibling, its prev is the parent */
+		while (co->prev->child != co)
+			co = co->prev;
+		co = co->prev;
+	}
+
+	return NULL;
+}
+
+/*
+ * Returns the time for the next timer interrupt. That's the first expiry
+ * value, possibly delayed up to callout_slack ticks to also cover the
+ * latest callout expiring within that window. Only callouts inside the
+ * window are visited since children never expire before their parent.
+ */
+static uint64_t get_next_timeout(void)
+{
+	uint64_t limit = callout_root->expiry_value + callout_slack;
+	uint64_t next = callout_root->expiry_value;
+	struct callout *co = callout_root;
+
+	if (!callout_slack)
+		return next;
+
+	while (co) {
+		if (co->expiry_value <= limit) {
+			next = MAX(next, co->expiry_value);
+			if (co->child) {
+				co = co->child;
+				continue;
+			}
 		}
+		co = heap_next_skip_children(co);
 	}
 
-	TAILQ_INSERT_TAIL(&callout_head, co, link);
+	return next;
 }
 
 static void schedule_next_timeout(void)
 {
 	const struct callout_timer_desc *desc = callout_desc;
-	struct callout *co = TAILQ_FIRST(&callout_head);
 
-	if (co)
-		desc->set_next_timeout(desc, co->expiry_value);
+	if (callout_root)
+		desc->set_next_timeout(desc, get_next_timeout());
 	else
 		desc->disable_timeout(desc);
 
@@ -55,13 +185,7 @@ static void schedule_next_timeout(void)
 
 static bool callout_is_active(struct callout *co)
 {
-	struct callout *co2 = NULL;
-
-	TAILQ_FOREACH(co2, &callout_head, link)
-		if (co2 == co)
-			return true;
-
-	return false;
+	return co->prev || co == callout_root;
 }
 
 void callout_rem(struct callout *co)
@@ -71,7 +195,7 @@ void callout_rem(struct callout *co)
 	state = cpu_spin_lock_xsave(&callout_lock);
 
 	if (callout_is_active(co)) {
-		TAILQ_REMOVE(&callout_head, co, link);
+		remove_callout(co);
 		schedule_next_timeout();
 	}
 
@@ -98,7 +222,7 @@ void callout_add(struct callout *co, bool (*callback)(struct callout *co),
 	}
 
 	insert_callout(co);
-	if (desc && co == TAILQ_FIRST(&callout_head))
+	if (desc && co == callout_root)
 		schedule_next_timeout();
 
 	cpu_spin_unlock_xrestore(&callout_lock, state);
@@ -111,7 +235,7 @@ void callout_set_next_timeout(struct callout *co, uint32_t ms)
 
 void callout_service_init(const struct callout_timer_desc *desc)
 {
-	struct callout_head tmp_head = TAILQ_HEAD_INITIALIZER(tmp_head);
+	struct callout *pending = NULL;
 	struct callout *co = NULL;
 	uint32_t state = 0;
 	uint64_t now = 0;
@@ -124,12 +248,20 @@ void callout_service_init(const struct callout_timer_desc *desc)
 	       is_unpaged(desc->ms_to_ticks) && is_unpaged(desc->get_now));
 
 	callout_desc = desc;
+	callout_slack = desc->ms_to_ticks(desc, CFG_CALLOUT_SLACK_MS);
 	now = desc->get_now(desc);
 
-	TAILQ_CONCAT(&tmp_head, &callout_head, link);
-	while (!TAILQ_EMPTY(&tmp_head)) {
-		co = TAILQ_FIRST(&tmp_head);
-		TAILQ_REMOVE(&tmp_head, co, link);
+	/* Move all pending callouts to a temporary list linked by @sibling */
+	while (callout_root) {
+		co = callout_root;
+		remove_callout(co);
+		co->sibling = pending;
+		pending = co;
+	}
+
+	while (pending) {
+		co = pending;
+		pending = co->sibling;
 
 		/*
 		 * Periods set before the timer descriptor are in
@@ -173,12 +305,12 @@ void callout_service_cb(void)
 	cpu_spin_lock(&callout_lock);
 
 	now = desc->get_now(desc);
-	while (!TAILQ_EMPTY(&callout_head)) {
-		co = TAILQ_FIRST(&callout_head);
+	while (callout_root) {
+		co = callout_root;
 		if (co->expiry_value > now)
 			break;
 
-		TAILQ_REMOVE(&callout_head, co, link);
+		remove_callout(co);
 
 		if (co->callback(co)) {
 			co->expiry_value += co->period;
@@ -3,12 +3,17 @@
  * Copyright (c) 2016-2019, Linaro Limited
  */
 
+#include <atomic.h>
+#include <kernel/delay.h>
 #include <kernel/dt.h>
 #include <kernel/interrupt.h>
 #include <kernel/panic.h>
 #include <libfdt.h>
+#include <malloc.h>
 #include <mm/core_memprot.h>
+#include <pta_stats.h>
 #include <stdlib.h>
+#include <string_ext.h>
 #include <trace.h>
 #include <assert.h>
 
@@ -20,7 +25,50 @@
  * we begin to modify settings after boot initialization.
  */
 
+/*
+ * Interrupt numbers below ITR_TABLE_NUM_IRQS are looked up in a two level
+ * table, allocated as interrupts get handlers. This covers SGIs, PPIs,
+ * SPIs and extended SPIs of a GIC, and all interrupts of the other
+ * controllers. Larger interrupt numbers are rare and are only found in
+ * the list of interrupts of the chip.
+ */
+#define ITR_TABLE_LEAF_SHIFT	6
+#define ITR_TABLE_LEAF_SIZE	BIT(ITR_TABLE_LEAF_SHIFT)
+#define ITR_TABLE_ROOT_SIZE	128
+#define ITR_TABLE_NUM_IRQS	(ITR_TABLE_ROOT_SIZE * ITR_TABLE_LEAF_SIZE)
+
+struct itr_irq_table {
+	struct itr_irq **leaf[ITR_TABLE_ROOT_SIZE];
+};
+
+/*
+ * struct itr_irq - An interrupt with registered handlers
+ * @it		Interrupt number
+ * @handlers	Registered handlers list head
+ * @link	Reference in the interrupt list of the chip
+ * @count	Number of times the interrupt was delivered
+ * @unhandled	Number of times no handler handled the interrupt
+ * @max_us	Longest time spent in the handlers
+ * @lat_hist	Histogram of time spent in the handlers
+ *
+ * An entry is kept once created, even if all handlers are removed, since
+ * it may be in use by an interrupt delivered on another CPU.
+ */
+struct itr_irq {
+	size_t it;
+	SLIST_HEAD(, itr_handler) handlers;
+	SLIST_ENTRY(itr_irq) link;
+#ifdef CFG_WITH_STATS
+	uint32_t count;
+	uint32_t unhandled;
+	uint32_t max_us;
+	uint32_t lat_hist[STATS_ITR_NB_LAT_BUCKETS];
+#endif
+};
+
 static struct itr_chip *itr_main_chip __nex_bss;
+static SLIST_HEAD(, itr_chip) itr_chips __nex_data =
+	SLIST_HEAD_INITIALIZER(itr_chips);
 
 static bool itr_chip_is_valid(struct itr_chip *chip)
 {
@@ -33,9 +81,126 @@ static bool itr_chip_is_valid(struct itr_chip *chip)
 
 static void __itr_chip_init(struct itr_chip *chip)
 {
-	SLIST_INIT(&chip->handlers);
+	chip->irq_table = NULL;
+	SLIST_INIT(&chip->irqs);
+	SLIST_INSERT_HEAD(&itr_chips, chip, link);
 }
 
+static struct itr_irq *find_irq(struct itr_chip *chip, size_t itr_num)
+{
+	struct itr_irq **leaf = NULL;
+	struct itr_irq *irq = NULL;
+
+	if (itr_num < ITR_TABLE_NUM_IRQS) {
+		if (!chip->irq_table)
+			return NULL;
+		leaf = chip->irq_table->leaf[itr_num >> ITR_TABLE_LEAF_SHIFT];
+		if (!leaf)
+			return NULL;
+		return leaf[itr_num & (ITR_TABLE_LEAF_SIZE - 1)];
+	}
+
+	SLIST_FOREACH(irq, &chip->irqs, link)
+		if (irq->it == itr_num)
+			return irq;
+
+	return NULL;
+}
+
+/*
+ * Entries are published with release semantics once initialized, so an
+ * interrupt delivered on another CPU never sees a partial entry.
+ */
+static struct itr_irq *get_irq(struct itr_chip *chip, size_t itr_num)
+{
+	struct itr_irq *irq = find_irq(chip, itr_num);
+	struct itr_irq_table *table = chip->irq_table;
+	struct itr_irq **leaf = NULL;
+	size_t idx = itr_num >> ITR_TABLE_LEAF_SHIFT;
+
+	if (irq)
+		return irq;
+
+	irq = nex_calloc(1, sizeof(*irq));
+	if (!irq)
+		return NULL;
+	irq->it = itr_num;
+	SLIST_INIT(&irq->handlers);
+
+	if (itr_num < ITR_TABLE_NUM_IRQS) {
+		if (!table) {
+			table = nex_calloc(1, sizeof(*table));
+			if (!table)
+				goto err;
+			__atomic_store_n(&chip->irq_table, table,
+					 __ATOMIC_RELEASE);
+		}
+		leaf = table->leaf[idx];
+		if (!leaf) {
+			leaf = nex_calloc(ITR_TABLE_LEAF_SIZE, sizeof(*leaf));
+			if (!leaf)
+				goto err;
+			__atomic_store_n(&table->leaf[idx], leaf,
+					 __ATOMIC_RELEASE);
+		}
+		__atomic_store_n(&leaf[itr_num & (ITR_TABLE_LEAF_SIZE - 1)],
+				 irq, __ATOMIC_RELEASE);
+	}
+
+	SLIST_INSERT_HEAD(&chip->irqs, irq, link);
+
+	return irq;
+err:
+	nex_free(irq);
+	return NULL;
+}
+
+#ifdef CFG_WITH_STATS
+static uint64_t read_cnt(void)
+{
+#ifdef CFG_CORE_HAS_GENERIC_TIMER
+	return delay_cnt_read();
+#else
+	return 0;
+#endif
+}
+
+static void update_stats(struct itr_irq *irq, bool handled,
+			 uint64_t start __maybe_unused)
+{
+	unsigned int bucket = 0;
+	uint32_t max_us = 0;
+	uint32_t us = 0;
+
+	atomic_inc32(&irq->count);
+	if (!handled)
+		atomic_inc32(&irq->unhandled);
+
+#ifdef CFG_CORE_HAS_GENERIC_TIMER
+	us = MIN((read_cnt() - start) * 1000000 / delay_cnt_freq(),
+		 (uint64_t)UINT32_MAX);
+#endif
+
+	while (bucket < STATS_ITR_NB_LAT_BUCKETS - 1 && us >= BIT(bucket))
+		bucket++;
+	atomic_inc32(irq->lat_hist + bucket);
+
+	max_us = atomic_load_u32(&irq->max_us);
+	while (us > max_us && !atomic_cas_u32(&irq->max_us, &max_us, us))
+		;
+}
+#else
+static uint64_t read_cnt(void)
+{
+	return 0;
+}
+
+static void update_stats(struct itr_irq *irq __unused, bool handled __unused,
+			 uint64_t start __unused)
+{
+}
+#endif
+
 TEE_Result itr_chip_init(struct itr_chip *chip)
 {
 	/*
@@ -111,17 +276,24 @@ void __weak __noreturn interrupt_main_handler(void)
 void interrupt_call_handlers(struct itr_chip *chip, size_t itr_num)
 {
 	struct itr_handler *h = NULL;
+	struct itr_irq *irq = NULL;
 	bool was_handled = false;
+	uint64_t start = 0;
 
 	assert(chip);
 
-	SLIST_FOREACH(h, &chip->handlers, link) {
-		if (h->it == itr_num) {
+	irq = find_irq(chip, itr_num);
+	if (irq) {
+		start = read_cnt();
+
+		SLIST_FOREACH(h, &irq->handlers, link) {
 			if (h->handler(h) == ITRR_HANDLED)
 				was_handled = true;
 			else if (!(h->flags & ITRF_SHARED))
 				break;
 		}
+
+		update_stats(irq, was_handled, start);
 	}
 
 	if (!was_handled) {
@@ -149,14 +321,18 @@ static TEE_Result add_configure_handler(struct itr_handler *hdl,
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	struct itr_handler *h = NULL;
+	struct itr_irq *irq = NULL;
 
 	assert(hdl && hdl->chip->ops && is_unpaged(hdl) &&
 	       hdl->handler && is_unpaged(hdl->handler));
 
-	SLIST_FOREACH(h, &hdl->chip->handlers, link) {
-		if (h->it == hdl->it &&
-		    (!(hdl->flags & ITRF_SHARED) ||
-		     !(h->flags & ITRF_SHARED))) {
+	irq = get_irq(hdl->chip, hdl->it);
+	if (!irq)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	SLIST_FOREACH(h, &irq->handlers, link) {
+		if (!(hdl->flags & ITRF_SHARED) ||
+		    !(h->flags & ITRF_SHARED)) {
 			EMSG("Shared and non-shared flags on interrupt %s#%zu",
 			     hdl->chip->name, hdl->it);
 			return TEE_ERROR_GENERIC;
@@ -169,7 +345,7 @@ static TEE_Result add_configure_handler(struct itr_handler *hdl,
 			return res;
 	}
 
-	SLIST_INSERT_HEAD(&hdl->chip->handlers, hdl, link);
+	SLIST_INSERT_HEAD(&irq->handlers, hdl, link);
 
 	return TEE_SUCCESS;
 }
@@ -215,33 +391,27 @@ TEE_Result interrupt_create_handler(struct itr_chip *itr_chip, size_t itr_num,
 void interrupt_remove_handler(struct itr_handler *hdl)
 {
 	struct itr_handler *h = NULL;
-	bool disable_itr = true;
+	struct itr_irq *irq = NULL;
 
 	if (!hdl)
 		return;
 
-	SLIST_FOREACH(h, &hdl->chip->handlers, link)
-		if (h == hdl)
-			break;
+	irq = find_irq(hdl->chip, hdl->it);
+	if (irq)
+		SLIST_FOREACH(h, &irq->handlers, link)
+			if (h == hdl)
+				break;
 	if (!h) {
 		DMSG("Invalid %s:%zu", hdl->chip->name, hdl->it);
 		assert(false);
 		return;
 	}
 
-	if (hdl->flags & ITRF_SHARED) {
-		SLIST_FOREACH(h, &hdl->chip->handlers, link) {
-			if (h != hdl && h->it == hdl->it) {
-				disable_itr = false;
-				break;
-			}
-		}
-	}
-
-	if (disable_itr)
+	/* Shared interrupts stay enabled while there are other handlers */
+	if (SLIST_FIRST(&irq->handlers) == hdl && !SLIST_NEXT(hdl, link))
 		interrupt_disable(hdl->chip, hdl->it);
 
-	SLIST_REMOVE(&hdl->chip->handlers, hdl, itr_handler, link);
+	SLIST_REMOVE(&irq->handlers, hdl, itr_handler, link);
 }
 
 TEE_Result interrupt_alloc_add_conf_handler(struct itr_chip *chip,
@@ -280,6 +450,55 @@ void interrupt_remove_free_handler(struct itr_handler *hdl)
 	}
 }
 
+#ifdef CFG_WITH_STATS
+TEE_Result interrupt_get_stats(void *buf, size_t *buf_size)
+{
+	struct pta_stats_itr *st = NULL;
+	struct itr_chip *chip = NULL;
+	struct itr_irq *irq = NULL;
+	size_t sz = 0;
+	size_t n = 0;
+
+	if (!buf_size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	SLIST_FOREACH(chip, &itr_chips, link)
+		SLIST_FOREACH(irq, &chip->irqs, link)
+			sz += sizeof(*st);
+
+	if (!sz)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	if (!buf || *buf_size < sz) {
+		*buf_size = sz;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	if (!IS_ALIGNED_WITH_TYPE(buf, uint32_t))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	st = buf;
+	SLIST_FOREACH(chip, &itr_chips, link) {
+		SLIST_FOREACH(irq, &chip->irqs, link) {
+			*st = (struct pta_stats_itr){
+				.itr_num = irq->it,
+				.count = atomic_load_u32(&irq->count),
+				.unhandled = atomic_load_u32(&irq->unhandled),
+				.max_us = atomic_load_u32(&irq->max_us),
+			};
+			if (chip->name)
+				strlcpy(st->chip_name, chip->name,
+					sizeof(st->chip_name));
+			for (n = 0; n < STATS_ITR_NB_LAT_BUCKETS; n++)
+				st->lat_hist[n] =
+					atomic_load_u32(irq->lat_hist + n);
+			st++;
+		}
+	}
+	*buf_size = sz;
+
+	return TEE_SUCCESS;
+}
+#endif
+
 #ifdef CFG_DT
 TEE_Result interrupt_register_provider(const void *fdt, int node,
 				       itr_dt_get_func dt_get_itr, void *data)
@@ -165,7 +165,22 @@ TEE_Result ldelf_init_with_ldelf(struct ts_session *sess,
 		if (arg_bbuf->flags & ~TA_FLAGS_MASK)
 			return TEE_ERROR_BAD_FORMAT;
 
+		/*
+		 * A user TA can only be entered concurrently if it has a
+		 * stack per invocation, see user_ta_enter().
+		 */
+		if (!IS_ENABLED(CFG_TA_CONCURRENT))
+			arg_bbuf->flags &= ~TA_FLAG_CONCURRENT;
+
 		to_user_ta_ctx(uctx->ts_ctx)->ta_ctx.flags = arg_bbuf->flags;
+
+		/*
+		 * Instances kept alive are expected to serve requests
+		 * repeatedly, try to keep their translation tables cached.
+		 */
+		uctx->pgt_retain = (arg_bbuf->flags &
+				    TA_FLAG_INSTANCE_KEEP_ALIVE) &&
+				   (arg_bbuf->flags & TA_FLAG_SINGLE_INSTANCE);
 	}
 
 	uctx->is_32bit = arg_bbuf->is_32bit;
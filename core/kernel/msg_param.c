@@ -26,10 +26,13 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <io.h>
 #include <kernel/msg_param.h>
 #include <mm/mobj.h>
 #include <optee_msg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <types_ext.h>
 #include <util.h>
 
@@ -147,3 +150,148 @@ out:
 	free(pages);
 	return mobj;
 }
+
+#ifdef CFG_CORE_SGMEM
+/* Copies the segment list out of shared memory before it's checked */
+static bool sgmem_read_segs(uint64_t shm_ref, size_t offs, size_t num_segs,
+			    struct optee_msg_sgmem_seg *segs)
+{
+	struct mobj *mobj = NULL;
+	void *va = NULL;
+
+	mobj = mobj_reg_shm_get_by_cookie(shm_ref);
+	if (!mobj)
+		return false;
+
+	if (!mobj_inc_map(mobj)) {
+		va = mobj_get_va(mobj, offs, num_segs * sizeof(*segs));
+		if (va)
+			memcpy(segs, va, num_segs * sizeof(*segs));
+		mobj_dec_map(mobj);
+	}
+	mobj_put(mobj);
+
+	return va;
+}
+
+/*
+ * Appends the physical pages of @seg in @mobj to @pages. All segments but
+ * the first must start on a page boundary and all but the last must end
+ * on one for the pages to make up a virtually contiguous buffer.
+ */
+static bool sgmem_add_seg(const struct optee_msg_sgmem_seg *seg,
+			  struct mobj *mobj, bool first, bool last,
+			  paddr_t *pages, size_t *num_pages, size_t max_pages,
+			  paddr_t *page_offset)
+{
+	size_t offs = 0;
+	size_t end = 0;
+	paddr_t pa = 0;
+
+	if (!seg->size || ADD_OVERFLOW(seg->offs, seg->size, &end) ||
+	    end > mobj->size)
+		return false;
+
+	offs = seg->offs;
+	if (mobj_get_pa(mobj, offs, 0, &pa))
+		return false;
+	if (first)
+		*page_offset = pa & SMALL_PAGE_MASK;
+	else if (pa & SMALL_PAGE_MASK)
+		return false;
+
+	while (offs < end) {
+		if (*num_pages == max_pages || mobj_get_pa(mobj, offs, 0, &pa))
+			return false;
+		pages[*num_pages] = pa & ~SMALL_PAGE_MASK;
+		(*num_pages)++;
+		offs += SMALL_PAGE_SIZE - (pa & SMALL_PAGE_MASK);
+	}
+
+	/* @offs is now the end of the last page of the segment */
+	return last || offs == end;
+}
+
+void msg_param_put_sgmem_segs(struct mobj **seg_mobjs, size_t num_seg_mobjs)
+{
+	size_t n = 0;
+
+	if (!seg_mobjs)
+		return;
+
+	for (n = 0; n < num_seg_mobjs; n++)
+		mobj_put(seg_mobjs[n]);
+	free(seg_mobjs);
+}
+
+struct mobj *
+msg_param_mobj_from_sgmem(const struct optee_msg_param_sgmem *sgmem,
+			  size_t *size, struct mobj ***seg_mobjs,
+			  size_t *num_seg_mobjs)
+{
+	size_t num_segs = READ_ONCE(sgmem->num_segs);
+	uint64_t total_size = READ_ONCE(sgmem->size);
+	struct optee_msg_sgmem_seg *segs = NULL;
+	struct mobj **mobjs = NULL;
+	struct mobj *mobj = NULL;
+	paddr_t page_offset = 0;
+	paddr_t *pages = NULL;
+	size_t num_pages = 0;
+	size_t max_pages = 0;
+	size_t sz = 0;
+	size_t n = 0;
+
+	if (!num_segs || num_segs > CFG_CORE_SGMEM_MAX_SEGS)
+		return NULL;
+
+	segs = calloc(num_segs, sizeof(*segs));
+	if (!segs)
+		return NULL;
+
+	if (!sgmem_read_segs(READ_ONCE(sgmem->shm_ref),
+			     READ_ONCE(sgmem->offs), num_segs, segs))
+		goto out;
+
+	for (n = 0; n < num_segs; n++) {
+		/* A segment spans at most this many pages */
+		uint64_t seg_pages = segs[n].size / SMALL_PAGE_SIZE + 2;
+
+		if (ADD_OVERFLOW(sz, segs[n].size, &sz) ||
+		    ADD_OVERFLOW(max_pages, seg_pages, &max_pages))
+			goto out;
+	}
+	if (sz != total_size)
+		goto out;
+
+	pages = calloc(max_pages, sizeof(*pages));
+	mobjs = calloc(num_segs, sizeof(*mobjs));
+	if (!pages || !mobjs)
+		goto out;
+
+	/*
+	 * The registered shared memory of each segment is referenced for
+	 * as long as the returned mobj is used, else normal world could
+	 * unregister and reuse it while it's still mapped.
+	 */
+	for (n = 0; n < num_segs; n++) {
+		mobjs[n] = mobj_reg_shm_get_by_cookie(segs[n].shm_ref);
+		if (!mobjs[n] ||
+		    !sgmem_add_seg(segs + n, mobjs[n], !n, n == num_segs - 1,
+				   pages, &num_pages, max_pages, &page_offset))
+			goto out;
+	}
+
+	mobj = mobj_reg_shm_alloc(pages, num_pages, page_offset, 0);
+	if (mobj) {
+		*size = sz;
+		*seg_mobjs = mobjs;
+		*num_seg_mobjs = num_segs;
+		mobjs = NULL;
+	}
+out:
+	msg_param_put_sgmem_segs(mobjs, num_segs);
+	free(pages);
+	free(segs);
+	return mobj;
+}
+#endif /*CFG_CORE_SGMEM*/
@@ -3,6 +3,8 @@
  * Copyright (c) 2015-2017, Linaro Limited
  */
 
+#include <atomic.h>
+#include <kernel/delay.h>
 #include <kernel/mutex.h>
 #include <kernel/mutex_pm_aware.h>
 #include <kernel/panic.h>
@@ -23,8 +25,60 @@ void mutex_init_recursive(struct recursive_mutex *m)
 	*m = (struct recursive_mutex)RECURSIVE_MUTEX_INITIALIZER;
 }
 
+#ifdef CFG_WITH_STATS
+void mutex_get_stats(struct mutex *m, struct mutex_stats *stats)
+{
+	uint32_t old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
+
+	*stats = m->stats;
+	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
+}
+
+#define MUTEX_INCR_STAT(m, name)	((m)->stats.name++)
+#else
+#define MUTEX_INCR_STAT(m, name)	do { } while (0)
+#endif
+
+#if CFG_CORE_MUTEX_SPIN_US && defined(CFG_CORE_HAS_GENERIC_TIMER)
+/* Max number of counter reads between each look at the mutex */
+#define MUTEX_SPIN_MAX_BACKOFF	64
+
+/*
+ * Spins while @owner is still holding @m and executing on another core,
+ * but at most CFG_CORE_MUTEX_SPIN_US microseconds. The delay between each
+ * look at the mutex doubles to limit the traffic on the cache line.
+ */
+static void mutex_spin(struct mutex *m, short int owner)
+{
+	uint64_t expire = timeout_init_us(CFG_CORE_MUTEX_SPIN_US);
+	unsigned int backoff = 1;
+	unsigned int n = 0;
+
+	while (!timeout_elapsed(expire)) {
+		if (!atomic_load_short(&m->state) ||
+		    atomic_load_short(&m->owner) != owner ||
+		    !thread_is_active(owner))
+			return;
+
+		for (n = 0; n < backoff; n++)
+			if (timeout_elapsed(expire))
+				return;
+		if (backoff < MUTEX_SPIN_MAX_BACKOFF)
+			backoff *= 2;
+	}
+}
+#else
+static void mutex_spin(struct mutex *m __unused, short int owner __unused)
+{
+}
+#endif
+
 static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 {
+	bool spin_tried = false;
+	bool contended = false;
+	bool slept = false;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -34,6 +88,8 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 	while (true) {
 		uint32_t old_itr_status;
 		bool can_lock;
+		bool can_spin = false;
+		short int owner = THREAD_ID_INVALID;
 		struct wait_queue_elem wqe;
 
 		/*
@@ -43,27 +99,55 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 		 *
 		 * If the mutex is unlocked we don't need to use the wqe at
 		 * all.
+		 *
+		 * If the mutex is write locked by a thread executing on
+		 * another core the lock is likely to be released soon, so
+		 * spin for a while once before going to normal world to
+		 * wait. Sleeping costs two world switches, one here and
+		 * one for the wakeup in mutex_unlock().
 		 */
 
 		old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 		can_lock = !m->state;
 		if (!can_lock) {
-			wq_wait_init(&m->wq, &wqe, false /* wait_read */);
+			if (!contended)
+				MUTEX_INCR_STAT(m, contended);
+			contended = true;
+			if (!spin_tried && m->state == -1 &&
+			    thread_is_active(m->owner)) {
+				can_spin = true;
+				owner = m->owner;
+			} else {
+				wq_wait_init(&m->wq, &wqe,
+					     false /* wait_read */);
+				MUTEX_INCR_STAT(m, slept);
+				slept = true;
+			}
 		} else {
 			m->state = -1; /* write locked */
+			m->owner = thread_get_id();
+			MUTEX_INCR_STAT(m, locked);
+			if (spin_tried && !slept)
+				MUTEX_INCR_STAT(m, spun);
 		}
 
 		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-		if (!can_lock) {
-			/*
-			 * Someone else is holding the lock, wait in normal
-			 * world for the lock to become available.
-			 */
-			wq_wait_final(&m->wq, &wqe, 0, m, fname, lineno);
-		} else
+		if (can_lock)
 			return;
+
+		if (can_spin) {
+			mutex_spin(m, owner);
+			spin_tried = true;
+			continue;
+		}
+
+		/*
+		 * Someone else is holding the lock, wait in normal world
+		 * for the lock to become available.
+		 */
+		wq_wait_final(&m->wq, &wqe, 0, m, fname, lineno);
 	}
 }
 
@@ -137,8 +221,11 @@ static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 	can_lock_write = !m->state;
-	if (can_lock_write)
+	if (can_lock_write) {
 		m->state = -1;
+		m->owner = thread_get_id();
+		MUTEX_INCR_STAT(m, locked);
+	}
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
@@ -320,6 +320,7 @@ TEE_Result tee_ta_init_pseudo_ta_session(const TEE_UUID *uuid,
 
 	ctx->ref_count = 1;
 	ctx->flags = ta->flags;
+	tee_ta_ctx_init_busy(ctx);
 	stc->pseudo_ta = ta;
 	ctx->ts_ctx.uuid = ta->uuid;
 	ctx->ts_ctx.ops = &pseudo_ta_ops;
@@ -117,6 +117,9 @@ static const struct syscall_entry tee_syscall_table[] = {
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_not_supported),
 	SYSCALL_ENTRY(syscall_cache_operation),
+	SYSCALL_ENTRY(syscall_cryp_oneshot),
+	SYSCALL_ENTRY(syscall_cryp_update_vec),
+	SYSCALL_ENTRY(syscall_get_time_page),
 };
 
 /*
@@ -205,18 +208,33 @@ static syscall_t get_tee_syscall_func(size_t num)
 
 bool scall_handle_user_ta(struct thread_scall_regs *regs)
 {
+	struct mutex *m = user_ta_scall_mutex(ts_get_current_session()->ctx);
 	size_t scn = 0;
 	size_t max_args = 0;
 	syscall_t scf = NULL;
 
-	bb_reset();
 	scall_get_max_args(regs, &scn, &max_args);
 
+	/*
+	 * System calls from a TA executing on several cores at once share
+	 * the bounce buffer and the rest of the TA state. TEE_Wait() only
+	 * uses the state of the session and may take long.
+	 */
+	if (scn == TEE_SCN_WAIT)
+		m = NULL;
+	if (m)
+		mutex_lock(m);
+
+	bb_reset();
+	vm_access_cache_reset();
+
 	trace_syscall(scn);
 
 	if (max_args > TEE_SVC_MAX_ARGS) {
 		DMSG("Too many arguments for SCN %zu (%zu)", scn, max_args);
 		scall_set_retval(regs, TEE_ERROR_GENERIC);
+		if (m)
+			mutex_unlock(m);
 		return true; /* return to user mode */
 	}
 
@@ -227,6 +245,10 @@ bool scall_handle_user_ta(struct thread_scall_regs *regs)
 	scall_set_retval(regs, scall_do_call(regs, scf));
 
 	ftrace_syscall_leave();
+	vm_access_cache_reset();
+
+	if (m)
+		mutex_unlock(m);
 
 	/*
 	 * Return true if we're to return to user mode,
@@ -257,6 +279,7 @@ bool scall_handle_ldelf(struct thread_scall_regs *regs)
 	syscall_t scf = NULL;
 
 	bb_reset();
+	vm_access_cache_reset();
 	scall_get_max_args(regs, &scn, &max_args);
 
 	trace_syscall(scn);
@@ -274,6 +297,7 @@ bool scall_handle_ldelf(struct thread_scall_regs *regs)
 	scall_set_retval(regs, scall_do_call(regs, scf));
 
 	ftrace_syscall_leave();
+	vm_access_cache_reset();
 
 	/*
 	 * Return true if we're to return to user mode,
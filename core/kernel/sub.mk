@@ -65,3 +65,4 @@ cflags-remove-spin_lock_debug.c-$(CFG_TEE_CORE_DEBUG) += -pg
 endif
 srcs-y += nv_counter.c
 srcs-$(CFG_CALLOUT) += callout.c
+srcs-$(CFG_CORE_WORKQUEUE) += workqueue.c
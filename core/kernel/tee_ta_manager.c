@@ -5,6 +5,7 @@
  */
 
 #include <assert.h>
+#include <io.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
@@ -45,20 +46,192 @@ struct tee_ta_dump_ctx {
 };
 #endif
 
-/* This mutex protects the critical section in tee_ta_init_session */
+/*
+ * This mutex protects tee_ctxes, the life cycle of the contexts in it and
+ * the critical section in tee_ta_init_session
+ */
 struct mutex tee_ta_mutex = MUTEX_INITIALIZER;
+/*
+ * This mutex protects the session lists together with the reference
+ * counter and lock of each session. If both are needed tee_ta_mutex must
+ * be taken first.
+ */
+struct mutex tee_ta_sess_mutex = MUTEX_INITIALIZER;
+
+#define SESS_HASH_SIZE		BIT(CFG_TA_SESSION_HASH_ORDER)
+
+/*
+ * Open sessions of all session lists hashed on ID and list, protected by
+ * tee_ta_sess_mutex
+ */
+static LIST_HEAD(, tee_ta_session) tee_ta_sess_hash[SESS_HASH_SIZE];
+/* Next session ID to try, protected by tee_ta_sess_mutex */
+static uint32_t tee_ta_next_sess_id = 1;
 /* This condvar is used when waiting for a TA context to become initialized */
 struct condvar tee_ta_init_cv = CONDVAR_INITIALIZER;
 struct tee_ta_ctx_head tee_ctxes = TAILQ_HEAD_INITIALIZER(tee_ctxes);
 
-#ifndef CFG_CONCURRENT_SINGLE_INSTANCE_TA
-static struct condvar tee_ta_cv = CONDVAR_INITIALIZER;
-static short int tee_ta_single_instance_thread = THREAD_ID_INVALID;
-static size_t tee_ta_single_instance_count;
+struct tee_ta_session *__noprof to_ta_session(struct ts_session *sess)
+{
+	assert(is_ta_ctx(sess->ctx) || is_stmm_ctx(sess->ctx));
+	return container_of(sess, struct tee_ta_session, ts_sess);
+}
+
+static struct tee_ta_ctx *ts_to_ta_ctx(struct ts_ctx *ctx)
+{
+	if (is_ta_ctx(ctx))
+		return to_ta_ctx(ctx);
+
+	if (is_stmm_ctx(ctx))
+		return &(to_stmm_ctx(ctx)->ta_ctx);
+
+	panic("bad context");
+}
+
+/*
+ * Number of times in a row a waiter of a higher priority class may be
+ * granted a busy context ahead of a waiting lower class thread.
+ */
+#define BUSY_MAX_SKIPS		4
+
+/* A thread waiting for a busy TA context, lives on the waiter's stack */
+struct tee_ta_busy_waiter {
+	TAILQ_ENTRY(tee_ta_busy_waiter) link;
+	struct condvar cv;
+	short int thread_id;
+	bool granted;
+};
+
+void tee_ta_ctx_init_busy(struct tee_ta_ctx *ctx)
+{
+	size_t n = 0;
+
+	mutex_init(&ctx->busy_mutex);
+
+	for (n = 0; n < ARRAY_SIZE(ctx->busy_waiters); n++)
+		TAILQ_INIT(ctx->busy_waiters + n);
+}
+
+static unsigned int busy_prio(const TEE_Identity *clnt_id)
+{
+	if (TEE_TA_BUSY_NUM_PRIO == 1)
+		return 0;
+
+	if (clnt_id == KERN_IDENTITY ||
+	    (clnt_id && clnt_id->login == TEE_LOGIN_TRUSTED_APP))
+		return TEE_TA_BUSY_PRIO_TA;
+
+	return TEE_TA_BUSY_PRIO_REE;
+}
+
+#ifdef CFG_WITH_STATS
+static void busy_wait_start(struct tee_ta_ctx *ctx, TEE_Time *start)
+{
+	struct tee_ta_busy_stats *st = &ctx->busy_stats;
+
+	st->queue_depth++;
+	st->max_queue_depth = MAX(st->max_queue_depth, st->queue_depth);
+	st->waits++;
+	if (tee_time_get_sys_time(start))
+		*start = (TEE_Time){ };
+}
+
+static void busy_wait_end(struct tee_ta_ctx *ctx, TEE_Time *start)
+{
+	struct tee_ta_busy_stats *st = &ctx->busy_stats;
+	TEE_Time now = { };
+	TEE_Time d = { };
+	uint32_t ms = 0;
+
+	st->queue_depth--;
+	if (tee_time_get_sys_time(&now) || !(start->seconds || start->millis))
+		return;
+
+	TEE_TIME_SUB(now, *start, d);
+	ms = d.seconds * 1000 + d.millis;
+	st->total_wait_ms += ms;
+	st->max_wait_ms = MAX(st->max_wait_ms, ms);
+}
+#else
+static void busy_wait_start(struct tee_ta_ctx *ctx __unused,
+			    TEE_Time *start __unused)
+{
+}
+
+static void busy_wait_end(struct tee_ta_ctx *ctx __unused,
+			  TEE_Time *start __unused)
+{
+}
 #endif
 
+/*
+ * Queue the calling thread last in its priority class of @waiters and
+ * wait until it's granted the context or lock by whoever releases it.
+ * Requires @mu, which protects @waiters, to be held. The wait is
+ * accounted in the busy statistics of @ctx.
+ */
+static void wait_busy(struct tee_ta_busy_waiter_head *waiters,
+		      struct mutex *mu, struct tee_ta_ctx *ctx,
+		      unsigned int prio)
+{
+	struct tee_ta_busy_waiter w = { .thread_id = thread_get_id() };
+	TEE_Time start = { };
+
+	condvar_init(&w.cv);
+	TAILQ_INSERT_TAIL(waiters + prio, &w, link);
+	busy_wait_start(ctx, &start);
+
+	while (!w.granted)
+		condvar_wait(&w.cv, mu);
+
+	busy_wait_end(ctx, &start);
+	condvar_destroy(&w.cv);
+}
+
+/*
+ * Dequeue the next waiter of @waiters: the first one of the highest
+ * priority class with waiters, unless a lower class has been passed over
+ * too many times in a row as counted in @skips. Requires the mutex
+ * protecting @waiters to be held.
+ */
+static struct tee_ta_busy_waiter *
+next_busy_waiter(struct tee_ta_busy_waiter_head *waiters, uint8_t *skips)
+{
+	struct tee_ta_busy_waiter *w = NULL;
+	unsigned int first = TEE_TA_BUSY_NUM_PRIO;
+	unsigned int last = 0;
+	unsigned int n = 0;
+
+	for (n = 0; n < TEE_TA_BUSY_NUM_PRIO; n++) {
+		if (TAILQ_EMPTY(waiters + n))
+			continue;
+		if (first == TEE_TA_BUSY_NUM_PRIO)
+			first = n;
+		last = n;
+	}
+
+	if (first == TEE_TA_BUSY_NUM_PRIO)
+		return NULL;
+
+	n = first;
+	if (first == last) {
+		*skips = 0;
+	} else if (*skips >= BUSY_MAX_SKIPS) {
+		*skips = 0;
+		n = last;
+	} else {
+		(*skips)++;
+	}
+
+	w = TAILQ_FIRST(waiters + n);
+	TAILQ_REMOVE(waiters + n, w, link);
+
+	return w;
+}
+
 #ifdef CFG_CONCURRENT_SINGLE_INSTANCE_TA
-static void lock_single_instance(void)
+static void lock_single_instance(struct tee_ta_ctx *ctx __unused,
+				 unsigned int prio __unused)
 {
 }
 
@@ -70,119 +243,170 @@ static bool has_single_instance_lock(void)
 {
 	return false;
 }
+
+static void lock_single_instance_stats(void)
+{
+}
+
+static void unlock_single_instance_stats(void)
+{
+}
 #else
-static void lock_single_instance(void)
+/*
+ * The single-instance lock serializes all single-instance TAs. Threads
+ * waiting for it are queued like the waiters of a busy context and the
+ * lock is handed over to the next waiter when released. The busy
+ * statistics of single-instance TA contexts are protected by
+ * tee_ta_single_instance_mutex since that's the queue they wait in.
+ */
+static struct mutex tee_ta_single_instance_mutex = MUTEX_INITIALIZER;
+static struct tee_ta_busy_waiter_head
+tee_ta_single_instance_waiters[TEE_TA_BUSY_NUM_PRIO] = {
+	TAILQ_HEAD_INITIALIZER(tee_ta_single_instance_waiters[0]),
+#if TEE_TA_BUSY_NUM_PRIO > 1
+	TAILQ_HEAD_INITIALIZER(tee_ta_single_instance_waiters[1]),
+#endif
+};
+static uint8_t tee_ta_single_instance_skips;
+static short int tee_ta_single_instance_thread = THREAD_ID_INVALID;
+static size_t tee_ta_single_instance_count;
+
+static void lock_single_instance(struct tee_ta_ctx *ctx, unsigned int prio)
 {
-	/* Requires tee_ta_mutex to be held */
-	if (tee_ta_single_instance_thread != thread_get_id()) {
-		/* Wait until the single-instance lock is available. */
-		while (tee_ta_single_instance_thread != THREAD_ID_INVALID)
-			condvar_wait(&tee_ta_cv, &tee_ta_mutex);
+	mutex_lock(&tee_ta_single_instance_mutex);
 
+	if (tee_ta_single_instance_thread == THREAD_ID_INVALID) {
 		tee_ta_single_instance_thread = thread_get_id();
 		assert(tee_ta_single_instance_count == 0);
+	} else if (tee_ta_single_instance_thread != thread_get_id()) {
+		/* The lock is handed over by unlock_single_instance() */
+		wait_busy(tee_ta_single_instance_waiters,
+			  &tee_ta_single_instance_mutex, ctx, prio);
+		assert(tee_ta_single_instance_thread == thread_get_id());
+		assert(tee_ta_single_instance_count == 0);
 	}
 
 	tee_ta_single_instance_count++;
+
+	mutex_unlock(&tee_ta_single_instance_mutex);
 }
 
 static void unlock_single_instance(void)
 {
-	/* Requires tee_ta_mutex to be held */
+	struct tee_ta_busy_waiter *w = NULL;
+
+	mutex_lock(&tee_ta_single_instance_mutex);
+
 	assert(tee_ta_single_instance_thread == thread_get_id());
 	assert(tee_ta_single_instance_count > 0);
 
 	tee_ta_single_instance_count--;
 	if (tee_ta_single_instance_count == 0) {
-		tee_ta_single_instance_thread = THREAD_ID_INVALID;
-		condvar_signal(&tee_ta_cv);
+		w = next_busy_waiter(tee_ta_single_instance_waiters,
+				     &tee_ta_single_instance_skips);
+		if (w) {
+			tee_ta_single_instance_thread = w->thread_id;
+			w->granted = true;
+			condvar_signal(&w->cv);
+		} else {
+			tee_ta_single_instance_thread = THREAD_ID_INVALID;
+		}
 	}
+
+	mutex_unlock(&tee_ta_single_instance_mutex);
 }
 
 static bool has_single_instance_lock(void)
 {
-	/* Requires tee_ta_mutex to be held */
-	return tee_ta_single_instance_thread == thread_get_id();
+	/*
+	 * Only the current thread can make the lock owned by itself or
+	 * release it, so no locking is needed to answer this question.
+	 */
+	return READ_ONCE(tee_ta_single_instance_thread) == thread_get_id();
 }
-#endif
 
-struct tee_ta_session *__noprof to_ta_session(struct ts_session *sess)
+static void __maybe_unused lock_single_instance_stats(void)
 {
-	assert(is_ta_ctx(sess->ctx) || is_stmm_ctx(sess->ctx));
-	return container_of(sess, struct tee_ta_session, ts_sess);
+	mutex_lock(&tee_ta_single_instance_mutex);
 }
 
-static struct tee_ta_ctx *ts_to_ta_ctx(struct ts_ctx *ctx)
+static void __maybe_unused unlock_single_instance_stats(void)
 {
-	if (is_ta_ctx(ctx))
-		return to_ta_ctx(ctx);
-
-	if (is_stmm_ctx(ctx))
-		return &(to_stmm_ctx(ctx)->ta_ctx);
-
-	panic("bad context");
+	mutex_unlock(&tee_ta_single_instance_mutex);
 }
+#endif
 
-static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx)
+static bool tee_ta_try_set_busy(struct tee_ta_ctx *ctx,
+				const TEE_Identity *clnt_id)
 {
+	unsigned int prio = busy_prio(clnt_id);
 	bool rc = true;
 
 	if (ctx->flags & TA_FLAG_CONCURRENT)
 		return true;
 
-	mutex_lock(&tee_ta_mutex);
-
 	if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
-		lock_single_instance();
+		lock_single_instance(ctx, prio);
+
+	mutex_lock(&ctx->busy_mutex);
 
 	if (has_single_instance_lock()) {
-		if (ctx->busy) {
-			/*
-			 * We're holding the single-instance lock and the
-			 * TA is busy, as waiting now would only cause a
-			 * dead-lock, we release the lock and return false.
-			 */
+		/*
+		 * We're holding the single-instance lock, if the TA is
+		 * busy waiting now would only cause a dead-lock, we
+		 * release the lock below and return false.
+		 */
+		if (ctx->busy)
 			rc = false;
-			if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
-				unlock_single_instance();
-		}
-	} else {
+	} else if (ctx->busy) {
 		/*
 		 * We're not holding the single-instance lock, we're free to
-		 * wait for the TA to become available.
+		 * wait for the TA to become available. The context is
+		 * handed over still busy so no one can jump the queue.
 		 */
-		while (ctx->busy)
-			condvar_wait(&ctx->busy_cv, &tee_ta_mutex);
+		wait_busy(ctx->busy_waiters, &ctx->busy_mutex, ctx, prio);
 	}
 
 	/* Either it's already true or we should set it to true */
 	ctx->busy = true;
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(&ctx->busy_mutex);
+
+	if (!rc && (ctx->flags & TA_FLAG_SINGLE_INSTANCE))
+		unlock_single_instance();
+
 	return rc;
 }
 
-static void tee_ta_set_busy(struct tee_ta_ctx *ctx)
+static void tee_ta_set_busy(struct tee_ta_ctx *ctx,
+			    const TEE_Identity *clnt_id)
 {
-	if (!tee_ta_try_set_busy(ctx))
+	if (!tee_ta_try_set_busy(ctx, clnt_id))
 		panic();
 }
 
 static void tee_ta_clear_busy(struct tee_ta_ctx *ctx)
 {
+	struct tee_ta_busy_waiter *w = NULL;
+
 	if (ctx->flags & TA_FLAG_CONCURRENT)
 		return;
 
-	mutex_lock(&tee_ta_mutex);
+	mutex_lock(&ctx->busy_mutex);
 
 	assert(ctx->busy);
-	ctx->busy = false;
-	condvar_signal(&ctx->busy_cv);
+	w = next_busy_waiter(ctx->busy_waiters, &ctx->busy_skips);
+	if (w) {
+		w->granted = true;
+		condvar_signal(&w->cv);
+	} else {
+		ctx->busy = false;
+	}
+
+	mutex_unlock(&ctx->busy_mutex);
 
 	if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
 		unlock_single_instance();
-
-	mutex_unlock(&tee_ta_mutex);
 }
 
 static void dec_session_ref_count(struct tee_ta_session *s)
@@ -195,7 +419,7 @@ static void dec_session_ref_count(struct tee_ta_session *s)
 
 void tee_ta_put_session(struct tee_ta_session *s)
 {
-	mutex_lock(&tee_ta_mutex);
+	mutex_lock(&tee_ta_sess_mutex);
 
 	if (s->lock_thread == thread_get_id()) {
 		s->lock_thread = THREAD_ID_INVALID;
@@ -203,23 +427,45 @@ void tee_ta_put_session(struct tee_ta_session *s)
 	}
 	dec_session_ref_count(s);
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(&tee_ta_sess_mutex);
+}
+
+static size_t sess_hash_idx(uint32_t id,
+			    struct tee_ta_session_head *open_sessions)
+{
+	/* IDs are allocated sequentially so the low bits spread well */
+	return (id ^ ((vaddr_t)open_sessions >> 4)) & (SESS_HASH_SIZE - 1);
+}
+
+/* Add a session to a session list, requires tee_ta_sess_mutex */
+static void sess_link(struct tee_ta_session *s,
+		      struct tee_ta_session_head *open_sessions)
+{
+	s->open_sessions = open_sessions;
+	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	LIST_INSERT_HEAD(tee_ta_sess_hash + sess_hash_idx(s->id, open_sessions),
+			 s, hash_link);
+}
+
+/* Remove a session from its session list, requires tee_ta_sess_mutex */
+static void sess_unlink(struct tee_ta_session *s)
+{
+	TAILQ_REMOVE(s->open_sessions, s, link);
+	LIST_REMOVE(s, hash_link);
+	s->open_sessions = NULL;
 }
 
 static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
 			struct tee_ta_session_head *open_sessions)
 {
+	size_t idx = sess_hash_idx(id, open_sessions);
 	struct tee_ta_session *s = NULL;
-	struct tee_ta_session *found = NULL;
 
-	TAILQ_FOREACH(s, open_sessions, link) {
-		if (s->id == id) {
-			found = s;
-			break;
-		}
-	}
+	LIST_FOREACH(s, tee_ta_sess_hash + idx, hash_link)
+		if (s->id == id && s->open_sessions == open_sessions)
+			return s;
 
-	return found;
+	return NULL;
 }
 
 struct tee_ta_session *tee_ta_find_session(uint32_t id,
@@ -227,11 +473,11 @@ struct tee_ta_session *tee_ta_find_session(uint32_t id,
 {
 	struct tee_ta_session *s = NULL;
 
-	mutex_lock(&tee_ta_mutex);
+	mutex_lock(&tee_ta_sess_mutex);
 
 	s = tee_ta_find_session_nolock(id, open_sessions);
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(&tee_ta_sess_mutex);
 
 	return s;
 }
@@ -241,7 +487,7 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 {
 	struct tee_ta_session *s;
 
-	mutex_lock(&tee_ta_mutex);
+	mutex_lock(&tee_ta_sess_mutex);
 
 	while (true) {
 		s = tee_ta_find_session_nolock(id, open_sessions);
@@ -258,7 +504,7 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 		assert(s->lock_thread != thread_get_id());
 
 		while (s->lock_thread != THREAD_ID_INVALID && !s->unlink)
-			condvar_wait(&s->lock_cv, &tee_ta_mutex);
+			condvar_wait(&s->lock_cv, &tee_ta_sess_mutex);
 
 		if (s->unlink) {
 			dec_session_ref_count(s);
@@ -270,14 +516,15 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 		break;
 	}
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(&tee_ta_sess_mutex);
 	return s;
 }
 
-static void tee_ta_unlink_session(struct tee_ta_session *s,
-			struct tee_ta_session_head *open_sessions)
+static void
+tee_ta_unlink_session(struct tee_ta_session *s,
+		      struct tee_ta_session_head *open_sessions __maybe_unused)
 {
-	mutex_lock(&tee_ta_mutex);
+	mutex_lock(&tee_ta_sess_mutex);
 
 	assert(s->ref_count >= 1);
 	assert(s->lock_thread == thread_get_id());
@@ -287,11 +534,12 @@ static void tee_ta_unlink_session(struct tee_ta_session *s,
 	condvar_broadcast(&s->lock_cv);
 
 	while (s->ref_count != 1)
-		condvar_wait(&s->refc_cv, &tee_ta_mutex);
+		condvar_wait(&s->refc_cv, &tee_ta_sess_mutex);
 
-	TAILQ_REMOVE(open_sessions, s, link);
+	assert(s->open_sessions == open_sessions);
+	sess_unlink(s);
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_unlock(&tee_ta_sess_mutex);
 }
 
 static void destroy_session(struct tee_ta_session *s,
@@ -317,7 +565,7 @@ static void destroy_context(struct tee_ta_ctx *ctx)
 {
 	DMSG("Destroy TA ctx (0x%" PRIxVA ")",  (vaddr_t)ctx);
 
-	condvar_destroy(&ctx->busy_cv);
+	mutex_destroy(&ctx->busy_mutex);
 	ctx->ts_ctx.ops->destroy(&ctx->ts_ctx);
 }
 
@@ -488,7 +736,7 @@ TEE_Result tee_ta_close_session(struct tee_ta_session *csess,
 	if (ctx->panicked) {
 		destroy_session(sess, open_sessions);
 	} else {
-		tee_ta_set_busy(ctx);
+		tee_ta_set_busy(ctx, clnt_id);
 		set_invoke_timeout(sess, TEE_TIMEOUT_INFINITE);
 		ts_ctx->ops->enter_close_session(&sess->ts_sess);
 		destroy_session(sess, open_sessions);
@@ -564,26 +812,20 @@ static TEE_Result tee_ta_init_session_with_context(struct tee_ta_session *s,
 
 static uint32_t new_session_id(struct tee_ta_session_head *open_sessions)
 {
-	struct tee_ta_session *last = NULL;
-	uint32_t saved = 0;
-	uint32_t id = 1;
-
-	last = TAILQ_LAST(open_sessions, tee_ta_session_head);
-	if (last) {
-		/* This value is less likely to be already used */
-		id = last->id + 1;
-		if (!id)
-			id++; /* 0 is not valid */
-	}
+	uint32_t saved = tee_ta_next_sess_id;
+	uint32_t id = 0;
 
-	saved = id;
+	/*
+	 * IDs are handed out from a counter shared by all session lists,
+	 * an ID can only be in use if the counter has wrapped.
+	 */
 	do {
+		id = tee_ta_next_sess_id++;
+		if (!tee_ta_next_sess_id)
+			tee_ta_next_sess_id++; /* 0 is not valid */
 		if (!tee_ta_find_session_nolock(id, open_sessions))
 			return id;
-		id++;
-		if (!id)
-			id++;
-	} while (id != saved);
+	} while (tee_ta_next_sess_id != saved);
 
 	return 0;
 }
@@ -607,14 +849,17 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 	s->ref_count = 1;
 
 	mutex_lock(&tee_ta_mutex);
+	mutex_lock(&tee_ta_sess_mutex);
 	s->id = new_session_id(open_sessions);
+	if (s->id)
+		sess_link(s, open_sessions);
+	mutex_unlock(&tee_ta_sess_mutex);
 	if (!s->id) {
 		res = TEE_ERROR_OVERFLOW;
-		goto err_mutex_unlock;
+		mutex_unlock(&tee_ta_mutex);
+		goto err_free;
 	}
 
-	TAILQ_INSERT_TAIL(open_sessions, s, link);
-
 	/* Look for already loaded TA */
 	res = tee_ta_init_session_with_context(s, uuid);
 	if (res == TEE_SUCCESS || res != TEE_ERROR_ITEM_NOT_FOUND) {
@@ -651,10 +896,10 @@ out:
 		return TEE_SUCCESS;
 	}
 
-	mutex_lock(&tee_ta_mutex);
-	TAILQ_REMOVE(open_sessions, s, link);
-err_mutex_unlock:
-	mutex_unlock(&tee_ta_mutex);
+	mutex_lock(&tee_ta_sess_mutex);
+	sess_unlink(s);
+	mutex_unlock(&tee_ta_sess_mutex);
+err_free:
 	free(s);
 	return res;
 }
@@ -703,7 +948,7 @@ TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 	ts_ctx = s->ts_sess.ctx;
 	ctx = ts_to_ta_ctx(ts_ctx);
 
-	if (tee_ta_try_set_busy(ctx)) {
+	if (tee_ta_try_set_busy(ctx, clnt_id)) {
 		if (!ctx->panicked) {
 			/* Save identity of the owner of the session */
 			s->clnt_id = *clnt_id;
@@ -767,7 +1012,7 @@ TEE_Result tee_ta_invoke_command(TEE_ErrorOrigin *err,
 	ts_ctx = sess->ts_sess.ctx;
 	ta_ctx = ts_to_ta_ctx(ts_ctx);
 
-	tee_ta_set_busy(ta_ctx);
+	tee_ta_set_busy(ta_ctx, clnt_id);
 
 	if (!ta_ctx->panicked) {
 		sess->param = param;
@@ -818,7 +1063,7 @@ static TEE_Result dump_ta_memstats(struct tee_ta_session *s,
 	if (ctx->is_initializing)
 		return TEE_ERROR_BAD_STATE;
 
-	if (tee_ta_try_set_busy(ctx)) {
+	if (tee_ta_try_set_busy(ctx, NSAPP_IDENTITY)) {
 		if (!ctx->panicked) {
 			s->param = param;
 			set_invoke_timeout(s, TEE_TIMEOUT_INFINITE);
@@ -849,6 +1094,7 @@ static void init_dump_ctx(struct tee_ta_dump_ctx *dump_ctx)
 	unsigned int n = 0;
 
 	nsec_sessions_list_head(&open_sessions);
+	mutex_lock(&tee_ta_sess_mutex);
 	/*
 	 * Scan all sessions opened from secure side by searching through
 	 * all available TA instances and for each context, scan all opened
@@ -877,6 +1123,7 @@ static void init_dump_ctx(struct tee_ta_dump_ctx *dump_ctx)
 		dump_ctx[n].sess_num = cnt;
 		n++;
 	}
+	mutex_unlock(&tee_ta_sess_mutex);
 }
 
 static TEE_Result dump_ta_stats(struct tee_ta_dump_ctx *dump_ctx,
@@ -987,6 +1234,58 @@ TEE_Result tee_ta_instance_stats(void *buf, size_t *buf_size)
 }
 #endif
 
+#if defined(CFG_WITH_STATS)
+TEE_Result tee_ta_busy_stats(void *buf, size_t *buf_size)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct pta_stats_ta_busy *st = NULL;
+	struct tee_ta_ctx *ctx = NULL;
+	size_t sz = 0;
+
+	if (!buf_size)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&tee_ta_mutex);
+
+	TAILQ_FOREACH(ctx, &tee_ctxes, link)
+		if (!(ctx->flags & TA_FLAG_CONCURRENT))
+			sz += sizeof(*st);
+
+	if (!sz) {
+		res = TEE_ERROR_ITEM_NOT_FOUND;
+	} else if (!buf || *buf_size < sz) {
+		*buf_size = sz;
+		res = TEE_ERROR_SHORT_BUFFER;
+	} else if (!IS_ALIGNED_WITH_TYPE(buf, uint32_t)) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+	} else {
+		st = buf;
+		TAILQ_FOREACH(ctx, &tee_ctxes, link) {
+			if (ctx->flags & TA_FLAG_CONCURRENT)
+				continue;
+			if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
+				lock_single_instance_stats();
+			mutex_lock(&ctx->busy_mutex);
+			st->uuid = ctx->ts_ctx.uuid;
+			st->queue_depth = ctx->busy_stats.queue_depth;
+			st->max_queue_depth = ctx->busy_stats.max_queue_depth;
+			st->waits = ctx->busy_stats.waits;
+			st->total_wait_ms = ctx->busy_stats.total_wait_ms;
+			st->max_wait_ms = ctx->busy_stats.max_wait_ms;
+			mutex_unlock(&ctx->busy_mutex);
+			if (ctx->flags & TA_FLAG_SINGLE_INSTANCE)
+				unlock_single_instance_stats();
+			st++;
+		}
+		*buf_size = sz;
+	}
+
+	mutex_unlock(&tee_ta_mutex);
+
+	return res;
+}
+#endif
+
 TEE_Result tee_ta_cancel_command(TEE_ErrorOrigin *err,
 				 struct tee_ta_session *sess,
 				 const TEE_Identity *clnt_id)
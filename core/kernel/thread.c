@@ -5,8 +5,10 @@
  * Copyright (c) 2020-2021, Arm Limited
  */
 
+#include <atomic.h>
 #include <config.h>
 #include <crypto/crypto.h>
+#include <io.h>
 #include <kernel/asan.h>
 #include <kernel/boot.h>
 #include <kernel/lockdep.h>
@@ -15,10 +17,14 @@
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <kernel/thread_private.h>
+#include <malloc.h>
 #include <mm/mobj.h>
 
 struct thread_ctx threads[CFG_NUM_THREADS];
 
+/* A set bit means that the thread context is in use */
+static uint32_t thread_busy_map[ROUNDUP_DIV(CFG_NUM_THREADS, 32)];
+
 struct thread_core_local thread_core_local[CFG_TEE_CORE_NB_CORE] __nex_bss;
 
 /*
@@ -45,7 +51,19 @@ DECLARE_STACK(stack_tmp, CFG_TEE_CORE_NB_CORE, STACK_TMP_SIZE,
 	      /* global linkage */);
 DECLARE_STACK(stack_abt, CFG_TEE_CORE_NB_CORE, STACK_ABT_SIZE, static);
 #ifndef CFG_WITH_PAGER
-DECLARE_STACK(stack_thread, CFG_NUM_THREADS, STACK_THREAD_SIZE, static);
+/*
+ * With virtualization the thread contexts are per guest while the heap
+ * isn't used before a guest has been assigned, so all stacks are static.
+ */
+#if defined(CFG_NS_VIRTUALIZATION)
+#define NUM_STATIC_THREAD_STACKS	CFG_NUM_THREADS
+#else
+#define NUM_STATIC_THREAD_STACKS	CFG_NUM_THREADS_PREALLOC
+#endif
+static_assert(NUM_STATIC_THREAD_STACKS > 0 &&
+	      NUM_STATIC_THREAD_STACKS <= CFG_NUM_THREADS);
+DECLARE_STACK(stack_thread, NUM_STATIC_THREAD_STACKS, STACK_THREAD_SIZE,
+	      static);
 #endif
 
 #define GET_STACK_BOTTOM(stack, n) ((vaddr_t)&(stack)[n] + sizeof(stack[n]) - \
@@ -130,7 +148,12 @@ void thread_init_canaries(void)
 
 	if (IS_ENABLED(CFG_WITH_STACK_CANARIES) &&
 	    !IS_ENABLED(CFG_WITH_PAGER) && !IS_ENABLED(CFG_NS_VIRTUALIZATION)) {
-		for (n = 0; n < CFG_NUM_THREADS; n++) {
+		/*
+		 * Stacks allocated by thread_alloc_stack() may be freed
+		 * concurrently by another CPU, their canaries are checked
+		 * by thread_free_stack() instead.
+		 */
+		for (n = 0; n < NUM_STATIC_THREAD_STACKS; n++) {
 			va = threads[n].stack_va_end;
 			if (va)
 				init_canaries(STACK_THREAD_SIZE, va);
@@ -203,7 +226,12 @@ void thread_check_canaries(void)
 
 	if (IS_ENABLED(CFG_WITH_STACK_CANARIES) &&
 	    !IS_ENABLED(CFG_WITH_PAGER) && !IS_ENABLED(CFG_NS_VIRTUALIZATION)) {
-		for (n = 0; n < CFG_NUM_THREADS; n++) {
+		/*
+		 * Stacks allocated by thread_alloc_stack() may be freed
+		 * concurrently by another CPU, their canaries are checked
+		 * by thread_free_stack() instead.
+		 */
+		for (n = 0; n < NUM_STATIC_THREAD_STACKS; n++) {
 			va = threads[n].stack_va_end;
 			if (va)
 				check_stack_canary("thread_stack", n,
@@ -265,6 +293,8 @@ static void print_stack_limits(void)
 
 	for (n = 0; n < CFG_NUM_THREADS; n++) {
 		va = threads[n].stack_va_end;
+		if (!va)
+			continue;
 		start = stack_end_va_to_top_soft(STACK_THREAD_SIZE, va);
 		end = stack_end_va_to_bottom(STACK_THREAD_SIZE, va);
 		DMSG("thr [%zu] 0x%" PRIxVA "..0x%" PRIxVA, n, start, end);
@@ -338,6 +368,7 @@ void thread_init_boot_thread(void)
 	thread_init_threads();
 
 	l->curr_thread = 0;
+	thread_busy_map[0] |= BIT(0);
 	threads[0].state = THREAD_STATE_ACTIVE;
 }
 
@@ -348,6 +379,7 @@ void __nostackcheck thread_clr_boot_thread(void)
 	assert(l->curr_thread >= 0 && l->curr_thread < CFG_NUM_THREADS);
 	assert(threads[l->curr_thread].state == THREAD_STATE_ACTIVE);
 	threads[l->curr_thread].state = THREAD_STATE_FREE;
+	thread_release_id(l->curr_thread);
 	l->curr_thread = THREAD_ID_INVALID;
 }
 
@@ -466,6 +498,97 @@ short int __noprof thread_get_id(void)
 	return ct;
 }
 
+short int thread_claim_id(void)
+{
+	uint32_t old = 0;
+	size_t bit = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(thread_busy_map); n++) {
+		old = atomic_load_u32(thread_busy_map + n);
+		while (~old) {
+			bit = __builtin_ctz(~old);
+			if (n * 32 + bit >= CFG_NUM_THREADS)
+				break;
+			/* On failure old is updated with the current value */
+			if (atomic_cas_u32(thread_busy_map + n, &old,
+					   old | BIT(bit)))
+				return n * 32 + bit;
+		}
+	}
+
+	return THREAD_ID_INVALID;
+}
+
+void thread_release_id(short int thread_id)
+{
+	uint32_t *p = thread_busy_map + thread_id / 32;
+	uint32_t mask = BIT(thread_id % 32);
+	uint32_t old = atomic_load_u32(p);
+
+	assert(thread_id >= 0 && thread_id < CFG_NUM_THREADS);
+	assert(old & mask);
+	while (!atomic_cas_u32(p, &old, old & ~mask))
+		;
+}
+
+#if !defined(CFG_WITH_PAGER) && NUM_STATIC_THREAD_STACKS < CFG_NUM_THREADS
+bool thread_alloc_stack(short int thread_id)
+{
+	size_t sz = stack_size_to_alloc_size(STACK_THREAD_SIZE);
+	uint8_t *p = NULL;
+	vaddr_t va = 0;
+
+	if (thread_id < NUM_STATIC_THREAD_STACKS)
+		return true;
+
+	assert(!threads[thread_id].stack_va_end);
+	p = memalign(STACK_ALIGNMENT, sz);
+	if (!p)
+		return false;
+
+	va = (vaddr_t)p + sz - STACK_CANARY_SIZE / 2;
+	if (IS_ENABLED(CFG_WITH_STACK_CANARIES))
+		init_canaries(STACK_THREAD_SIZE, va);
+	threads[thread_id].stack_va_end = va;
+
+	return true;
+}
+
+void thread_free_stack(short int thread_id)
+{
+	size_t sz = stack_size_to_alloc_size(STACK_THREAD_SIZE);
+	vaddr_t va = threads[thread_id].stack_va_end;
+
+	if (thread_id < NUM_STATIC_THREAD_STACKS)
+		return;
+
+	assert(va);
+	if (IS_ENABLED(CFG_WITH_STACK_CANARIES))
+		check_stack_canary("thread_stack", thread_id,
+				   STACK_THREAD_SIZE, va);
+	threads[thread_id].stack_va_end = 0;
+	free((void *)(va + STACK_CANARY_SIZE / 2 - sz));
+}
+#else
+bool thread_alloc_stack(short int thread_id __unused)
+{
+	return true;
+}
+
+void thread_free_stack(short int thread_id __unused)
+{
+}
+#endif
+
+bool thread_is_active(short int thread_id)
+{
+	if (thread_id < 0 || thread_id >= CFG_NUM_THREADS)
+		return false;
+
+	return READ_ONCE(threads[thread_id].state) == THREAD_STATE_ACTIVE;
+}
+
 #ifdef CFG_WITH_PAGER
 static void init_thread_stacks(void)
 {
@@ -509,8 +632,8 @@ static void init_thread_stacks(void)
 	vaddr_t va = 0;
 	size_t n = 0;
 
-	/* Assign the thread stacks */
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
+	/* Assign the static thread stacks */
+	for (n = 0; n < NUM_STATIC_THREAD_STACKS; n++) {
 		va = GET_STACK_BOTTOM(stack_thread, n);
 		threads[n].stack_va_end = va;
 		if (IS_ENABLED(CFG_WITH_STACK_CANARIES))
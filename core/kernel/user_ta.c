@@ -144,6 +144,385 @@ static void dec_recursion(void)
 	tsd->syscall_recursion--;
 }
 
+#ifdef CFG_TA_CONCURRENT
+static bool is_concurrent(struct user_ta_ctx *utc)
+{
+	return utc->ta_ctx.flags & TA_FLAG_CONCURRENT;
+}
+
+static bool has_memref_param(const struct tee_ta_param *p)
+{
+	size_t n = 0;
+
+	if (!p)
+		return false;
+
+	for (n = 0; n < TEE_NUM_PARAMS; n++) {
+		switch (TEE_PARAM_TYPE_GET(p->types, n)) {
+		case TEE_PARAM_TYPE_MEMREF_INPUT:
+		case TEE_PARAM_TYPE_MEMREF_OUTPUT:
+		case TEE_PARAM_TYPE_MEMREF_INOUT:
+			return true;
+		default:
+			break;
+		}
+	}
+
+	return false;
+}
+
+static bool is_entered_by_current_thread(struct user_ta_ctx *utc)
+{
+	struct thread_specific_data *tsd = thread_get_tsd();
+	struct ts_session *s = NULL;
+
+	TAILQ_FOREACH(s, &tsd->sess_stack, link_tsd)
+		if (s->ctx == &utc->ta_ctx.ts_ctx)
+			return true;
+
+	return false;
+}
+
+static void lock_scall(struct user_ta_ctx *utc)
+{
+	if (is_concurrent(utc))
+		mutex_lock(&utc->scall_mutex);
+}
+
+static void unlock_scall(struct user_ta_ctx *utc)
+{
+	if (is_concurrent(utc))
+		mutex_unlock(&utc->scall_mutex);
+}
+
+/*
+ * A TA calling another TA holds its system call mutex. It's released
+ * while the called TA executes or two concurrent TAs calling each other
+ * could deadlock. The bounce buffer of the caller isn't in use at this
+ * point.
+ *
+ * Meanwhile other invocations of the caller may unmap or change the
+ * protection of its memory. Ranges checked by this thread are only
+ * forgotten when the thread changes a mapping itself, so the access
+ * cache is reset when the mutex is released and taken again.
+ */
+static struct mutex *release_caller_scall_mutex(void)
+{
+	struct ts_session *s = ts_get_current_session_may_fail();
+	struct mutex *m = NULL;
+
+	if (!s)
+		return NULL;
+
+	m = user_ta_scall_mutex(s->ctx);
+	if (!m || !mutex_is_locked(m) || m->owner != thread_get_id())
+		return NULL;
+
+	vm_access_cache_reset();
+	mutex_unlock(m);
+	return m;
+}
+
+static void reacquire_caller_scall_mutex(struct mutex *m)
+{
+	if (m) {
+		mutex_lock(m);
+		vm_access_cache_reset();
+	}
+}
+
+static size_t get_main_stack_size(struct user_ta_ctx *utc)
+{
+	vaddr_t sp = utc->uctx.stack_ptr;
+	struct vm_region *r = NULL;
+
+	TAILQ_FOREACH(r, &utc->uctx.vm_info.regions, link)
+		if (sp > r->va && sp <= r->va + r->size)
+			return r->size;
+
+	return 0;
+}
+
+static struct user_ta_stack *alloc_stack(struct user_ta_ctx *utc, size_t sz)
+{
+	uint32_t prot = TEE_MATTR_URW | TEE_MATTR_PRW;
+	struct user_ta_stack *stack = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	struct mobj *mobj = NULL;
+	struct fobj *fobj = NULL;
+	vaddr_t va = 0;
+
+	stack = calloc(1, sizeof(*stack));
+	if (!stack)
+		return NULL;
+
+	fobj = fobj_ta_mem_alloc(sz / SMALL_PAGE_SIZE);
+	mobj = mobj_with_fobj_alloc(fobj, NULL, TEE_MATTR_MEM_TYPE_TAGGED);
+	fobj_put(fobj);
+	if (!mobj)
+		goto err;
+
+	/* Keep an unmapped guard page below the stack */
+	res = vm_map_pad(&utc->uctx, &va, sz, prot, 0, mobj, 0,
+			 SMALL_PAGE_SIZE, 0, 0);
+	mobj_put(mobj);
+	if (res)
+		goto err;
+
+	stack->stack_ptr = va + sz;
+	return stack;
+err:
+	free(stack);
+	return NULL;
+}
+
+/*
+ * Allocates the extra stacks, as large as the main stack set up by
+ * ldelf. Called by an entry which is alone in the TA so the memory
+ * mappings can be updated without affecting other cores.
+ */
+static void fill_stack_pool(struct user_ta_ctx *utc)
+{
+	struct user_ta_stack *stack = NULL;
+	size_t sz = 0;
+
+	if (utc->num_stacks >= CFG_TA_CONCURRENT_STACKS)
+		return;
+
+	sz = get_main_stack_size(utc);
+	if (!sz)
+		return;
+
+	while (utc->num_stacks < CFG_TA_CONCURRENT_STACKS) {
+		stack = alloc_stack(utc, sz);
+		if (!stack) {
+			DMSG("Can't allocate extra stack for concurrent TA");
+			return;
+		}
+
+		mutex_lock(&utc->enter_mutex);
+		SLIST_INSERT_HEAD(&utc->free_stacks, stack, link);
+		utc->num_stacks++;
+		mutex_unlock(&utc->enter_mutex);
+	}
+}
+
+/*
+ * Invocations with only value parameters share the TA, each with a stack
+ * of its own. Everything else, including invocations with memory
+ * references which need to update the memory mappings of the TA, enters
+ * alone. Waiting exclusive entries have precedence over new shared
+ * entries.
+ */
+static TEE_Result enter_gate(struct user_ta_ctx *utc,
+			     enum utee_entry_func func,
+			     const struct tee_ta_param *param,
+			     struct user_ta_stack **stack)
+{
+	TEE_Result res = TEE_SUCCESS;
+	bool excl = false;
+
+	if (!is_concurrent(utc))
+		return TEE_SUCCESS;
+
+	/*
+	 * Entering again from the same thread would deadlock or clobber
+	 * the state of the outer invocation.
+	 */
+	if (is_entered_by_current_thread(utc))
+		return TEE_ERROR_BUSY;
+
+	excl = func != UTEE_ENTRY_FUNC_INVOKE_COMMAND ||
+	       has_memref_param(param);
+
+	mutex_lock(&utc->enter_mutex);
+	if (excl)
+		utc->excl_waiting++;
+	while (true) {
+		if (utc->ta_ctx.panicked) {
+			res = TEE_ERROR_TARGET_DEAD;
+			break;
+		}
+		if (excl) {
+			if (!utc->enter_count)
+				break;
+		} else if (!utc->enter_excl && !utc->excl_waiting) {
+			if (!utc->main_stack_busy)
+				break;
+			*stack = SLIST_FIRST(&utc->free_stacks);
+			if (*stack) {
+				SLIST_REMOVE_HEAD(&utc->free_stacks, link);
+				break;
+			}
+		}
+		condvar_wait(&utc->enter_cv, &utc->enter_mutex);
+	}
+	if (excl)
+		utc->excl_waiting--;
+	if (!res) {
+		utc->enter_count++;
+		utc->enter_excl = excl;
+		if (!*stack)
+			utc->main_stack_busy = true;
+	}
+	mutex_unlock(&utc->enter_mutex);
+
+	if (!res && excl)
+		fill_stack_pool(utc);
+
+	return res;
+}
+
+static void exit_gate(struct user_ta_ctx *utc, struct user_ta_stack *stack)
+{
+	if (!is_concurrent(utc))
+		return;
+
+	mutex_lock(&utc->enter_mutex);
+	if (stack)
+		SLIST_INSERT_HEAD(&utc->free_stacks, stack, link);
+	else
+		utc->main_stack_busy = false;
+	assert(utc->enter_count);
+	utc->enter_count--;
+	utc->enter_excl = false;
+	condvar_broadcast(&utc->enter_cv);
+	mutex_unlock(&utc->enter_mutex);
+}
+
+/* Waits until no invocation is executing in the TA anymore */
+static void wait_until_idle(struct user_ta_ctx *utc)
+{
+	struct mutex *caller_m = NULL;
+
+	if (!is_concurrent(utc))
+		return;
+
+	caller_m = release_caller_scall_mutex();
+
+	mutex_lock(&utc->enter_mutex);
+	while (utc->enter_count)
+		condvar_wait(&utc->enter_cv, &utc->enter_mutex);
+	mutex_unlock(&utc->enter_mutex);
+
+	reacquire_caller_scall_mutex(caller_m);
+}
+
+static vaddr_t get_stack_ptr(struct user_ta_ctx *utc,
+			     struct user_ta_stack *stack)
+{
+	if (stack)
+		return stack->stack_ptr;
+	return utc->uctx.stack_ptr;
+}
+
+static void set_user_vfp(struct ts_session *s __maybe_unused,
+			 struct user_ta_stack *stack __maybe_unused)
+{
+#ifdef CFG_WITH_VFP
+	if (stack)
+		s->user_vfp = &stack->vfp;
+#endif
+}
+
+static void clear_user_vfp(struct user_ta_ctx *utc, struct ts_session *s,
+			   struct user_ta_stack *stack)
+{
+	if (!stack) {
+		thread_user_clear_vfp(&utc->uctx);
+		return;
+	}
+
+#ifdef CFG_WITH_VFP
+	thread_user_clear_vfp_state(&stack->vfp);
+	s->user_vfp = NULL;
+#endif
+}
+
+static void init_concurrency(struct user_ta_ctx *utc)
+{
+	mutex_init(&utc->enter_mutex);
+	condvar_init(&utc->enter_cv);
+	mutex_init(&utc->scall_mutex);
+	SLIST_INIT(&utc->free_stacks);
+}
+
+static void final_concurrency(struct user_ta_ctx *utc)
+{
+	struct user_ta_stack *stack = NULL;
+
+	/* The stacks are unmapped with the rest of the TA */
+	while (!SLIST_EMPTY(&utc->free_stacks)) {
+		stack = SLIST_FIRST(&utc->free_stacks);
+		SLIST_REMOVE_HEAD(&utc->free_stacks, link);
+		free(stack);
+	}
+	mutex_destroy(&utc->scall_mutex);
+	condvar_destroy(&utc->enter_cv);
+	mutex_destroy(&utc->enter_mutex);
+}
+#else
+static void lock_scall(struct user_ta_ctx *utc __unused)
+{
+}
+
+static void unlock_scall(struct user_ta_ctx *utc __unused)
+{
+}
+
+static struct mutex *release_caller_scall_mutex(void)
+{
+	return NULL;
+}
+
+static void reacquire_caller_scall_mutex(struct mutex *m __unused)
+{
+}
+
+static TEE_Result enter_gate(struct user_ta_ctx *utc __unused,
+			     enum utee_entry_func func __unused,
+			     const struct tee_ta_param *param __unused,
+			     struct user_ta_stack **stack __unused)
+{
+	return TEE_SUCCESS;
+}
+
+static void exit_gate(struct user_ta_ctx *utc __unused,
+		      struct user_ta_stack *stack __unused)
+{
+}
+
+static void wait_until_idle(struct user_ta_ctx *utc __unused)
+{
+}
+
+static vaddr_t get_stack_ptr(struct user_ta_ctx *utc,
+			     struct user_ta_stack *stack __unused)
+{
+	return utc->uctx.stack_ptr;
+}
+
+static void set_user_vfp(struct ts_session *s __unused,
+			 struct user_ta_stack *stack __unused)
+{
+}
+
+static void clear_user_vfp(struct user_ta_ctx *utc,
+			   struct ts_session *s __unused,
+			   struct user_ta_stack *stack __unused)
+{
+	thread_user_clear_vfp(&utc->uctx);
+}
+
+static void init_concurrency(struct user_ta_ctx *utc __unused)
+{
+}
+
+static void final_concurrency(struct user_ta_ctx *utc __unused)
+{
+}
+#endif /*CFG_TA_CONCURRENT*/
+
 static TEE_Result user_ta_enter(struct ts_session *session,
 				enum utee_entry_func func, uint32_t cmd)
 {
@@ -154,24 +533,36 @@ static TEE_Result user_ta_enter(struct ts_session *session,
 	struct tee_ta_session *ta_sess = to_ta_session(session);
 	struct ts_session *ts_sess __maybe_unused = NULL;
 	void *param_va[TEE_NUM_PARAMS] = { NULL };
+	struct user_ta_stack *stack = NULL;
+	struct mutex *caller_m = NULL;
 
 	if (!inc_recursion()) {
 		/* Using this error code since we've run out of resources. */
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto out_clr_cancel;
 	}
+
+	caller_m = release_caller_scall_mutex();
+	res = enter_gate(utc, func, ta_sess->param, &stack);
+	if (res)
+		goto out;
+
+	lock_scall(utc);
 	if (ta_sess->param) {
 		/* Map user space memory */
 		res = vm_map_param(&utc->uctx, ta_sess->param, param_va);
-		if (res != TEE_SUCCESS)
+		if (res != TEE_SUCCESS) {
+			unlock_scall(utc);
+			exit_gate(utc, stack);
 			goto out;
+		}
 	}
 
 	/* Switch to user ctx */
 	ts_push_current_session(session);
 
 	/* Make room for usr_params at top of stack */
-	usr_stack = utc->uctx.stack_ptr;
+	usr_stack = get_stack_ptr(utc, stack);
 	usr_stack -= ROUNDUP(sizeof(struct utee_params), STACK_ALIGNMENT);
 	usr_params = (struct utee_params *)usr_stack;
 	if (ta_sess->param)
@@ -182,13 +573,17 @@ static TEE_Result user_ta_enter(struct ts_session *session,
 	if (res)
 		goto out_pop_session;
 
+	set_user_vfp(session, stack);
+	unlock_scall(utc);
+
 	res = thread_enter_user_mode(func, kaddr_to_uref(session),
 				     (vaddr_t)usr_params, cmd, usr_stack,
 				     utc->uctx.entry_func, utc->uctx.is_32bit,
 				     &utc->ta_ctx.panicked,
 				     &utc->ta_ctx.panic_code);
 
-	thread_user_clear_vfp(&utc->uctx);
+	clear_user_vfp(utc, session, stack);
+	lock_scall(utc);
 
 	if (utc->ta_ctx.panicked) {
 		abort_print_current_ts();
@@ -216,10 +611,15 @@ out_pop_session:
 		 */
 		vm_clean_param(&utc->uctx);
 	}
+	unlock_scall(utc);
+	reacquire_caller_scall_mutex(caller_m);
+	caller_m = NULL;
 	ts_sess = ts_pop_current_session();
 	assert(ts_sess == session);
+	exit_gate(utc, stack);
 
 out:
+	reacquire_caller_scall_mutex(caller_m);
 	dec_recursion();
 out_clr_cancel:
 	/*
@@ -389,12 +789,20 @@ static void release_utc_state(struct user_ta_ctx *utc)
 static void free_utc(struct user_ta_ctx *utc)
 {
 	release_utc_state(utc);
+	final_concurrency(utc);
 	free(utc);
 }
 
 static void user_ta_release_state(struct ts_ctx *ctx)
 {
-	release_utc_state(to_user_ta_ctx(ctx));
+	struct user_ta_ctx *utc = to_user_ta_ctx(ctx);
+
+	/*
+	 * Other invocations of a concurrent TA may still be executing,
+	 * they notice that the TA has panicked once they return.
+	 */
+	wait_until_idle(utc);
+	release_utc_state(utc);
 }
 
 static void user_ta_ctx_destroy(struct ts_ctx *ctx)
@@ -472,7 +880,8 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 	TAILQ_INIT(&utc->cryp_states);
 	TAILQ_INIT(&utc->objects);
 	TAILQ_INIT(&utc->storage_enums);
-	condvar_init(&utc->ta_ctx.busy_cv);
+	tee_ta_ctx_init_busy(&utc->ta_ctx);
+	init_concurrency(utc);
 	utc->ta_ctx.ref_count = 1;
 
 	/*
@@ -484,7 +893,6 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 	utc->ta_ctx.ts_ctx.uuid = *uuid;
 	res = vm_info_init(&utc->uctx, &utc->ta_ctx.ts_ctx);
 	if (res) {
-		condvar_destroy(&utc->ta_ctx.busy_cv);
 		free_utc(utc);
 		return res;
 	}
@@ -533,7 +941,6 @@ TEE_Result tee_ta_complete_user_ta_session(struct tee_ta_session *s)
 	} else {
 		s->ts_sess.ctx = NULL;
 		TAILQ_REMOVE(&tee_ctxes, &utc->ta_ctx, link);
-		condvar_destroy(&utc->ta_ctx.busy_cv);
 		free_utc(utc);
 	}
 
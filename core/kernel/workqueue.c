@@ -0,0 +1,373 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <atomic.h>
+#include <initcall.h>
+#include <kernel/callout.h>
+#include <kernel/delay.h>
+#include <kernel/misc.h>
+#include <kernel/notif.h>
+#include <kernel/panic.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <kernel/virtualization.h>
+#include <kernel/workqueue.h>
+#include <mm/core_memprot.h>
+#include <util.h>
+
+#define WORK_IDLE	0
+
+/*
+ * struct work_cpu_queue - per-CPU queue of pending work
+ * @lock:	protects the fields below and the pending works
+ * @seq:	sequence number of the last work queued
+ * @head:	pending works, in the order they were queued
+ * @stats:	statistics of the works queued on this queue
+ */
+struct work_cpu_queue {
+	unsigned int lock;
+	uint32_t seq;
+	TAILQ_HEAD(work_head, work) head;
+	struct workqueue_stats stats;
+};
+
+/*
+ * struct wq_guest_data - per-guest state
+ * @bh_requested: non-zero if a bottom half has been requested and
+ *		  hasn't started executing work yet
+ */
+struct wq_guest_data {
+	unsigned int bh_requested;
+};
+
+static struct work_cpu_queue work_queues[CFG_TEE_CORE_NB_CORE] __nex_bss;
+static struct wq_guest_data default_wq_guest_data __nex_bss;
+static unsigned int wq_guest_data_id __nex_bss;
+static uint32_t wq_bh_requests __nex_bss;
+static uint32_t wq_bh_runs __nex_bss;
+
+static struct wq_guest_data *get_guest_data(struct guest_partition *prtn)
+{
+	if (IS_ENABLED(CFG_NS_VIRTUALIZATION))
+		return virt_get_guest_spec_data(prtn, wq_guest_data_id);
+	return &default_wq_guest_data;
+}
+
+static uint64_t read_cnt(void)
+{
+#ifdef CFG_CORE_HAS_GENERIC_TIMER
+	return delay_cnt_read();
+#else
+	return 0;
+#endif
+}
+
+static uint32_t cnt_to_us(uint64_t cnt __maybe_unused)
+{
+#ifdef CFG_CORE_HAS_GENERIC_TIMER
+	return MIN(cnt * 1000000 / delay_cnt_freq(), (uint64_t)UINT32_MAX);
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Asks normal world to deliver a bottom half to @guest_id unless one
+ * already has been requested, this lets all work queued until the bottom
+ * half starts share a single run.
+ */
+static void request_bh(uint16_t guest_id)
+{
+	struct guest_partition *prtn = virt_get_guest(guest_id);
+	struct wq_guest_data *gd = get_guest_data(prtn);
+	unsigned int oval = 0;
+
+	if (gd && atomic_cas_uint(&gd->bh_requested, &oval, 1)) {
+		atomic_inc32(&wq_bh_requests);
+		notif_send_async(NOTIF_VALUE_DO_BOTTOM_HALF, guest_id);
+	}
+
+	virt_put_guest(prtn);
+}
+
+void work_init(struct work *work, void (*func)(struct work *work))
+{
+	assert(is_nexus(work) && is_unpaged(work));
+	*work = (struct work){ .func = func, };
+}
+
+bool work_queue(struct work *work, uint16_t guest_id)
+{
+	struct work_cpu_queue *q = NULL;
+	unsigned int oval = WORK_IDLE;
+	uint32_t exceptions = 0;
+	bool queued = false;
+	size_t pos = 0;
+
+	exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	pos = get_core_pos();
+	q = work_queues + pos;
+	cpu_spin_lock(&q->lock);
+
+	if (atomic_cas_uint(&work->state, &oval, pos + 1)) {
+		q->seq++;
+		work->seq = q->seq;
+		work->guest_id = guest_id;
+		work->queued_cnt = read_cnt();
+		TAILQ_INSERT_TAIL(&q->head, work, link);
+		q->stats.queued++;
+		q->stats.pending++;
+		queued = true;
+	}
+
+	cpu_spin_unlock(&q->lock);
+	thread_unmask_exceptions(exceptions);
+
+	if (queued)
+		request_bh(guest_id);
+
+	return queued;
+}
+DECLARE_KEEP_PAGER(work_queue);
+
+bool work_cancel(struct work *work)
+{
+	struct work_cpu_queue *q = NULL;
+	uint32_t exceptions = 0;
+	unsigned int state = 0;
+	bool ret = false;
+
+	while (!ret) {
+		state = atomic_load_uint(&work->state);
+		if (state == WORK_IDLE)
+			return false;
+
+		/*
+		 * The state only changes while the queue lock is held so
+		 * if it's unchanged once the lock is taken the work is
+		 * still in this queue.
+		 */
+		q = work_queues + state - 1;
+		exceptions = cpu_spin_lock_xsave(&q->lock);
+		if (atomic_load_uint(&work->state) == state) {
+			TAILQ_REMOVE(&q->head, work, link);
+			atomic_store_uint(&work->state, WORK_IDLE);
+			q->stats.pending--;
+			q->stats.cancelled++;
+			ret = true;
+		}
+		cpu_spin_unlock_xrestore(&q->lock, exceptions);
+	}
+
+	return true;
+}
+
+#ifdef CFG_CALLOUT
+static bool delayed_work_cb(struct callout *co)
+{
+	struct delayed_work *dwork = container_of(co, struct delayed_work,
+						  callout);
+
+	atomic_store_uint(&dwork->armed, 0);
+	work_queue(&dwork->work, dwork->work.guest_id);
+
+	return false;
+}
+DECLARE_KEEP_PAGER(delayed_work_cb);
+#endif
+
+void delayed_work_init(struct delayed_work *dwork,
+		       void (*func)(struct work *work))
+{
+	assert(is_nexus(dwork) && is_unpaged(dwork));
+	*dwork = (struct delayed_work){ .work = { .func = func, }, };
+}
+
+TEE_Result work_queue_delayed(struct delayed_work *dwork __maybe_unused,
+			      uint16_t guest_id __maybe_unused,
+			      uint32_t ms __maybe_unused)
+{
+#ifdef CFG_CALLOUT
+	unsigned int oval = 0;
+
+	if (atomic_load_uint(&dwork->work.state) != WORK_IDLE ||
+	    !atomic_cas_uint(&dwork->armed, &oval, 1))
+		return TEE_ERROR_BUSY;
+
+	/* Not pending, so the callout is the only one to read this */
+	dwork->work.guest_id = guest_id;
+	callout_add(&dwork->callout, delayed_work_cb, ms);
+
+	return TEE_SUCCESS;
+#else
+	return TEE_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+bool work_cancel_delayed(struct delayed_work *dwork)
+{
+	unsigned int oval = 1;
+	bool ret = false;
+
+#ifdef CFG_CALLOUT
+	callout_rem(&dwork->callout);
+#endif
+	/* If the callout had expired already the work may be pending */
+	ret = atomic_cas_uint(&dwork->armed, &oval, 0);
+	if (work_cancel(&dwork->work))
+		ret = true;
+
+	return ret;
+}
+
+/*
+ * Executes the works for @guest_id queued on @q before this call. Works
+ * queued again while executing, possibly by their own callback, are left
+ * for the next bottom half which then already has been requested.
+ */
+static unsigned int run_queue(struct work_cpu_queue *q, uint16_t guest_id)
+{
+	void (*func)(struct work *work) = NULL;
+	struct work *work = NULL;
+	unsigned int count = 0;
+	uint32_t exceptions = 0;
+	uint32_t seq_end = 0;
+	uint32_t us = 0;
+
+	exceptions = cpu_spin_lock_xsave(&q->lock);
+	seq_end = q->seq;
+	cpu_spin_unlock_xrestore(&q->lock, exceptions);
+
+	while (true) {
+		exceptions = cpu_spin_lock_xsave(&q->lock);
+
+		TAILQ_FOREACH(work, &q->head, link) {
+			if ((int32_t)(work->seq - seq_end) > 0) {
+				work = NULL;
+				break;
+			}
+			if (!IS_ENABLED(CFG_NS_VIRTUALIZATION) ||
+			    work->guest_id == guest_id)
+				break;
+		}
+
+		if (work) {
+			TAILQ_REMOVE(&q->head, work, link);
+			func = work->func;
+			us = cnt_to_us(read_cnt() - work->queued_cnt);
+			q->stats.pending--;
+			q->stats.executed++;
+			q->stats.total_latency_us += us;
+			q->stats.max_latency_us = MAX(q->stats.max_latency_us,
+						      us);
+			/* From here the work may be queued again */
+			atomic_store_uint(&work->state, WORK_IDLE);
+		}
+
+		cpu_spin_unlock_xrestore(&q->lock, exceptions);
+
+		if (!work)
+			return count;
+
+		func(work);
+		count++;
+	}
+}
+
+static void wq_atomic_cb(struct notif_driver *ndrv __unused,
+			 enum notif_event ev, uint16_t guest_id)
+{
+	struct guest_partition *prtn = NULL;
+	struct wq_guest_data *gd = NULL;
+
+	if (ev != NOTIF_EVENT_STARTED)
+		return;
+
+	/* Work queued before notifications were started is waiting */
+	prtn = virt_get_guest(guest_id);
+	gd = get_guest_data(prtn);
+	if (gd && atomic_load_uint(&gd->bh_requested))
+		notif_send_async(NOTIF_VALUE_DO_BOTTOM_HALF, guest_id);
+	virt_put_guest(prtn);
+}
+DECLARE_KEEP_PAGER(wq_atomic_cb);
+
+static void wq_yielding_cb(struct notif_driver *ndrv __unused,
+			   enum notif_event ev)
+{
+	struct guest_partition *prtn = NULL;
+	struct wq_guest_data *gd = NULL;
+	unsigned int count = 0;
+	size_t n = 0;
+
+	if (ev != NOTIF_EVENT_DO_BOTTOM_HALF)
+		return;
+
+	/*
+	 * Clear the request before looking at the queues, work queued
+	 * after this point requests a new bottom half.
+	 */
+	prtn = virt_get_current_guest();
+	gd = get_guest_data(prtn);
+	if (gd)
+		atomic_store_uint(&gd->bh_requested, 0);
+	virt_put_guest(prtn);
+
+	for (n = 0; n < ARRAY_SIZE(work_queues); n++)
+		count += run_queue(work_queues + n,
+				   virt_get_current_guest_id());
+
+	if (count)
+		atomic_inc32(&wq_bh_runs);
+}
+
+static struct notif_driver wq_notif_driver __nex_data = {
+	.atomic_cb = wq_atomic_cb,
+	.yielding_cb = wq_yielding_cb,
+};
+
+void workqueue_get_stats(struct workqueue_stats *stats)
+{
+	struct work_cpu_queue *q = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	*stats = (struct workqueue_stats){
+		.bh_requests = atomic_load_u32(&wq_bh_requests),
+		.bh_runs = atomic_load_u32(&wq_bh_runs),
+	};
+
+	for (n = 0; n < ARRAY_SIZE(work_queues); n++) {
+		q = work_queues + n;
+		exceptions = cpu_spin_lock_xsave(&q->lock);
+		stats->queued += q->stats.queued;
+		stats->executed += q->stats.executed;
+		stats->cancelled += q->stats.cancelled;
+		stats->pending += q->stats.pending;
+		stats->total_latency_us += q->stats.total_latency_us;
+		stats->max_latency_us = MAX(stats->max_latency_us,
+					    q->stats.max_latency_us);
+		cpu_spin_unlock_xrestore(&q->lock, exceptions);
+	}
+}
+
+static TEE_Result workqueue_init(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(work_queues); n++)
+		TAILQ_INIT(&work_queues[n].head);
+
+	if (IS_ENABLED(CFG_NS_VIRTUALIZATION) &&
+	    virt_add_guest_spec_data(&wq_guest_data_id,
+				     sizeof(struct wq_guest_data), NULL))
+		panic("virt_add_guest_spec_data");
+
+	notif_register_driver(&wq_notif_driver);
+
+	return TEE_SUCCESS;
+}
+nex_early_init(workqueue_init);
@@ -8,7 +8,10 @@
 #include <crypto/internal_aes-gcm.h>
 #include <initcall.h>
 #include <kernel/boot.h>
+#include <kernel/delay.h>
 #include <kernel/panic.h>
+#include <kernel/spinlock.h>
+#include <malloc.h>
 #include <memtag.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
@@ -81,29 +84,22 @@ static void fobj_uninit(struct fobj *fobj)
 	tee_pager_invalidate_fobj(fobj);
 }
 
-static TEE_Result rwp_load_page(void *va, struct rwp_state *state,
-				const uint8_t *src)
+static TEE_Result rwp_decrypt(struct rwp_state *state, const void *aad,
+			      size_t aad_len, const uint8_t *src, size_t len,
+			      void *dst)
 {
 	struct rwp_aes_gcm_iv iv = {
 		.iv = { (vaddr_t)state, state->iv >> 32, state->iv }
 	};
 
-	if (!state->iv) {
-		/*
-		 * IV still zero which means that this is previously unused
-		 * page.
-		 */
-		memset(va, 0, SMALL_PAGE_SIZE);
-		return TEE_SUCCESS;
-	}
-
 	return internal_aes_gcm_dec(&rwp_ae_key, &iv, sizeof(iv),
-				    NULL, 0, src, SMALL_PAGE_SIZE, va,
+				    aad, aad_len, src, len, dst,
 				    state->tag, sizeof(state->tag));
 }
 
-static TEE_Result rwp_save_page(const void *va, struct rwp_state *state,
-				uint8_t *dst)
+static TEE_Result rwp_encrypt(struct rwp_state *state, const void *aad,
+			      size_t aad_len, const void *src, size_t len,
+			      uint8_t *dst)
 {
 	size_t tag_len = sizeof(state->tag);
 	struct rwp_aes_gcm_iv iv = { };
@@ -123,10 +119,31 @@ static TEE_Result rwp_save_page(const void *va, struct rwp_state *state,
 	iv.iv[2] = state->iv;
 
 	return internal_aes_gcm_enc(&rwp_ae_key, &iv, sizeof(iv),
-				    NULL, 0, va, SMALL_PAGE_SIZE, dst,
+				    aad, aad_len, src, len, dst,
 				    state->tag, &tag_len);
 }
 
+static TEE_Result rwp_load_page(void *va, struct rwp_state *state,
+				const uint8_t *src)
+{
+	if (!state->iv) {
+		/*
+		 * IV still zero which means that this is previously unused
+		 * page.
+		 */
+		memset(va, 0, SMALL_PAGE_SIZE);
+		return TEE_SUCCESS;
+	}
+
+	return rwp_decrypt(state, NULL, 0, src, SMALL_PAGE_SIZE, va);
+}
+
+static TEE_Result rwp_save_page(const void *va, struct rwp_state *state,
+				uint8_t *dst)
+{
+	return rwp_encrypt(state, NULL, 0, va, SMALL_PAGE_SIZE, dst);
+}
+
 static struct rwp_state_padded *idx_to_state_padded(size_t idx)
 {
 	assert(rwp_state_base);
@@ -357,6 +374,420 @@ __weak __relrodata_unpaged("ops_rwp_unpaged_iv") = {
 	.save_page = rwp_unpaged_iv_save_page,
 };
 
+#ifdef CFG_CORE_RWP_COMPRESS
+/*
+ * Compressed store for R/W paged pages
+ *
+ * Each saved page is compressed, encrypted and stored in a buffer of the
+ * compressed size allocated from a pool of TA RAM which grows on demand.
+ * Pages which don't compress are stored as is. The length of the stored
+ * data is authenticated together with it.
+ *
+ * If the pool can't grow when a page is saved, the previous buffer of the
+ * page is reused if the new data fits. Otherwise the page is stored
+ * uncompressed in a page of TA RAM of its own, the layout used by
+ * rwp_unpaged_iv_save_page(). The previous copy is only released once
+ * the new one has been stored.
+ *
+ * The compression is a run-length encoding of zero 64-bit words, tuned
+ * for zero initialized heap and sparsely used stacks. The encoded page is
+ * a sequence of tokens where a token byte t < 0x80 represents t + 1 zero
+ * words and t >= 0x80 is followed by (t & 0x7f) + 1 literal words.
+ */
+#define RWP_COMPR_MAX_RUN	0x80
+#define RWP_COMPR_LITERAL	0x80
+#define RWP_COMPR_NUM_WORDS	(SMALL_PAGE_SIZE / sizeof(uint64_t))
+/* Number of pages the pool grows with when exhausted */
+#define RWP_COMPR_POOL_GROW	16
+
+struct rwp_compr_state {
+	struct rwp_state state;
+	uint8_t *data;
+	/* Set if @data is a page of its own instead of from the pool */
+	tee_mm_entry_t *mm;
+	uint32_t len;
+};
+
+struct fobj_rwp_compr {
+	struct rwp_compr_state *state;
+	struct fobj fobj;
+};
+
+const struct fobj_ops ops_rwp_compr;
+
+static unsigned int rwp_compr_lock = SPINLOCK_UNLOCK;
+static struct malloc_ctx *rwp_compr_ctx;
+/* Scratch page used for compressed data in clear text */
+static uint8_t *rwp_compr_buf;
+
+#ifdef CFG_WITH_STATS
+static struct fobj_compr_stats rwp_compr_stats;
+/* Counter ticks spent decompressing since last stats dump */
+static uint64_t rwp_compr_load_cnt;
+#endif
+
+static size_t rwp_compress(const uint64_t *src, uint8_t *dst)
+{
+	size_t olen = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	while (n < RWP_COMPR_NUM_WORDS) {
+		m = n + 1;
+		if (!src[n]) {
+			while (m < RWP_COMPR_NUM_WORDS &&
+			       m - n < RWP_COMPR_MAX_RUN && !src[m])
+				m++;
+			if (olen + 1 >= SMALL_PAGE_SIZE)
+				return SMALL_PAGE_SIZE;
+			dst[olen] = m - n - 1;
+			olen++;
+		} else {
+			while (m < RWP_COMPR_NUM_WORDS &&
+			       m - n < RWP_COMPR_MAX_RUN && src[m])
+				m++;
+			if (olen + 1 + (m - n) * sizeof(uint64_t) >=
+			    SMALL_PAGE_SIZE)
+				return SMALL_PAGE_SIZE;
+			dst[olen] = RWP_COMPR_LITERAL | (m - n - 1);
+			olen++;
+			memcpy(dst + olen, src + n, (m - n) * sizeof(uint64_t));
+			olen += (m - n) * sizeof(uint64_t);
+		}
+		n = m;
+	}
+
+	return olen;
+}
+
+static TEE_Result rwp_decompress(const uint8_t *src, size_t len,
+				 uint64_t *dst)
+{
+	size_t ilen = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	while (ilen < len) {
+		m = (src[ilen] & ~RWP_COMPR_LITERAL) + 1;
+		if (m > RWP_COMPR_NUM_WORDS - n)
+			return TEE_ERROR_CORRUPT_OBJECT;
+		if (src[ilen] & RWP_COMPR_LITERAL) {
+			ilen++;
+			if (m * sizeof(uint64_t) > len - ilen)
+				return TEE_ERROR_CORRUPT_OBJECT;
+			memcpy(dst + n, src + ilen, m * sizeof(uint64_t));
+			ilen += m * sizeof(uint64_t);
+		} else {
+			ilen++;
+			memset(dst + n, 0, m * sizeof(uint64_t));
+		}
+		n += m;
+	}
+
+	if (n != RWP_COMPR_NUM_WORDS)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	return TEE_SUCCESS;
+}
+
+static uint64_t rwp_compr_read_cnt(void)
+{
+#ifdef CFG_CORE_HAS_GENERIC_TIMER
+	return delay_cnt_read();
+#else
+	return 0;
+#endif
+}
+
+static void rwp_compr_update_stats(struct rwp_compr_state *st, size_t len,
+				   bool add)
+{
+#ifdef CFG_WITH_STATS
+	if (!st->data)
+		return;
+
+	if (add) {
+		rwp_compr_stats.pages++;
+		rwp_compr_stats.bytes += len;
+		if (st->mm)
+			rwp_compr_stats.pool_size += SMALL_PAGE_SIZE;
+	} else {
+		rwp_compr_stats.pages--;
+		rwp_compr_stats.bytes -= len;
+		if (st->mm)
+			rwp_compr_stats.pool_size -= SMALL_PAGE_SIZE;
+	}
+#else
+	(void)st;
+	(void)len;
+	(void)add;
+#endif
+}
+
+static void rwp_compr_add_load_time(uint64_t cnt __maybe_unused)
+{
+#ifdef CFG_WITH_STATS
+	rwp_compr_stats.loads++;
+	rwp_compr_load_cnt += cnt;
+#endif
+}
+
+static bool rwp_compr_grow_pool(void)
+{
+	size_t size = RWP_COMPR_POOL_GROW * SMALL_PAGE_SIZE;
+	tee_mm_entry_t *mm = NULL;
+	void *va = NULL;
+
+	/* The pool never shrinks, the memory is kept for later pages */
+	mm = nex_phys_mem_ta_alloc(size);
+	if (!mm)
+		return false;
+	va = phys_to_virt(tee_mm_get_smem(mm), MEM_AREA_SEC_RAM_OVERALL, size);
+	assert(va);
+
+	raw_malloc_add_pool(rwp_compr_ctx, va, size);
+#ifdef CFG_WITH_STATS
+	rwp_compr_stats.pool_size += size;
+#endif
+
+	return true;
+}
+
+static uint8_t *rwp_compr_data_alloc(size_t len)
+{
+	uint8_t *p = raw_malloc(0, 0, len, rwp_compr_ctx);
+
+	if (!p && rwp_compr_grow_pool())
+		p = raw_malloc(0, 0, len, rwp_compr_ctx);
+
+	return p;
+}
+
+static uint8_t *rwp_compr_page_alloc(tee_mm_entry_t **mm)
+{
+	uint8_t *p = NULL;
+
+	*mm = nex_phys_mem_ta_alloc(SMALL_PAGE_SIZE);
+	if (!*mm)
+		return NULL;
+	p = phys_to_virt(tee_mm_get_smem(*mm), MEM_AREA_SEC_RAM_OVERALL,
+			 SMALL_PAGE_SIZE);
+	assert(p);
+
+	return p;
+}
+
+static void rwp_compr_data_free(struct rwp_compr_state *st)
+{
+	rwp_compr_update_stats(st, st->len, false);
+	if (st->mm)
+		tee_mm_free(st->mm);
+	else
+		raw_free(st->data, rwp_compr_ctx, false /*!wipe*/);
+	st->data = NULL;
+	st->mm = NULL;
+	st->len = 0;
+}
+
+static struct fobj *rwp_compr_alloc(unsigned int num_pages)
+{
+	struct fobj_rwp_compr *rwp = NULL;
+
+	if (!rwp_compr_ctx)
+		return NULL;
+
+	rwp = calloc(1, sizeof(*rwp));
+	if (!rwp)
+		return NULL;
+
+	rwp->state = calloc(num_pages, sizeof(*rwp->state));
+	if (!rwp->state) {
+		free(rwp);
+		return NULL;
+	}
+
+	fobj_init(&rwp->fobj, &ops_rwp_compr, num_pages);
+
+	return &rwp->fobj;
+}
+
+static struct fobj_rwp_compr *to_rwp_compr(struct fobj *fobj)
+{
+	assert(fobj->ops == &ops_rwp_compr);
+
+	return container_of(fobj, struct fobj_rwp_compr, fobj);
+}
+
+static TEE_Result rwp_compr_load_page(struct fobj *fobj,
+				      unsigned int page_idx, void *va)
+{
+	struct fobj_rwp_compr *rwp = to_rwp_compr(fobj);
+	struct rwp_compr_state *st = rwp->state + page_idx;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t exceptions = 0;
+	uint64_t cnt = 0;
+
+	assert(refcount_val(&fobj->refc));
+	assert(page_idx < fobj->num_pages);
+
+	if (!st->data) {
+		/* Previously unused page */
+		memset(va, 0, SMALL_PAGE_SIZE);
+		return TEE_SUCCESS;
+	}
+
+	if (st->len == SMALL_PAGE_SIZE)
+		return rwp_decrypt(&st->state, &st->len, sizeof(st->len),
+				   st->data, st->len, va);
+
+	exceptions = cpu_spin_lock_xsave(&rwp_compr_lock);
+	res = rwp_decrypt(&st->state, &st->len, sizeof(st->len), st->data,
+			  st->len, rwp_compr_buf);
+	if (!res) {
+		cnt = rwp_compr_read_cnt();
+		res = rwp_decompress(rwp_compr_buf, st->len, va);
+		rwp_compr_add_load_time(rwp_compr_read_cnt() - cnt);
+	}
+	cpu_spin_unlock_xrestore(&rwp_compr_lock, exceptions);
+
+	return res;
+}
+DECLARE_KEEP_PAGER(rwp_compr_load_page);
+
+static TEE_Result rwp_compr_save_page(struct fobj *fobj,
+				      unsigned int page_idx, const void *va)
+{
+	struct fobj_rwp_compr *rwp = to_rwp_compr(fobj);
+	struct rwp_compr_state *st = rwp->state + page_idx;
+	TEE_Result res = TEE_SUCCESS;
+	tee_mm_entry_t *mm = NULL;
+	uint8_t *data = NULL;
+	const void *src = va;
+	uint32_t exceptions = 0;
+	size_t len = 0;
+
+	assert(page_idx < fobj->num_pages);
+
+	if (!refcount_val(&fobj->refc)) {
+		/*
+		 * This fobj is being teared down, it just hasn't had the time
+		 * to call tee_pager_invalidate_fobj() yet.
+		 */
+		assert(TAILQ_EMPTY(&fobj->regions));
+		return TEE_SUCCESS;
+	}
+
+	exceptions = cpu_spin_lock_xsave(&rwp_compr_lock);
+
+	len = rwp_compress(va, rwp_compr_buf);
+	if (len < SMALL_PAGE_SIZE)
+		src = rwp_compr_buf;
+
+	data = rwp_compr_data_alloc(len);
+	if (!data && st->data && (st->mm || len <= st->len)) {
+		/* Overwrite the previous copy in place */
+		data = st->data;
+		mm = st->mm;
+	}
+	if (!data) {
+		data = rwp_compr_page_alloc(&mm);
+		if (!data) {
+			/* The previous copy is still intact */
+			res = TEE_ERROR_OUT_OF_MEMORY;
+			goto out;
+		}
+		src = va;
+		len = SMALL_PAGE_SIZE;
+	}
+
+	if (data == st->data) {
+		rwp_compr_update_stats(st, st->len, false);
+	} else if (st->data) {
+		rwp_compr_data_free(st);
+	}
+	st->data = data;
+	st->mm = mm;
+	st->len = len;
+	rwp_compr_update_stats(st, len, true);
+
+	res = rwp_encrypt(&st->state, &st->len, sizeof(st->len), src, len,
+			  st->data);
+out:
+	cpu_spin_unlock_xrestore(&rwp_compr_lock, exceptions);
+
+	return res;
+}
+DECLARE_KEEP_PAGER(rwp_compr_save_page);
+
+static void rwp_compr_free(struct fobj *fobj)
+{
+	struct fobj_rwp_compr *rwp = to_rwp_compr(fobj);
+	uint32_t exceptions = 0;
+	unsigned int n = 0;
+
+	fobj_uninit(fobj);
+
+	exceptions = cpu_spin_lock_xsave(&rwp_compr_lock);
+	for (n = 0; n < fobj->num_pages; n++)
+		if (rwp->state[n].data)
+			rwp_compr_data_free(rwp->state + n);
+	cpu_spin_unlock_xrestore(&rwp_compr_lock, exceptions);
+
+	free(rwp->state);
+	free(rwp);
+}
+
+/*
+ * Note: this variable is weak just to ease breaking its dependency chain
+ * when added to the unpaged area.
+ */
+const struct fobj_ops ops_rwp_compr
+__weak __relrodata_unpaged("ops_rwp_compr") = {
+	.free = rwp_compr_free,
+	.load_page = rwp_compr_load_page,
+	.save_page = rwp_compr_save_page,
+};
+
+static void rwp_compr_init(void)
+{
+	tee_mm_entry_t *mm = NULL;
+
+	rwp_compr_ctx = malloc(raw_malloc_get_ctx_size());
+	if (!rwp_compr_ctx)
+		panic();
+	raw_malloc_init_ctx(rwp_compr_ctx);
+
+	mm = nex_phys_mem_ta_alloc(SMALL_PAGE_SIZE);
+	if (!mm)
+		panic();
+	rwp_compr_buf = phys_to_virt(tee_mm_get_smem(mm),
+				     MEM_AREA_SEC_RAM_OVERALL,
+				     SMALL_PAGE_SIZE);
+	assert(rwp_compr_buf);
+}
+
+#ifdef CFG_WITH_STATS
+void fobj_get_compr_stats(struct fobj_compr_stats *stats)
+{
+	uint32_t exceptions = cpu_spin_lock_xsave(&rwp_compr_lock);
+	uint64_t cnt = rwp_compr_load_cnt;
+
+	*stats = rwp_compr_stats;
+	rwp_compr_stats.loads = 0;
+	rwp_compr_load_cnt = 0;
+
+	cpu_spin_unlock_xrestore(&rwp_compr_lock, exceptions);
+
+#ifdef CFG_CORE_HAS_GENERIC_TIMER
+	stats->load_us = cnt * 1000000 / delay_cnt_freq();
+#else
+	stats->load_us = 0;
+	(void)cnt;
+#endif
+}
+#endif /*CFG_WITH_STATS*/
+#endif /*CFG_CORE_RWP_COMPRESS*/
+
 static TEE_Result rwp_init(void)
 {
 	paddr_size_t ta_size = nex_phys_mem_get_ta_size();
@@ -372,8 +803,12 @@ static TEE_Result rwp_init(void)
 				      &rwp_ae_key.rounds))
 		panic("failed to expand key");
 
-	if (!IS_ENABLED(CFG_CORE_PAGE_TAG_AND_IV))
+	if (!IS_ENABLED(CFG_CORE_PAGE_TAG_AND_IV)) {
+#ifdef CFG_CORE_RWP_COMPRESS
+		rwp_compr_init();
+#endif
 		return TEE_SUCCESS;
+	}
 
 	assert(ta_size && !(ta_size & SMALL_PAGE_SIZE));
 
@@ -409,8 +844,11 @@ struct fobj *fobj_rw_paged_alloc(unsigned int num_pages)
 
 	if (IS_ENABLED(CFG_CORE_PAGE_TAG_AND_IV))
 		return rwp_paged_iv_alloc(num_pages);
-	else
-		return rwp_unpaged_iv_alloc(num_pages);
+#ifdef CFG_CORE_RWP_COMPRESS
+	return rwp_compr_alloc(num_pages);
+#else
+	return rwp_unpaged_iv_alloc(num_pages);
+#endif
 }
 
 struct fobj_rop {
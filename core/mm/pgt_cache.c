@@ -354,8 +354,17 @@ static struct pgt_cache pgt_free_list = SLIST_HEAD_INITIALIZER(pgt_free_list);
  * the context (page tables holding valid physical pages) are saved in this
  * cache in the hope that it will remain in the cache when the context is
  * mapped again.
+ *
+ * The cache is kept as two lists in LRU order, most recently used first.
+ * Tables of contexts asking to retain their tables are kept in
+ * pgt_retain_list and are only evicted once pgt_lru_list is empty.
  */
-static struct pgt_cache pgt_cache_list = SLIST_HEAD_INITIALIZER(pgt_cache_list);
+TAILQ_HEAD(pgt_lru, pgt);
+static struct pgt_lru pgt_lru_list = TAILQ_HEAD_INITIALIZER(pgt_lru_list);
+static struct pgt_lru pgt_retain_list =
+	TAILQ_HEAD_INITIALIZER(pgt_retain_list);
+
+static struct pgt_cache_stats pgt_stats;
 
 static struct pgt pgt_entries[PGT_CACHE_SIZE];
 
@@ -484,9 +493,23 @@ static void push_to_free_list(struct pgt *p)
 }
 #endif
 
+static struct pgt_lru *cache_list_of(struct pgt *pgt)
+{
+	if (pgt->retain)
+		return &pgt_retain_list;
+	return &pgt_lru_list;
+}
+
 static void push_to_cache_list(struct pgt *pgt)
 {
-	SLIST_INSERT_HEAD(&pgt_cache_list, pgt, link);
+	TAILQ_INSERT_HEAD(cache_list_of(pgt), pgt, lru_link);
+	pgt_stats.cached++;
+}
+
+static void remove_from_cache_list(struct pgt *pgt)
+{
+	TAILQ_REMOVE(cache_list_of(pgt), pgt, lru_link);
+	pgt_stats.cached--;
 }
 
 static bool match_pgt(struct pgt *pgt, vaddr_t vabase, void *ctx)
@@ -496,28 +519,19 @@ static bool match_pgt(struct pgt *pgt, vaddr_t vabase, void *ctx)
 
 static struct pgt *pop_from_cache_list(vaddr_t vabase, void *ctx)
 {
-	struct pgt *pgt;
-	struct pgt *p;
+	struct pgt *pgt = NULL;
 
-	pgt = SLIST_FIRST(&pgt_cache_list);
-	if (!pgt)
-		return NULL;
-	if (match_pgt(pgt, vabase, ctx)) {
-		SLIST_REMOVE_HEAD(&pgt_cache_list, link);
-		return pgt;
-	}
+	TAILQ_FOREACH(pgt, &pgt_retain_list, lru_link)
+		if (match_pgt(pgt, vabase, ctx))
+			goto found;
+	TAILQ_FOREACH(pgt, &pgt_lru_list, lru_link)
+		if (match_pgt(pgt, vabase, ctx))
+			goto found;
 
-	while (true) {
-		p = SLIST_NEXT(pgt, link);
-		if (!p)
-			break;
-		if (match_pgt(p, vabase, ctx)) {
-			SLIST_REMOVE_AFTER(pgt, link);
-			break;
-		}
-		pgt = p;
-	}
-	return p;
+	return NULL;
+found:
+	remove_from_cache_list(pgt);
+	return pgt;
 }
 
 static uint16_t get_num_used_entries(struct pgt *pgt __maybe_unused)
@@ -529,40 +543,21 @@ static uint16_t get_num_used_entries(struct pgt *pgt __maybe_unused)
 #endif
 }
 
-static struct pgt *pop_least_used_from_cache_list(void)
+static struct pgt *pop_least_recently_used_from_cache_list(void)
 {
-	struct pgt *pgt = NULL;
-	struct pgt *p_prev = NULL;
-	size_t least_used = 0;
-	size_t next_used = 0;
+	struct pgt *pgt = TAILQ_LAST(&pgt_lru_list, pgt_lru);
 
-	pgt = SLIST_FIRST(&pgt_cache_list);
 	if (!pgt)
-		return NULL;
-	least_used = get_num_used_entries(pgt);
-
-	while (true) {
-		if (!SLIST_NEXT(pgt, link))
-			break;
-		next_used = get_num_used_entries(SLIST_NEXT(pgt, link));
-		if (next_used <= least_used) {
-			p_prev = pgt;
-			least_used = next_used;
-		}
-		pgt = SLIST_NEXT(pgt, link);
+		pgt = TAILQ_LAST(&pgt_retain_list, pgt_lru);
+	if (pgt) {
+		remove_from_cache_list(pgt);
+		pgt_stats.evictions++;
 	}
 
-	if (p_prev) {
-		pgt = SLIST_NEXT(p_prev, link);
-		SLIST_REMOVE_AFTER(p_prev, link);
-	} else {
-		pgt = SLIST_FIRST(&pgt_cache_list);
-		SLIST_REMOVE_HEAD(&pgt_cache_list, link);
-	}
 	return pgt;
 }
 
-static void pgt_free_unlocked(struct pgt_cache *pgt_cache)
+static void pgt_free_unlocked(struct pgt_cache *pgt_cache, bool retain)
 {
 	while (!SLIST_EMPTY(pgt_cache)) {
 		struct pgt *p = SLIST_FIRST(pgt_cache);
@@ -583,6 +578,7 @@ static void pgt_free_unlocked(struct pgt_cache *pgt_cache)
 			continue;
 		}
 
+		p->retain = retain;
 		push_to_cache_list(p);
 	}
 }
@@ -591,11 +587,14 @@ static struct pgt *pop_from_some_list(vaddr_t vabase, void *ctx)
 {
 	struct pgt *p = pop_from_cache_list(vabase, ctx);
 
-	if (p)
+	if (p) {
+		pgt_stats.hits++;
 		return p;
+	}
+	pgt_stats.misses++;
 	p = pop_from_free_list();
 	if (!p) {
-		p = pop_least_used_from_cache_list();
+		p = pop_least_recently_used_from_cache_list();
 		if (!p)
 			return NULL;
 		tee_pager_pgt_save_and_release_entries(p);
@@ -607,52 +606,37 @@ static struct pgt *pop_from_some_list(vaddr_t vabase, void *ctx)
 	return p;
 }
 
-void pgt_flush(struct user_mode_ctx *uctx)
+static void flush_pgt_entry(struct pgt *p)
 {
-	struct ts_ctx *ctx = uctx->ts_ctx;
-	struct pgt *pp = NULL;
-	struct pgt *p = NULL;
-
-	mutex_lock(&pgt_mu);
+	tee_pager_pgt_save_and_release_entries(p);
+	p->ctx = NULL;
+	p->vabase = 0;
+}
 
-	while (true) {
-		p = SLIST_FIRST(&pgt_cache_list);
-		if (!p)
-			goto out;
-		if (p->ctx != ctx)
-			break;
-		SLIST_REMOVE_HEAD(&pgt_cache_list, link);
-		tee_pager_pgt_save_and_release_entries(p);
-		p->ctx = NULL;
-		p->vabase = 0;
-		push_to_free_list(p);
-	}
+static void flush_ctx_from_lru(struct pgt_lru *list, void *ctx)
+{
+	struct pgt *next_p = NULL;
+	struct pgt *p = NULL;
 
-	pp = p;
-	while (true) {
-		p = SLIST_NEXT(pp, link);
-		if (!p)
-			break;
+	TAILQ_FOREACH_SAFE(p, list, lru_link, next_p) {
 		if (p->ctx == ctx) {
-			SLIST_REMOVE_AFTER(pp, link);
-			tee_pager_pgt_save_and_release_entries(p);
-			p->ctx = NULL;
-			p->vabase = 0;
+			remove_from_cache_list(p);
+			flush_pgt_entry(p);
 			push_to_free_list(p);
-		} else {
-			pp = p;
 		}
 	}
-
-out:
-	mutex_unlock(&pgt_mu);
 }
 
-static void flush_pgt_entry(struct pgt *p)
+void pgt_flush(struct user_mode_ctx *uctx)
 {
-	tee_pager_pgt_save_and_release_entries(p);
-	p->ctx = NULL;
-	p->vabase = 0;
+	struct ts_ctx *ctx = uctx->ts_ctx;
+
+	mutex_lock(&pgt_mu);
+
+	flush_ctx_from_lru(&pgt_lru_list, ctx);
+	flush_ctx_from_lru(&pgt_retain_list, ctx);
+
+	mutex_unlock(&pgt_mu);
 }
 
 static bool pgt_entry_matches(struct pgt *p, void *ctx, vaddr_t begin,
@@ -715,6 +699,21 @@ static void flush_ctx_range_from_list(struct pgt_cache *pgt_cache, void *ctx,
 	}
 }
 
+static void flush_ctx_range_from_lru(struct pgt_lru *list, void *ctx,
+				     vaddr_t begin, vaddr_t last)
+{
+	struct pgt *next_p = NULL;
+	struct pgt *p = NULL;
+
+	TAILQ_FOREACH_SAFE(p, list, lru_link, next_p) {
+		if (pgt_entry_matches(p, ctx, begin, last)) {
+			remove_from_cache_list(p);
+			flush_pgt_entry(p);
+			push_to_free_list(p);
+		}
+	}
+}
+
 void pgt_flush_range(struct user_mode_ctx *uctx, vaddr_t begin, vaddr_t last)
 {
 	struct pgt_cache *pgt_cache = &uctx->pgt_cache;
@@ -723,16 +722,18 @@ void pgt_flush_range(struct user_mode_ctx *uctx, vaddr_t begin, vaddr_t last)
 	mutex_lock(&pgt_mu);
 
 	flush_ctx_range_from_list(pgt_cache, ctx, begin, last);
-	flush_ctx_range_from_list(&pgt_cache_list, ctx, begin, last);
+	flush_ctx_range_from_lru(&pgt_lru_list, ctx, begin, last);
+	flush_ctx_range_from_lru(&pgt_retain_list, ctx, begin, last);
 
 	condvar_broadcast(&pgt_cv);
 	mutex_unlock(&pgt_mu);
 }
 
-static void clear_ctx_range_from_list(struct pgt_cache *pgt_cache,
-				      void *ctx, vaddr_t begin, vaddr_t end)
+static void clear_pgt_range(struct pgt *p, void *ctx, vaddr_t begin,
+			    vaddr_t end)
 {
-	struct pgt *p = NULL;
+	vaddr_t b = MAX(p->vabase, begin);
+	vaddr_t e = MIN(p->vabase + CORE_MMU_PGDIR_SIZE, end);
 #ifdef CFG_WITH_LPAE
 	uint64_t *tbl = NULL;
 #else
@@ -741,20 +742,33 @@ static void clear_ctx_range_from_list(struct pgt_cache *pgt_cache,
 	unsigned int idx = 0;
 	unsigned int n = 0;
 
-	SLIST_FOREACH(p, pgt_cache, link) {
-		vaddr_t b = MAX(p->vabase, begin);
-		vaddr_t e = MIN(p->vabase + CORE_MMU_PGDIR_SIZE, end);
+	if (p->ctx != ctx)
+		return;
+	if (b >= e)
+		return;
 
-		if (p->ctx != ctx)
-			continue;
-		if (b >= e)
-			continue;
+	tbl = p->tbl;
+	idx = (b - p->vabase) / SMALL_PAGE_SIZE;
+	n = (e - b) / SMALL_PAGE_SIZE;
+	memset(tbl + idx, 0, n * sizeof(*tbl));
+}
 
-		tbl = p->tbl;
-		idx = (b - p->vabase) / SMALL_PAGE_SIZE;
-		n = (e - b) / SMALL_PAGE_SIZE;
-		memset(tbl + idx, 0, n * sizeof(*tbl));
-	}
+static void clear_ctx_range_from_list(struct pgt_cache *pgt_cache,
+				      void *ctx, vaddr_t begin, vaddr_t end)
+{
+	struct pgt *p = NULL;
+
+	SLIST_FOREACH(p, pgt_cache, link)
+		clear_pgt_range(p, ctx, begin, end);
+}
+
+static void clear_ctx_range_from_lru(struct pgt_lru *list, void *ctx,
+				     vaddr_t begin, vaddr_t end)
+{
+	struct pgt *p = NULL;
+
+	TAILQ_FOREACH(p, list, lru_link)
+		clear_pgt_range(p, ctx, begin, end);
 }
 
 void pgt_clear_range(struct user_mode_ctx *uctx, vaddr_t begin, vaddr_t end)
@@ -765,14 +779,17 @@ void pgt_clear_range(struct user_mode_ctx *uctx, vaddr_t begin, vaddr_t end)
 	mutex_lock(&pgt_mu);
 
 	clear_ctx_range_from_list(pgt_cache, ctx, begin, end);
-	clear_ctx_range_from_list(&pgt_cache_list, ctx, begin, end);
+	clear_ctx_range_from_lru(&pgt_lru_list, ctx, begin, end);
+	clear_ctx_range_from_lru(&pgt_retain_list, ctx, begin, end);
 
 	mutex_unlock(&pgt_mu);
 }
 
-static bool pgt_alloc_unlocked(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
-			       struct vm_info *vm_info)
+static bool pgt_alloc_unlocked(struct user_mode_ctx *uctx)
 {
+	struct pgt_cache *pgt_cache = &uctx->pgt_cache;
+	struct vm_info *vm_info = &uctx->vm_info;
+	struct ts_ctx *ctx = uctx->ts_ctx;
 	struct vm_region *r = NULL;
 	struct pgt *pp = NULL;
 	struct pgt *p = NULL;
@@ -785,7 +802,7 @@ static bool pgt_alloc_unlocked(struct pgt_cache *pgt_cache, struct ts_ctx *ctx,
 				continue;
 			p = pop_from_some_list(va, ctx);
 			if (!p) {
-				pgt_free_unlocked(pgt_cache);
+				pgt_free_unlocked(pgt_cache, uctx->pgt_retain);
 				return false;
 			}
 			if (pp)
@@ -830,8 +847,8 @@ void pgt_get_all(struct user_mode_ctx *uctx)
 
 	mutex_lock(&pgt_mu);
 
-	pgt_free_unlocked(pgt_cache);
-	while (!pgt_alloc_unlocked(pgt_cache, uctx->ts_ctx, vm_info)) {
+	pgt_free_unlocked(pgt_cache, uctx->pgt_retain);
+	while (!pgt_alloc_unlocked(uctx)) {
 		assert(pgt_check_avail(uctx));
 		DMSG("Waiting for page tables");
 		condvar_broadcast(&pgt_cv);
@@ -850,7 +867,7 @@ void pgt_put_all(struct user_mode_ctx *uctx)
 
 	mutex_lock(&pgt_mu);
 
-	pgt_free_unlocked(pgt_cache);
+	pgt_free_unlocked(pgt_cache, uctx->pgt_retain);
 
 	condvar_broadcast(&pgt_cv);
 	mutex_unlock(&pgt_mu);
@@ -874,4 +891,15 @@ void pgt_push_to_cache_list(struct pgt *pgt)
 	mutex_unlock(&pgt_mu);
 }
 
+void pgt_get_cache_stats(struct pgt_cache_stats *stats)
+{
+	mutex_lock(&pgt_mu);
+	*stats = pgt_stats;
+	stats->size = PGT_CACHE_SIZE;
+	pgt_stats.hits = 0;
+	pgt_stats.misses = 0;
+	pgt_stats.evictions = 0;
+	mutex_unlock(&pgt_mu);
+}
+
 #endif /* !CFG_CORE_PREALLOC_EL0_TBLS */
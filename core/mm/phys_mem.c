@@ -35,6 +35,9 @@ static tee_mm_pool_t *init_pool(paddr_t b, paddr_size_t sz, uint32_t flags)
 	if (!tee_mm_init(pool, b, sz, CORE_MMU_USER_CODE_SHIFT, flags))
 		panic();
 
+	if (IS_ENABLED(CFG_CORE_PHYS_MEM_BUDDY) && !tee_mm_enable_buddy(pool))
+		panic();
+
 	return pool;
 }
 
@@ -169,6 +172,26 @@ void nex_phys_mem_stats(struct pta_stats_alloc *stats, bool reset)
 	add_pool_stats(nex_core_pool, stats, reset);
 	add_pool_stats(nex_ta_pool, stats, reset);
 }
+
+static void set_frag_index(struct pta_stats_phys_mem *stats)
+{
+	uint32_t largest = 0;
+
+	if (stats->num_orders)
+		largest = BIT(stats->num_orders - 1);
+	if (stats->free_units)
+		stats->frag_index = 1000 - (uint64_t)largest * 1000 /
+					   stats->free_units;
+}
+
+void nex_phys_mem_frag_stats(struct pta_stats_phys_mem *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	tee_mm_get_buddy_stats(nex_core_pool, stats);
+	tee_mm_get_buddy_stats(nex_ta_pool, stats);
+	set_frag_index(stats);
+}
 #endif /*CFG_WITH_STATS*/
 
 #if defined(CFG_NS_VIRTUALIZATION)
@@ -220,6 +243,15 @@ void phys_mem_stats(struct pta_stats_alloc *stats, bool reset)
 	add_pool_stats(core_pool, stats, reset);
 	add_pool_stats(ta_pool, stats, reset);
 }
+
+void phys_mem_frag_stats(struct pta_stats_phys_mem *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	tee_mm_get_buddy_stats(core_pool, stats);
+	tee_mm_get_buddy_stats(ta_pool, stats);
+	set_frag_index(stats);
+}
 #endif /*CFG_WITH_STATS*/
 #endif /*CFG_NS_VIRTUALIZATION*/
 
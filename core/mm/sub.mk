@@ -6,6 +6,7 @@ srcs-y += vm.c
 srcs-y += core_mmu.c
 srcs-y += pgt_cache.c
 srcs-y += tee_mm.c
+srcs-$(CFG_CORE_PHYS_MEM_BUDDY) += tee_mm_buddy.c
 srcs-y += phys_mem.c
 ifneq ($(CFG_CORE_FFA),y)
 srcs-$(CFG_CORE_DYN_SHM) += mobj_dyn_shm.c
@@ -7,11 +7,24 @@
 #include <kernel/spinlock.h>
 #include <kernel/tee_common.h>
 #include <mm/tee_mm.h>
+#include <mm/tee_mm_buddy.h>
 #include <mm/tee_pager.h>
 #include <pta_stats.h>
 #include <trace.h>
 #include <util.h>
 
+#ifdef CFG_CORE_PHYS_MEM_BUDDY
+static struct tee_mm_buddy *pool_buddy(const tee_mm_pool_t *pool)
+{
+	return pool->buddy;
+}
+#else
+static struct tee_mm_buddy *pool_buddy(const tee_mm_pool_t *pool __unused)
+{
+	return NULL;
+}
+#endif
+
 bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_size_t size,
 		 uint8_t shift, uint32_t flags)
 {
@@ -49,6 +62,20 @@ bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_size_t size,
 	return true;
 }
 
+#ifdef CFG_CORE_PHYS_MEM_BUDDY
+bool tee_mm_enable_buddy(tee_mm_pool_t *pool)
+{
+	if (!pool || !pool->entry || pool->buddy ||
+	    (pool->flags & TEE_MM_POOL_HI_ALLOC) || !tee_mm_is_empty(pool))
+		return false;
+
+	pool->buddy = tee_mm_buddy_init(pool->size >> pool->shift,
+					pool->flags);
+
+	return pool->buddy;
+}
+#endif
+
 void tee_mm_final(tee_mm_pool_t *pool)
 {
 	if (pool == NULL || pool->entry == NULL)
@@ -58,6 +85,10 @@ void tee_mm_final(tee_mm_pool_t *pool)
 		tee_mm_free(pool->entry->next);
 	free_flags(pool->flags, pool->entry);
 	pool->entry = NULL;
+#ifdef CFG_CORE_PHYS_MEM_BUDDY
+	tee_mm_buddy_final(pool->buddy);
+	pool->buddy = NULL;
+#endif
 }
 
 static void tee_mm_add(tee_mm_entry_t *p, tee_mm_entry_t *nn)
@@ -106,6 +137,20 @@ void tee_mm_get_pool_stats(tee_mm_pool_t *pool, struct pta_stats_alloc *stats,
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 }
 
+void tee_mm_get_buddy_stats(tee_mm_pool_t *pool,
+			    struct pta_stats_phys_mem *stats)
+{
+	uint32_t exceptions = 0;
+
+	if (!pool || !pool_buddy(pool))
+		return;
+
+	exceptions = cpu_spin_lock_xsave(&pool->lock);
+	stats->unit_size = BIT(pool->shift);
+	tee_mm_buddy_get_stats(pool_buddy(pool), stats);
+	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
+}
+
 static void update_max_allocated(tee_mm_pool_t *pool)
 {
 	size_t sz = tee_mm_stats_allocated(pool);
@@ -119,33 +164,15 @@ static inline void update_max_allocated(tee_mm_pool_t *pool __unused)
 }
 #endif /* CFG_WITH_STATS */
 
-tee_mm_entry_t *tee_mm_alloc_flags(tee_mm_pool_t *pool, size_t size,
-				   uint32_t flags)
+/*
+ * Returns the entry after which an allocation of @psize blocks fits and
+ * the offset of the allocation in @offs, or NULL if out of memory.
+ */
+static tee_mm_entry_t *linear_find_slot(tee_mm_pool_t *pool, size_t size,
+					size_t psize, uint32_t *offs)
 {
-	size_t psize = 0;
-	tee_mm_entry_t *entry = NULL;
-	tee_mm_entry_t *nn = NULL;
+	tee_mm_entry_t *entry = pool->entry;
 	size_t remaining = 0;
-	uint32_t exceptions = 0;
-
-	/* Check that pool is initialized */
-	if (!pool || !pool->entry)
-		return NULL;
-
-	flags &= ~MAF_NEX;	/* This flag must come from pool->flags */
-	flags |= pool->flags;
-	nn  = malloc_flags(flags, NULL, MALLOC_DEFAULT_ALIGNMENT,
-			   sizeof(tee_mm_entry_t));
-	if (!nn)
-		return NULL;
-
-	exceptions = cpu_spin_lock_xsave(&pool->lock);
-
-	entry = pool->entry;
-	if (!size)
-		psize = 0;
-	else
-		psize = ((size - 1) >> pool->shift) + 1;
 
 	/* find free slot */
 	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
@@ -173,7 +200,7 @@ tee_mm_entry_t *tee_mm_alloc_flags(tee_mm_pool_t *pool, size_t size,
 			 */
 			if ((entry->offset << pool->shift) < size) {
 				/* out of memory */
-				goto err;
+				return NULL;
 			}
 		} else {
 			if (!pool->size)
@@ -185,17 +212,74 @@ tee_mm_entry_t *tee_mm_alloc_flags(tee_mm_pool_t *pool, size_t size,
 
 			if (remaining < size) {
 				/* out of memory */
-				goto err;
+				return NULL;
 			}
 		}
 	}
 
-	tee_mm_add(entry, nn);
-
 	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
-		nn->offset = entry->offset - psize;
+		*offs = entry->offset - psize;
+	else
+		*offs = entry->offset + entry->size;
+
+	return entry;
+}
+
+/*
+ * Same as linear_find_slot() but the offset is chosen by the buddy
+ * allocator of the pool. The entry list is kept sorted on offset.
+ */
+static tee_mm_entry_t *buddy_find_slot(tee_mm_pool_t *pool, size_t psize,
+				       uint32_t *offs)
+{
+	tee_mm_entry_t *entry = pool->entry;
+
+	if (!tee_mm_buddy_alloc(pool_buddy(pool), psize, offs))
+		return NULL;
+
+	while (entry->next != NULL && entry->next->offset < *offs)
+		entry = entry->next;
+
+	return entry;
+}
+
+tee_mm_entry_t *tee_mm_alloc_flags(tee_mm_pool_t *pool, size_t size,
+				   uint32_t flags)
+{
+	size_t psize = 0;
+	tee_mm_entry_t *entry = NULL;
+	tee_mm_entry_t *nn = NULL;
+	uint32_t exceptions = 0;
+	uint32_t offs = 0;
+
+	/* Check that pool is initialized */
+	if (!pool || !pool->entry)
+		return NULL;
+
+	flags &= ~MAF_NEX;	/* This flag must come from pool->flags */
+	flags |= pool->flags;
+	nn  = malloc_flags(flags, NULL, MALLOC_DEFAULT_ALIGNMENT,
+			   sizeof(tee_mm_entry_t));
+	if (!nn)
+		return NULL;
+
+	exceptions = cpu_spin_lock_xsave(&pool->lock);
+
+	if (!size)
+		psize = 0;
+	else
+		psize = ((size - 1) >> pool->shift) + 1;
+
+	if (pool_buddy(pool) && psize)
+		entry = buddy_find_slot(pool, psize, &offs);
 	else
-		nn->offset = entry->offset + entry->size;
+		entry = linear_find_slot(pool, size, psize, &offs);
+	if (!entry)
+		goto err;
+
+	tee_mm_add(entry, nn);
+
+	nn->offset = offs;
 	nn->size = psize;
 	nn->pool = pool;
 
@@ -271,6 +355,11 @@ tee_mm_entry_t *tee_mm_alloc2(tee_mm_pool_t *pool, paddr_t base, size_t size)
 	if (!fit_in_gap(pool, entry, offslo, offshi))
 		goto err;
 
+	if (pool_buddy(pool) &&
+	    !tee_mm_buddy_alloc_range(pool_buddy(pool), offslo,
+				      offshi - offslo))
+		panic("buddy out of sync");
+
 	tee_mm_add(entry, mm);
 
 	mm->offset = offslo;
@@ -305,6 +394,8 @@ void tee_mm_free(tee_mm_entry_t *p)
 		panic("invalid mm_entry");
 
 	entry->next = entry->next->next;
+	if (pool_buddy(p->pool))
+		tee_mm_buddy_free(pool_buddy(p->pool), p->offset, p->size);
 	cpu_spin_unlock_xrestore(&p->pool->lock, exceptions);
 
 	free_flags(p->pool->flags, p);
@@ -0,0 +1,299 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <assert.h>
+#include <bitstring.h>
+#include <kernel/panic.h>
+#include <malloc.h>
+#include <mm/tee_mm_buddy.h>
+#include <pta_stats.h>
+#include <util.h>
+
+#define MAX_ORDERS	STATS_PHYS_MEM_NB_ORDERS
+
+struct tee_mm_buddy {
+	uint32_t nunits;
+	uint32_t free_units;
+	unsigned int max_order;
+	uint32_t flags;
+	uint32_t nr_free[MAX_ORDERS];
+	bitstr_t *free_map[MAX_ORDERS];
+	bitstr_t *used;
+};
+
+static uint32_t order_nbits(struct tee_mm_buddy *b, unsigned int order)
+{
+	/* Only blocks completely inside the managed range can exist */
+	return b->nunits >> order;
+}
+
+static void add_block(struct tee_mm_buddy *b, uint32_t offs,
+		      unsigned int order)
+{
+	assert(IS_ALIGNED(offs, BIT(order)));
+	assert(!bit_test(b->free_map[order], offs >> order));
+	bit_set(b->free_map[order], offs >> order);
+	b->nr_free[order]++;
+}
+
+static void remove_block(struct tee_mm_buddy *b, uint32_t offs,
+			 unsigned int order)
+{
+	assert(bit_test(b->free_map[order], offs >> order));
+	bit_clear(b->free_map[order], offs >> order);
+	b->nr_free[order]--;
+}
+
+static bool block_is_free(struct tee_mm_buddy *b, uint32_t offs,
+			  unsigned int order)
+{
+	return (offs >> order) < order_nbits(b, order) &&
+	       bit_test(b->free_map[order], offs >> order);
+}
+
+/* Insert a free block, merging it with its buddies when possible */
+static void free_block(struct tee_mm_buddy *b, uint32_t offs,
+		       unsigned int order)
+{
+	while (order < b->max_order) {
+		uint32_t buddy = offs ^ BIT(order);
+
+		if (!block_is_free(b, buddy, order))
+			break;
+		remove_block(b, buddy, order);
+		offs &= ~BIT(order);
+		order++;
+	}
+
+	add_block(b, offs, order);
+}
+
+/* Insert a free range as the largest naturally aligned blocks possible */
+static void free_range(struct tee_mm_buddy *b, uint32_t offs, uint32_t n)
+{
+	while (n) {
+		unsigned int order = 0;
+
+		while (order < b->max_order &&
+		       IS_ALIGNED(offs, BIT(order + 1)) &&
+		       BIT(order + 1) <= n)
+			order++;
+
+		free_block(b, offs, order);
+		offs += BIT(order);
+		n -= BIT(order);
+	}
+}
+
+static unsigned int find_block_order(struct tee_mm_buddy *b, uint32_t unit)
+{
+	unsigned int order = 0;
+
+	for (order = 0; order <= b->max_order; order++)
+		if (block_is_free(b, unit & ~(BIT(order) - 1), order))
+			return order;
+
+	panic("buddy: unit not free");
+}
+
+/* Take a free range out of the free blocks, splitting them as needed */
+static void carve_range(struct tee_mm_buddy *b, uint32_t offs, uint32_t n)
+{
+	uint32_t end = offs + n;
+	uint32_t unit = offs;
+
+	while (unit < end) {
+		unsigned int order = find_block_order(b, unit);
+		uint32_t blk = unit & ~(BIT(order) - 1);
+		uint32_t blk_end = blk + BIT(order);
+
+		remove_block(b, blk, order);
+		if (blk < offs)
+			free_range(b, blk, offs - blk);
+		if (blk_end > end)
+			free_range(b, end, blk_end - end);
+		unit = blk_end;
+	}
+}
+
+static bool range_is_unused(struct tee_mm_buddy *b, uint32_t offs, uint32_t n)
+{
+	uint32_t unit = 0;
+
+	for (unit = offs; unit < offs + n; unit++)
+		if (bit_test(b->used, unit))
+			return false;
+
+	return true;
+}
+
+static bool find_first_fit(struct tee_mm_buddy *b, uint32_t n,
+			   uint32_t *offs)
+{
+	uint32_t unit = 0;
+	uint32_t run = 0;
+
+	for (unit = 0; unit < b->nunits; unit++) {
+		if (bit_test(b->used, unit)) {
+			run = 0;
+		} else if (++run == n) {
+			*offs = unit + 1 - n;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool alloc_from_block(struct tee_mm_buddy *b, uint32_t n,
+			     uint32_t *offs)
+{
+	unsigned int order = 0;
+	unsigned int o = 0;
+	uint32_t blk = 0;
+	int idx = 0;
+
+	while (order < MAX_ORDERS - 1 && BIT(order) < n)
+		order++;
+
+	for (o = order; o <= b->max_order; o++)
+		if (b->nr_free[o])
+			break;
+	if (o > b->max_order)
+		return false;
+
+	bit_ffs(b->free_map[o], (int)order_nbits(b, o), &idx);
+	assert(idx >= 0);
+	blk = (uint32_t)idx << o;
+	remove_block(b, blk, o);
+
+	/* Split off the upper halves until the block has the right order */
+	while (o > order) {
+		o--;
+		add_block(b, blk + BIT(o), o);
+	}
+
+	/* Give back the unused tail of the block */
+	if (BIT(order) > n)
+		free_range(b, blk + n, BIT(order) - n);
+
+	*offs = blk;
+	return true;
+}
+
+struct tee_mm_buddy *tee_mm_buddy_init(uint32_t nunits, uint32_t flags)
+{
+	struct tee_mm_buddy *b = NULL;
+	unsigned int order = 0;
+	unsigned int n = 0;
+	size_t sz = 0;
+	uint8_t *p = NULL;
+
+	if (!nunits)
+		return NULL;
+
+	while (order < MAX_ORDERS - 1 && BIT(order + 1) <= nunits)
+		order++;
+
+	/* The bitmaps are stored right after the struct */
+	sz = sizeof(*b) + bitstr_size(nunits);
+	for (n = 0; n <= order; n++)
+		sz += bitstr_size(nunits >> n);
+
+	b = malloc_flags(flags | MAF_ZERO_INIT, NULL, MALLOC_DEFAULT_ALIGNMENT,
+			 sz);
+	if (!b)
+		return NULL;
+
+	b->nunits = nunits;
+	b->max_order = order;
+	b->flags = flags;
+	p = (uint8_t *)(b + 1);
+	b->used = p;
+	p += bitstr_size(nunits);
+	for (n = 0; n <= order; n++) {
+		b->free_map[n] = p;
+		p += bitstr_size(nunits >> n);
+	}
+
+	free_range(b, 0, nunits);
+	b->free_units = nunits;
+
+	return b;
+}
+
+void tee_mm_buddy_final(struct tee_mm_buddy *b)
+{
+	if (b)
+		free_flags(b->flags, b);
+}
+
+bool tee_mm_buddy_alloc(struct tee_mm_buddy *b, uint32_t n, uint32_t *offs)
+{
+	uint32_t o = 0;
+
+	if (!n || n > b->free_units)
+		return false;
+
+	if (!alloc_from_block(b, n, &o)) {
+		/* No single block is large enough, try a first fit instead */
+		if (!find_first_fit(b, n, &o))
+			return false;
+		carve_range(b, o, n);
+	}
+
+	bit_nset(b->used, o, o + n - 1);
+	b->free_units -= n;
+	*offs = o;
+
+	return true;
+}
+
+bool tee_mm_buddy_alloc_range(struct tee_mm_buddy *b, uint32_t offs,
+			      uint32_t n)
+{
+	if (!n || offs >= b->nunits || n > b->nunits - offs ||
+	    !range_is_unused(b, offs, n))
+		return false;
+
+	carve_range(b, offs, n);
+	bit_nset(b->used, offs, offs + n - 1);
+	b->free_units -= n;
+
+	return true;
+}
+
+void tee_mm_buddy_free(struct tee_mm_buddy *b, uint32_t offs, uint32_t n)
+{
+	uint32_t unit = 0;
+
+	if (!n)
+		return;
+
+	if (offs >= b->nunits || n > b->nunits - offs)
+		panic("buddy: invalid range");
+
+	for (unit = offs; unit < offs + n; unit++)
+		if (!bit_test(b->used, unit))
+			panic("buddy: unit not allocated");
+
+	bit_nclear(b->used, offs, offs + n - 1);
+	free_range(b, offs, n);
+	b->free_units += n;
+}
+
+void tee_mm_buddy_get_stats(struct tee_mm_buddy *b,
+			    struct pta_stats_phys_mem *stats)
+{
+	unsigned int order = 0;
+
+	stats->free_units += b->free_units;
+	for (order = 0; order <= b->max_order; order++) {
+		stats->nr_free[order] += b->nr_free[order];
+		if (b->nr_free[order] &&
+		    order + 1 > stats->num_orders)
+			stats->num_orders = order + 1;
+	}
+}
@@ -12,6 +12,7 @@
 #include <kernel/spinlock.h>
 #include <kernel/tee_common.h>
 #include <kernel/tee_misc.h>
+#include <kernel/tee_time.h>
 #include <kernel/tlb_helpers.h>
 #include <kernel/user_mode_ctx.h>
 #include <mm/core_memprot.h>
@@ -137,6 +138,8 @@ static void rem_um_region(struct user_mode_ctx *uctx, struct vm_region *r)
 	vaddr_t last = ROUNDUP(r->va + r->size, CORE_MMU_PGDIR_SIZE);
 	struct vm_region *r2 = NULL;
 
+	vm_access_cache_reset();
+
 	if (mobj_is_paged(r->mobj)) {
 		tee_pager_rem_um_region(uctx, r->va, r->size);
 	} else {
@@ -757,6 +760,8 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 	if (res)
 		return res;
 
+	vm_access_cache_reset();
+
 	for (r = r0; r; r = TAILQ_NEXT(r, link)) {
 		if (r->va + r->size > va + len)
 			break;
@@ -805,6 +810,8 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 
 static void umap_remove_region(struct vm_info *vmi, struct vm_region *reg)
 {
+	vm_access_cache_reset();
+
 	TAILQ_REMOVE(&vmi->regions, reg, link);
 	mobj_put(reg->mobj);
 	free(reg);
@@ -868,9 +875,24 @@ static TEE_Result map_kinit(struct user_mode_ctx *uctx)
 	}
 
 	thread_get_user_kdata(&mobj, &offs, &va, &sz);
-	if (sz)
-		return vm_map(uctx, &va, sz, TEE_MATTR_PRW, VM_FLAG_PERMANENT,
-			      mobj, offs);
+	if (sz) {
+		res = vm_map(uctx, &va, sz, TEE_MATTR_PRW, VM_FLAG_PERMANENT,
+			     mobj, offs);
+		if (res)
+			return res;
+	}
+
+	tee_time_page_get(&mobj, &offs, &sz);
+	if (sz) {
+		va = 0;
+		res = vm_map(uctx, &va, sz, TEE_MATTR_PR | TEE_MATTR_UR,
+			     VM_FLAG_PERMANENT, mobj, offs);
+		if (res)
+			return res;
+#ifdef CFG_TA_TIME_PAGE
+		uctx->time_page_va = va;
+#endif
+	}
 
 	return TEE_SUCCESS;
 }
@@ -931,6 +953,8 @@ static TEE_Result param_mem_to_user_va(struct user_mode_ctx *uctx,
 			continue;
 		if (mem->mobj != region->mobj)
 			continue;
+		if (!mem->read_only && !(region->attr & TEE_MATTR_UW))
+			continue;
 
 		phys_offs = mobj_get_phys_offs(mem->mobj,
 					       CORE_MMU_USER_PARAM_SIZE);
@@ -968,6 +992,10 @@ static int cmp_param_mem(const void *a0, const void *a1)
 	if (ret)
 		return ret;
 
+	ret = CMP_TRILEAN(m0->read_only, m1->read_only);
+	if (ret)
+		return ret;
+
 	ret = CMP_TRILEAN(m0->offs, m1->offs);
 	if (ret)
 		return ret;
@@ -995,6 +1023,7 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 		phys_offs = mobj_get_phys_offs(param->u[n].mem.mobj,
 					       CORE_MMU_USER_PARAM_SIZE);
 		mem[n].mobj = param->u[n].mem.mobj;
+		mem[n].read_only = param->u[n].mem.read_only;
 		mem[n].offs = ROUNDDOWN(phys_offs + param->u[n].mem.offs,
 					CORE_MMU_USER_PARAM_SIZE);
 		mem[n].size = ROUNDUP(phys_offs + param->u[n].mem.offs -
@@ -1010,8 +1039,8 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 
 	/*
 	 * Sort arguments so NULL mobj is last, secure mobjs first, then by
-	 * mobj pointer value since those entries can't be merged either,
-	 * finally by offset.
+	 * mobj pointer value and access since those entries can't
+	 * be merged either, finally by offset.
 	 *
 	 * This should result in a list where all mergeable entries are
 	 * next to each other and unused/invalid entries are at the end.
@@ -1020,6 +1049,7 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 
 	for (n = 1, m = 0; n < TEE_NUM_PARAMS && mem[n].mobj; n++) {
 		if (mem[n].mobj == mem[m].mobj &&
+		    mem[n].read_only == mem[m].read_only &&
 		    (mem[n].offs == (mem[m].offs + mem[m].size) ||
 		     core_is_buffer_intersect(mem[m].offs, mem[m].size,
 					      mem[n].offs, mem[n].size))) {
@@ -1041,10 +1071,12 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 	check_param_map_empty(uctx);
 
 	for (n = 0; n < m; n++) {
+		uint32_t prot = TEE_MATTR_PRW | TEE_MATTR_URW;
 		vaddr_t va = 0;
 
-		res = vm_map(uctx, &va, mem[n].size,
-			     TEE_MATTR_PRW | TEE_MATTR_URW,
+		if (mem[n].read_only)
+			prot = TEE_MATTR_PR | TEE_MATTR_UR;
+		res = vm_map(uctx, &va, mem[n].size, prot,
 			     VM_FLAG_EPHEMERAL | VM_FLAG_SHAREABLE,
 			     mem[n].mobj, mem[n].offs);
 		if (res)
@@ -1247,6 +1279,78 @@ void *vm_pa2va(const struct user_mode_ctx *uctx, paddr_t pa, size_t pa_size)
 	return NULL;
 }
 
+#ifdef CFG_USER_ACCESS_CACHE
+void vm_access_cache_reset(void)
+{
+	struct thread_specific_data *tsd = thread_get_tsd();
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(tsd->access_cache); n++)
+		tsd->access_cache[n].uctx = NULL;
+	tsd->access_cache_next = 0;
+}
+
+/*
+ * A range checked with @cflags covers a check with @flags if all access
+ * checks of @flags were done. A range checked to be private to the TA
+ * covers a check where any owner is accepted, but not the reverse.
+ */
+static bool access_flags_covered(uint32_t cflags, uint32_t flags)
+{
+	uint32_t any = TEE_MEMORY_ACCESS_ANY_OWNER;
+
+	if ((flags & ~any) & ~(cflags & ~any))
+		return false;
+
+	return (flags & any) || !(cflags & any);
+}
+
+static bool access_cache_lookup(const struct user_mode_ctx *uctx,
+				uint32_t flags, uaddr_t start, uaddr_t end)
+{
+	struct thread_specific_data *tsd = thread_get_tsd();
+	struct user_access_range *r = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(tsd->access_cache); n++) {
+		r = tsd->access_cache + n;
+		if (r->uctx == uctx && start >= r->start && end <= r->end &&
+		    access_flags_covered(r->flags, flags))
+			return true;
+	}
+
+	return false;
+}
+
+static void access_cache_add(const struct user_mode_ctx *uctx,
+			     uint32_t flags, uaddr_t start, uaddr_t end)
+{
+	struct thread_specific_data *tsd = thread_get_tsd();
+	size_t n = tsd->access_cache_next;
+
+	tsd->access_cache[n] = (struct user_access_range){
+		.uctx = uctx,
+		.start = start,
+		.end = end,
+		.flags = flags,
+	};
+	tsd->access_cache_next = (n + 1) % ARRAY_SIZE(tsd->access_cache);
+}
+#else
+static bool access_cache_lookup(const struct user_mode_ctx *uctx __unused,
+				uint32_t flags __unused, uaddr_t start __unused,
+				uaddr_t end __unused)
+{
+	return false;
+}
+
+static void access_cache_add(const struct user_mode_ctx *uctx __unused,
+			     uint32_t flags __unused, uaddr_t start __unused,
+			     uaddr_t end __unused)
+{
+}
+#endif
+
 TEE_Result vm_check_access_rights(const struct user_mode_ctx *uctx,
 				  uint32_t flags, uaddr_t uaddr, size_t len)
 {
@@ -1262,6 +1366,9 @@ TEE_Result vm_check_access_rights(const struct user_mode_ctx *uctx,
 	    (flags & TEE_MEMORY_ACCESS_SECURE))
 		return TEE_ERROR_ACCESS_DENIED;
 
+	if (access_cache_lookup(uctx, flags, uaddr, end_addr))
+		return TEE_SUCCESS;
+
 	/*
 	 * Rely on TA private memory test to check if address range is private
 	 * to TA or not.
@@ -1292,6 +1399,8 @@ TEE_Result vm_check_access_rights(const struct user_mode_ctx *uctx,
 			return TEE_ERROR_ACCESS_DENIED;
 	}
 
+	access_cache_add(uctx, flags, uaddr, end_addr);
+
 	return TEE_SUCCESS;
 }
 
@@ -5,9 +5,14 @@
 #include <compiler.h>
 #include <drivers/clk.h>
 #include <drivers/regulator.h>
+#include <kernel/interrupt.h>
+#include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
+#include <kernel/tee_ta_manager.h>
 #include <kernel/tee_time.h>
+#include <kernel/workqueue.h>
 #include <malloc.h>
+#include <mm/pgt_cache.h>
 #include <mm/phys_mem.h>
 #include <mm/tee_mm.h>
 #include <mm/tee_pager.h>
@@ -110,15 +115,45 @@ static TEE_Result get_alloc_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	return TEE_SUCCESS;
 }
 
+static TEE_Result get_phys_mem_stats(uint32_t type,
+				     TEE_Param p[TEE_NUM_PARAMS])
+{
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!IS_ENABLED(CFG_CORE_PHYS_MEM_BUDDY))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (p[0].memref.size < sizeof(struct pta_stats_phys_mem)) {
+		p[0].memref.size = sizeof(struct pta_stats_phys_mem);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+	p[0].memref.size = sizeof(struct pta_stats_phys_mem);
+
+	phys_mem_frag_stats(p[0].memref.buffer);
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 {
 	struct tee_pager_stats stats = { };
+	bool with_ra = false;
 
+	/* The 4th read-ahead output value is optional */
 	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
 			    TEE_PARAM_TYPE_VALUE_OUTPUT,
 			    TEE_PARAM_TYPE_VALUE_OUTPUT,
-			    TEE_PARAM_TYPE_NONE) != type) {
-		EMSG("expect 3 output values as argument");
+			    TEE_PARAM_TYPE_VALUE_OUTPUT) == type) {
+		with_ra = true;
+	} else if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+				   TEE_PARAM_TYPE_VALUE_OUTPUT,
+				   TEE_PARAM_TYPE_VALUE_OUTPUT,
+				   TEE_PARAM_TYPE_NONE) != type) {
+		EMSG("expect 3 or 4 output values as argument");
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
@@ -129,6 +164,116 @@ static TEE_Result get_pager_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	p[1].value.b = stats.rw_hits;
 	p[2].value.a = stats.hidden_hits;
 	p[2].value.b = stats.zi_released;
+	if (with_ra) {
+		p[3].value.a = stats.ra_pages;
+		p[3].value.b = stats.ra_window_max;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_pager_policy_stats(uint32_t type,
+					 TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_pager_policy_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!IS_ENABLED(CFG_WITH_PAGER))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	tee_pager_get_policy_stats(&stats);
+	p[0].value.a = stats.policy;
+	p[0].value.b = stats.evictions;
+	p[1].value.a = stats.pages_hidden;
+	p[1].value.b = stats.hidden_hits;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_pager_compr_stats(uint32_t type,
+					TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct tee_pager_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!IS_ENABLED(CFG_CORE_RWP_COMPRESS) ||
+	    IS_ENABLED(CFG_CORE_PAGE_TAG_AND_IV))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	tee_pager_get_stats(&stats);
+	p[0].value.a = stats.compr_pages;
+	p[0].value.b = stats.compr_bytes;
+	p[1].value.a = stats.compr_pool_size;
+	p[1].value.b = 0;
+	if (stats.compr_bytes)
+		p[1].value.b = (uint64_t)stats.compr_pages * SMALL_PAGE_SIZE *
+			       100 / stats.compr_bytes;
+	p[2].value.a = stats.compr_loads;
+	p[2].value.b = stats.compr_load_us;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_mutex_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct mutex_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	switch (p[0].value.a) {
+	case STATS_MUTEX_ID_TA_MANAGER:
+		mutex_get_stats(&tee_ta_mutex, &stats);
+		break;
+	case STATS_MUTEX_ID_TA_SESSIONS:
+		mutex_get_stats(&tee_ta_sess_mutex, &stats);
+		break;
+	default:
+		return TEE_ERROR_ITEM_NOT_FOUND;
+	}
+
+	p[1].value.a = stats.locked;
+	p[1].value.b = stats.contended;
+	p[2].value.a = stats.spun;
+	p[2].value.b = stats.slept;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_pgt_cache_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct pgt_cache_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (IS_ENABLED(CFG_CORE_PREALLOC_EL0_TBLS))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	pgt_get_cache_stats(&stats);
+	p[0].value.a = stats.hits;
+	p[0].value.b = stats.misses;
+	p[1].value.a = stats.evictions;
+	p[1].value.b = stats.cached;
+	p[2].value.a = stats.size;
+	p[2].value.b = 0;
 
 	return TEE_SUCCESS;
 }
@@ -168,6 +313,58 @@ static TEE_Result get_user_ta_stats(uint32_t type,
 	return res;
 }
 
+static TEE_Result get_ta_busy_stats(uint32_t type,
+				    TEE_Param p[TEE_NUM_PARAMS])
+{
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	return tee_ta_busy_stats(p[0].memref.buffer, &p[0].memref.size);
+}
+
+static TEE_Result get_workqueue_stats(uint32_t type,
+				      TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct workqueue_stats stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT,
+			    TEE_PARAM_TYPE_VALUE_OUTPUT) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!IS_ENABLED(CFG_CORE_WORKQUEUE))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	workqueue_get_stats(&stats);
+	p[0].value.a = stats.queued;
+	p[0].value.b = stats.executed;
+	p[1].value.a = stats.bh_requests;
+	p[1].value.b = stats.bh_runs;
+	p[2].value.a = stats.max_latency_us;
+	p[2].value.b = 0;
+	if (stats.executed)
+		p[2].value.b = stats.total_latency_us / stats.executed;
+	p[3].value.a = stats.pending;
+	p[3].value.b = stats.cancelled;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_itr_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	return interrupt_get_stats(p[0].memref.buffer, &p[0].memref.size);
+}
+
 static TEE_Result get_system_time(uint32_t type,
 				  TEE_Param p[TEE_NUM_PARAMS])
 {
@@ -240,6 +437,22 @@ static TEE_Result invoke_command(void *psess __unused,
 		return get_system_time(ptypes, params);
 	case STATS_CMD_PRINT_DRIVER_INFO:
 		return print_driver_info(ptypes, params);
+	case STATS_CMD_PHYS_MEM_STATS:
+		return get_phys_mem_stats(ptypes, params);
+	case STATS_CMD_PGT_CACHE_STATS:
+		return get_pgt_cache_stats(ptypes, params);
+	case STATS_CMD_PAGER_POLICY_STATS:
+		return get_pager_policy_stats(ptypes, params);
+	case STATS_CMD_PAGER_COMPR_STATS:
+		return get_pager_compr_stats(ptypes, params);
+	case STATS_CMD_MUTEX_STATS:
+		return get_mutex_stats(ptypes, params);
+	case STATS_CMD_TA_BUSY_STATS:
+		return get_ta_busy_stats(ptypes, params);
+	case STATS_CMD_WORKQUEUE_STATS:
+		return get_workqueue_stats(ptypes, params);
+	case STATS_CMD_ITR_STATS:
+		return get_itr_stats(ptypes, params);
 	default:
 		break;
 	}
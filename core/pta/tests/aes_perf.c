@@ -5,6 +5,7 @@
 
 #include <compiler.h>
 #include <crypto/crypto.h>
+#include <kernel/tee_time.h>
 #include <pta_invoke_tests.h>
 #include <tee_api_defines.h>
 #include <tee_api_types.h>
@@ -164,7 +165,15 @@ TEE_Result core_aes_perf_tests(uint32_t param_types,
 						   TEE_PARAM_TYPE_VALUE_INPUT,
 						   TEE_PARAM_TYPE_MEMREF_INOUT,
 						   TEE_PARAM_TYPE_MEMREF_INOUT);
+	uint32_t timed_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						     TEE_PARAM_TYPE_VALUE_INOUT,
+						     TEE_PARAM_TYPE_MEMREF_INOUT,
+						     TEE_PARAM_TYPE_MEMREF_INOUT);
 	TEE_Result res = TEE_SUCCESS;
+	TEE_Time start = { };
+	TEE_Time end = { };
+	uint64_t bytes = 0;
+	uint32_t ms = 0;
 	TEE_OperationMode mode = 0;
 	unsigned int rep_count = 0;
 	unsigned int unit_size = 0;
@@ -172,7 +181,7 @@ TEE_Result core_aes_perf_tests(uint32_t param_types,
 	uint32_t algo = 0;
 	void *ctx = NULL;
 
-	if (param_types != exp_param_types)
+	if (param_types != exp_param_types && param_types != timed_param_types)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	switch (params[0].value.b) {
@@ -212,10 +221,32 @@ TEE_Result core_aes_perf_tests(uint32_t param_types,
 	if (res)
 		return res;
 
+	if (param_types != timed_param_types) {
+		res = do_update(ctx, algo, mode, rep_count, unit_size,
+				params[2].memref.buffer, params[2].memref.size,
+				params[3].memref.buffer);
+		goto out;
+	}
+
+	res = tee_time_get_sys_time(&start);
+	if (res)
+		goto out;
 	res = do_update(ctx, algo, mode, rep_count, unit_size,
 			params[2].memref.buffer, params[2].memref.size,
 			params[3].memref.buffer);
-
+	if (res)
+		goto out;
+	res = tee_time_get_sys_time(&end);
+	if (res)
+		goto out;
+
+	ms = (end.seconds - start.seconds) * 1000 + end.millis - start.millis;
+	params[1].value.a = ms;
+	bytes = (uint64_t)params[2].memref.size * rep_count * 1000;
+	if (ms)
+		bytes /= ms;
+	params[1].value.b = MIN(bytes / 1024, (uint64_t)UINT32_MAX);
+out:
 	free_ctx(&ctx, algo);
 	return res;
 }
@@ -433,6 +433,14 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 		return core_aes_perf_tests(nParamTypes, pParams);
 	case PTA_INVOKE_TESTS_CMD_DT_DRIVER_TESTS:
 		return core_dt_driver_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_PAGER_PERF:
+		return core_pager_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_TA_CHAIN_PERF:
+		return core_ta_chain_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_WORKQUEUE:
+		return core_workqueue_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_SGMEM:
+		return core_sgmem_tests(nParamTypes, pParams);
 	default:
 		break;
 	}
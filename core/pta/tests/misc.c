@@ -10,6 +10,7 @@
 #include <kernel/panic.h>
 #include <malloc.h>
 #include <mm/core_memprot.h>
+#include <mm/tee_mm.h>
 #include <stdbool.h>
 #include <trace.h>
 #include <util.h>
@@ -554,6 +555,87 @@ static int self_test_nex_malloc(void)
 }
 #endif
 
+#ifdef CFG_CORE_PHYS_MEM_BUDDY
+static bool check_mm_offset(tee_mm_entry_t *mm, uint32_t exp_offs)
+{
+	bool r = mm && tee_mm_get_offset(mm) == exp_offs;
+
+	LOG("  offset %"PRId32" (expect %"PRIu32") => %s",
+	    mm ? (int32_t)tee_mm_get_offset(mm) : -1, exp_offs,
+	    r ? "ok" : "FAILED");
+	return r;
+}
+
+/* test buddy placement in tee_mm, the pool memory is never accessed */
+static int self_test_mm_buddy(void)
+{
+	const paddr_t base = 0x10000000;
+	tee_mm_entry_t *mm[4] = { };
+	tee_mm_pool_t pool = { };
+	size_t n = 0;
+	int ret = 0;
+
+	LOG("tee_mm buddy tests:");
+	if (!tee_mm_init(&pool, base, 16 * SMALL_PAGE_SIZE, SMALL_PAGE_SHIFT,
+			 TEE_MM_POOL_NO_FLAGS) ||
+	    !tee_mm_enable_buddy(&pool)) {
+		LOG("  init FAILED");
+		return -1;
+	}
+
+	LOG("- 3 pages, 1 page and 4 pages");
+	mm[0] = tee_mm_alloc(&pool, 3 * SMALL_PAGE_SIZE);
+	mm[1] = tee_mm_alloc(&pool, SMALL_PAGE_SIZE);
+	mm[2] = tee_mm_alloc(&pool, 4 * SMALL_PAGE_SIZE);
+	/* The single page goes into the tail left over by the first one */
+	if (!check_mm_offset(mm[0], 0) || !check_mm_offset(mm[1], 3) ||
+	    !check_mm_offset(mm[2], 4))
+		ret = -1;
+	tee_mm_free(mm[0]);
+	tee_mm_free(mm[1]);
+
+	LOG("- carve out 2 pages at offset 9");
+	mm[3] = tee_mm_alloc2(&pool, base + 9 * SMALL_PAGE_SIZE,
+			      2 * SMALL_PAGE_SIZE);
+	if (!check_mm_offset(mm[3], 9))
+		ret = -1;
+
+	LOG("- 8 pages don't fit, 5 pages fit after the carve out");
+	mm[0] = tee_mm_alloc(&pool, 8 * SMALL_PAGE_SIZE);
+	if (mm[0]) {
+		LOG("  => FAILED");
+		tee_mm_free(mm[0]);
+		ret = -1;
+	}
+	mm[0] = tee_mm_alloc(&pool, 5 * SMALL_PAGE_SIZE);
+	if (!check_mm_offset(mm[0], 11))
+		ret = -1;
+
+	tee_mm_free(mm[0]);
+	tee_mm_free(mm[2]);
+	tee_mm_free(mm[3]);
+
+	LOG("- all pages coalesced");
+	mm[0] = tee_mm_alloc(&pool, 16 * SMALL_PAGE_SIZE);
+	if (!check_mm_offset(mm[0], 0))
+		ret = -1;
+	n = tee_mm_get_bytes(mm[0]);
+	tee_mm_free(mm[0]);
+	if (n != 16 * SMALL_PAGE_SIZE || !tee_mm_is_empty(&pool))
+		ret = -1;
+
+	tee_mm_final(&pool);
+	LOG("tee_mm buddy test done");
+
+	return ret;
+}
+#else
+static int self_test_mm_buddy(void)
+{
+	return 0;
+}
+#endif
+
 static int check_virt_to_phys(vaddr_t va, paddr_t exp_pa,
 			      enum teecore_memtypes m)
 {
@@ -664,7 +746,8 @@ TEE_Result core_self_tests(uint32_t nParamTypes __unused,
 	if (self_test_mul_signed_overflow() || self_test_add_overflow() ||
 	    self_test_sub_overflow() || self_test_mul_unsigned_overflow() ||
 	    self_test_division() || self_test_malloc() ||
-	    self_test_nex_malloc() || self_test_va2pa()) {
+	    self_test_nex_malloc() || self_test_va2pa() ||
+	    self_test_mm_buddy()) {
 		EMSG("some self_test_xxx failed! you should enable local LOG");
 		return TEE_ERROR_GENERIC;
 	}
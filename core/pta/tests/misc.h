@@ -34,6 +34,54 @@ static inline TEE_Result core_lockdep_tests(
 TEE_Result core_aes_perf_tests(uint32_t param_types,
 			       TEE_Param params[TEE_NUM_PARAMS]);
 
+#if defined(CFG_WITH_PAGER) && defined(CFG_WITH_STATS)
+TEE_Result core_pager_perf_tests(uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_pager_perf_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+#if defined(CFG_WITH_USER_TA) && defined(CFG_CORE_HAS_GENERIC_TIMER)
+TEE_Result core_ta_chain_perf_tests(uint32_t param_types,
+				    TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_ta_chain_perf_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+#ifdef CFG_CORE_WORKQUEUE
+TEE_Result core_workqueue_tests(uint32_t param_types,
+				TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_workqueue_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
+#ifdef CFG_CORE_SGMEM
+TEE_Result core_sgmem_tests(uint32_t param_types,
+			    TEE_Param params[TEE_NUM_PARAMS]);
+#else
+static inline TEE_Result core_sgmem_tests(
+		uint32_t param_types __unused,
+		TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+#endif
+
 TEE_Result core_dt_driver_tests(uint32_t param_types,
 				TEE_Param params[TEE_NUM_PARAMS]);
 
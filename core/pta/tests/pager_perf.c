@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/mutex.h>
+#include <kernel/tee_time.h>
+#include <mm/core_mmu.h>
+#include <mm/fobj.h>
+#include <mm/tee_mm.h>
+#include <mm/tee_pager.h>
+#include <pta_invoke_tests.h>
+#include <trace.h>
+#include <types_ext.h>
+
+#include "misc.h"
+
+/*
+ * Paged core regions can't be removed again, so the region used by the
+ * benchmark is allocated on first use and kept.
+ */
+#define PAGER_PERF_MAX_PAGES	128
+
+static struct mutex pager_perf_mu = MUTEX_INITIALIZER;
+static uint8_t *pager_perf_mem;
+
+static TEE_Result alloc_perf_mem(void)
+{
+	tee_mm_entry_t *mm = NULL;
+	struct fobj *fobj = NULL;
+
+	if (pager_perf_mem)
+		return TEE_SUCCESS;
+
+	mm = tee_mm_alloc(&core_virt_mem_pool,
+			  PAGER_PERF_MAX_PAGES * SMALL_PAGE_SIZE);
+	if (!mm)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	fobj = fobj_rw_paged_alloc(PAGER_PERF_MAX_PAGES);
+	if (!fobj) {
+		tee_mm_free(mm);
+		return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	tee_pager_add_core_region(tee_mm_get_smem(mm), PAGED_REGION_TYPE_RW,
+				  fobj);
+	fobj_put(fobj);
+	pager_perf_mem = (uint8_t *)tee_mm_get_smem(mm);
+
+	return TEE_SUCCESS;
+}
+
+static void touch_pages(size_t ws_pages, size_t rounds)
+{
+	volatile uint8_t *mem = pager_perf_mem;
+	size_t cold = ws_pages;
+	size_t n = 0;
+	size_t m = 0;
+
+	for (n = 0; n < rounds; n++) {
+		for (m = 0; m < ws_pages; m++)
+			mem[m * SMALL_PAGE_SIZE]++;
+
+		/* One page outside the working set streams through */
+		if (ws_pages < PAGER_PERF_MAX_PAGES) {
+			mem[cold * SMALL_PAGE_SIZE]++;
+			cold++;
+			if (cold == PAGER_PERF_MAX_PAGES)
+				cold = ws_pages;
+		}
+	}
+}
+
+/*
+ * Measures the fault rate of the pager page replacement policy when a
+ * fixed working set of paged RW pages is accessed repeatedly while
+ * another page outside the working set is accessed each round.
+ */
+TEE_Result core_pager_perf_tests(uint32_t param_types,
+				 TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT,
+						   TEE_PARAM_TYPE_NONE);
+	struct tee_pager_stats stats = { };
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Time start = { };
+	TEE_Time end = { };
+	size_t ws_pages = 0;
+	size_t rounds = 0;
+
+	if (param_types != exp_param_types)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	ws_pages = params[0].value.a;
+	rounds = params[0].value.b;
+	if (!ws_pages || ws_pages > PAGER_PERF_MAX_PAGES || !rounds)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&pager_perf_mu);
+
+	res = alloc_perf_mem();
+	if (res)
+		goto out;
+
+	/* Reset the counters, they only cover the benchmark below */
+	tee_pager_get_stats(&stats);
+
+	res = tee_time_get_sys_time(&start);
+	if (res)
+		goto out;
+	touch_pages(ws_pages, rounds);
+	res = tee_time_get_sys_time(&end);
+	if (res)
+		goto out;
+
+	tee_pager_get_stats(&stats);
+	params[1].value.a = stats.ro_hits + stats.rw_hits;
+	params[1].value.b = stats.hidden_hits;
+	params[2].value.a = stats.npages;
+	params[2].value.b = (end.seconds - start.seconds) * 1000 +
+			    end.millis - start.millis;
+
+	DMSG("policy %zu, %zu pages, %zu rounds: %"PRIu32" faults, %zu evictions",
+	     stats.policy, ws_pages, rounds, params[1].value.a,
+	     stats.evictions);
+out:
+	mutex_unlock(&pager_perf_mu);
+
+	return res;
+}
@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/msg_param.h>
+#include <kernel/refcount.h>
+#include <mm/core_memprot.h>
+#include <mm/core_mmu.h>
+#include <mm/mobj.h>
+#include <optee_msg.h>
+#include <string.h>
+#include <tee_api_defines.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <util.h>
+
+#include "misc.h"
+
+/*
+ * The test registers shared memory for two data pages and one page holding
+ * the segment list, all taken from the non-secure buffer of the caller.
+ */
+enum sgmem_test_shm {
+	SGMEM_TEST_DATA0,
+	SGMEM_TEST_DATA1,
+	SGMEM_TEST_SEGS,
+	SGMEM_TEST_NUM_SHM,
+};
+
+/*
+ * The addresses of these are used as cookies of the test shared memory,
+ * they aren't expected to collide with cookies assigned by normal world.
+ * The last one is never registered.
+ */
+static uint8_t sgmem_test_cookies[SGMEM_TEST_NUM_SHM + 1];
+
+static uint64_t test_cookie(enum sgmem_test_shm shm)
+{
+	return (vaddr_t)(sgmem_test_cookies + shm);
+}
+
+struct sgmem_test {
+	struct mobj *shm[SGMEM_TEST_NUM_SHM];
+	paddr_t pa[SGMEM_TEST_NUM_SHM];
+	struct optee_msg_sgmem_seg *segs;
+};
+
+static bool refs_released(struct sgmem_test *t)
+{
+	size_t n = 0;
+
+	for (n = 0; n < SGMEM_TEST_NUM_SHM; n++) {
+		if (refcount_val(&t->shm[n]->refc) != 1) {
+			EMSG("shm %zu: %u references", n,
+			     refcount_val(&t->shm[n]->refc));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Writes @num_segs segments to the segment list and checks that a
+ * parameter with @num_segs segments and @size bytes is rejected.
+ */
+static TEE_Result expect_rejected(struct sgmem_test *t, const char *what,
+				  const struct optee_msg_sgmem_seg *segs,
+				  size_t num_segs, uint64_t size)
+{
+	struct optee_msg_param_sgmem sgmem = {
+		.num_segs = num_segs,
+		.size = size,
+		.shm_ref = test_cookie(SGMEM_TEST_SEGS),
+	};
+	struct mobj **seg_mobjs = NULL;
+	size_t num_seg_mobjs = 0;
+	struct mobj *mobj = NULL;
+	size_t sz = 0;
+
+	if (segs)
+		memcpy(t->segs, segs, num_segs * sizeof(*segs));
+	mobj = msg_param_mobj_from_sgmem(&sgmem, &sz, &seg_mobjs,
+					 &num_seg_mobjs);
+	if (mobj) {
+		EMSG("%s: accepted", what);
+		mobj_put(mobj);
+		msg_param_put_sgmem_segs(seg_mobjs, num_seg_mobjs);
+		return TEE_ERROR_GENERIC;
+	}
+	if (!refs_released(t)) {
+		EMSG("%s: references leaked", what);
+		return TEE_ERROR_GENERIC;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result test_accepted(struct sgmem_test *t)
+{
+	const struct optee_msg_sgmem_seg segs[] = {
+		{ .shm_ref = test_cookie(SGMEM_TEST_DATA0),
+		  .offs = 16, .size = SMALL_PAGE_SIZE - 16 },
+		{ .shm_ref = test_cookie(SGMEM_TEST_DATA1),
+		  .offs = 0, .size = 32 },
+	};
+	struct optee_msg_param_sgmem sgmem = {
+		.num_segs = ARRAY_SIZE(segs),
+		.size = SMALL_PAGE_SIZE + 16,
+		.shm_ref = test_cookie(SGMEM_TEST_SEGS),
+	};
+	TEE_Result res = TEE_ERROR_GENERIC;
+	struct mobj **seg_mobjs = NULL;
+	size_t num_seg_mobjs = 0;
+	struct mobj *mobj = NULL;
+	paddr_t pa = 0;
+	size_t sz = 0;
+
+	memcpy(t->segs, segs, sizeof(segs));
+	mobj = msg_param_mobj_from_sgmem(&sgmem, &sz, &seg_mobjs,
+					 &num_seg_mobjs);
+	if (!mobj) {
+		EMSG("valid segment list rejected");
+		return TEE_ERROR_GENERIC;
+	}
+
+	if (sz != sgmem.size || num_seg_mobjs != ARRAY_SIZE(segs)) {
+		EMSG("size %zu, %zu segments", sz, num_seg_mobjs);
+		goto out;
+	}
+	if (mobj_get_pa(mobj, 0, 0, &pa) ||
+	    pa != t->pa[SGMEM_TEST_DATA0] + 16 ||
+	    mobj_get_pa(mobj, SMALL_PAGE_SIZE - 16, 0, &pa) ||
+	    pa != t->pa[SGMEM_TEST_DATA1]) {
+		EMSG("segments not mapped back to back");
+		goto out;
+	}
+	/* The segments must stay referenced while the mobj is used */
+	if (refcount_val(&t->shm[SGMEM_TEST_DATA0]->refc) != 2 ||
+	    refcount_val(&t->shm[SGMEM_TEST_DATA1]->refc) != 2) {
+		EMSG("segments not referenced");
+		goto out;
+	}
+	res = TEE_SUCCESS;
+out:
+	mobj_put(mobj);
+	msg_param_put_sgmem_segs(seg_mobjs, num_seg_mobjs);
+	if (!refs_released(t))
+		res = TEE_ERROR_GENERIC;
+
+	return res;
+}
+
+static TEE_Result test_rejected(struct sgmem_test *t)
+{
+	const struct optee_msg_sgmem_seg unaligned_end[] = {
+		{ .shm_ref = test_cookie(SGMEM_TEST_DATA0),
+		  .offs = 0, .size = SMALL_PAGE_SIZE - 16 },
+		{ .shm_ref = test_cookie(SGMEM_TEST_DATA1),
+		  .offs = 0, .size = 16 },
+	};
+	const struct optee_msg_sgmem_seg unaligned_start[] = {
+		{ .shm_ref = test_cookie(SGMEM_TEST_DATA0),
+		  .offs = 0, .size = SMALL_PAGE_SIZE },
+		{ .shm_ref = test_cookie(SGMEM_TEST_DATA1),
+		  .offs = 16, .size = 16 },
+	};
+	const struct optee_msg_sgmem_seg outside[] = {
+		{ .shm_ref = test_cookie(SGMEM_TEST_DATA0),
+		  .offs = 16, .size = SMALL_PAGE_SIZE },
+	};
+	const struct optee_msg_sgmem_seg unknown[] = {
+		{ .shm_ref = test_cookie(SGMEM_TEST_DATA0),
+		  .offs = 0, .size = SMALL_PAGE_SIZE },
+		{ .shm_ref = test_cookie(SGMEM_TEST_NUM_SHM),
+		  .offs = 0, .size = 16 },
+	};
+	TEE_Result res = TEE_SUCCESS;
+
+	res = expect_rejected(t, "unaligned end of segment", unaligned_end,
+			      ARRAY_SIZE(unaligned_end), SMALL_PAGE_SIZE);
+	if (!res)
+		res = expect_rejected(t, "unaligned start of segment",
+				      unaligned_start,
+				      ARRAY_SIZE(unaligned_start),
+				      SMALL_PAGE_SIZE + 16);
+	if (!res)
+		res = expect_rejected(t, "size mismatch", unaligned_start,
+				      ARRAY_SIZE(unaligned_start) - 1,
+				      SMALL_PAGE_SIZE + 16);
+	if (!res)
+		res = expect_rejected(t, "segment outside shm", outside,
+				      ARRAY_SIZE(outside), SMALL_PAGE_SIZE);
+	if (!res)
+		res = expect_rejected(t, "unknown shm", unknown,
+				      ARRAY_SIZE(unknown),
+				      SMALL_PAGE_SIZE + 16);
+	if (!res)
+		res = expect_rejected(t, "no segments", NULL, 0, 0);
+	if (!res)
+		res = expect_rejected(t, "too many segments", NULL,
+				      CFG_CORE_SGMEM_MAX_SEGS + 1,
+				      SMALL_PAGE_SIZE);
+
+	return res;
+}
+
+/*
+ * Tests that msg_param_mobj_from_sgmem() maps valid segments back to back
+ * and keeps them referenced, and that it rejects unaligned joins, a size
+ * mismatch and too many segments without leaking references.
+ */
+TEE_Result core_sgmem_tests(uint32_t param_types,
+			    TEE_Param params[TEE_NUM_PARAMS])
+{
+	struct sgmem_test t = { };
+	TEE_Result res = TEE_SUCCESS;
+	vaddr_t va = 0;
+	vaddr_t end = 0;
+	size_t n = 0;
+
+	if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INOUT,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	va = ROUNDUP((vaddr_t)params[0].memref.buffer, SMALL_PAGE_SIZE);
+	if (ADD_OVERFLOW((vaddr_t)params[0].memref.buffer,
+			 params[0].memref.size, &end) ||
+	    va > end || end - va < SGMEM_TEST_NUM_SHM * SMALL_PAGE_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < SGMEM_TEST_NUM_SHM; n++) {
+		t.pa[n] = virt_to_phys((void *)(va + n * SMALL_PAGE_SIZE));
+		if (!t.pa[n])
+			return TEE_ERROR_BAD_PARAMETERS;
+	}
+	t.segs = (void *)(va + SGMEM_TEST_SEGS * SMALL_PAGE_SIZE);
+
+	/* Fails unless the buffer is non-secure memory */
+	for (n = 0; n < SGMEM_TEST_NUM_SHM; n++) {
+		t.shm[n] = mobj_reg_shm_alloc(t.pa + n, 1, 0, test_cookie(n));
+		if (!t.shm[n]) {
+			res = TEE_ERROR_BAD_PARAMETERS;
+			goto out;
+		}
+	}
+
+	res = test_accepted(&t);
+	if (!res)
+		res = test_rejected(&t);
+out:
+	for (n = 0; n < SGMEM_TEST_NUM_SHM; n++)
+		mobj_put(t.shm[n]);
+
+	return res;
+}
@@ -5,4 +5,9 @@ srcs-y += misc.c
 cflags-misc.c-y += -fno-builtin
 srcs-y += mutex.c
 srcs-y += aes_perf.c
+srcs-$(call cfg-all-enabled,CFG_WITH_PAGER CFG_WITH_STATS) += pager_perf.c
+srcs-$(call cfg-all-enabled,CFG_WITH_USER_TA CFG_CORE_HAS_GENERIC_TIMER) += \
+	ta_chain_perf.c
+srcs-$(CFG_CORE_WORKQUEUE) += workqueue.c
+srcs-$(CFG_CORE_SGMEM) += sgmem.c
 srcs-$(CFG_DT_DRIVER_EMBEDDED_TEST) += dt_driver_test.c
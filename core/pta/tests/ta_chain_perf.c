@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/delay.h>
+#include <kernel/tee_ta_manager.h>
+#include <mm/core_mmu.h>
+#include <mm/fobj.h>
+#include <mm/mobj.h>
+#include <pta_invoke_tests.h>
+#include <string.h>
+#include <tee_api_defines.h>
+#include <trace.h>
+#include <types_ext.h>
+
+#include "misc.h"
+
+static uint32_t elapsed_us(uint64_t start)
+{
+	int us = timeout_elapsed_us(start);
+
+	if (us < 0)
+		return 0;
+	return us;
+}
+
+static TEE_Result alloc_buf(size_t size, struct mobj **mobj)
+{
+	struct fobj *fobj = NULL;
+
+	fobj = fobj_ta_mem_alloc(ROUNDUP_DIV(size, SMALL_PAGE_SIZE));
+	if (!fobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	*mobj = mobj_with_fobj_alloc(fobj, NULL, TEE_MATTR_MEM_TYPE_TAGGED);
+	fobj_put(fobj);
+	if (!*mobj)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Measures the latency of opening a session to a user TA, invoking a
+ * command once and closing the session again. When the TA forwards the
+ * request to other TAs the latency of the whole chain is measured.
+ *
+ * With PTA_TA_CHAIN_PERF_MEMREF the buffer is allocated here and passed
+ * as memref[0], this measures how the called TA maps it. A memref passed
+ * on by the called TA isn't private to it so TA to TA calls of the chain
+ * don't pass private memory. With PTA_TA_CHAIN_PERF_PRIVATE only the size
+ * is passed as value[0].a, the called TA is expected to pass a page
+ * aligned buffer of that size in its private memory on to the next TA.
+ * That's the path where CFG_TA_ZERO_COPY_PARAMS avoids copying.
+ */
+TEE_Result core_ta_chain_perf_tests(uint32_t param_types,
+				    TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+						   TEE_PARAM_TYPE_MEMREF_INPUT,
+						   TEE_PARAM_TYPE_VALUE_INOUT,
+						   TEE_PARAM_TYPE_VALUE_OUTPUT);
+	struct tee_ta_session_head sessions = TAILQ_HEAD_INITIALIZER(sessions);
+	const TEE_UUID pta_uuid = PTA_INVOKE_TESTS_UUID;
+	TEE_Identity clnt_id = { .login = TEE_LOGIN_TRUSTED_APP };
+	struct tee_ta_param open_param = { };
+	struct tee_ta_param param = { };
+	TEE_ErrorOrigin err = TEE_ORIGIN_TEE;
+	struct tee_ta_session *s = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	struct mobj *mobj = NULL;
+	uint64_t invoke_us = 0;
+	uint64_t close_us = 0;
+	uint64_t open_us = 0;
+	uint64_t start = 0;
+	TEE_UUID uuid = { };
+	uint32_t cmd = 0;
+	uint32_t mode = 0;
+	size_t rounds = 0;
+	size_t size = 0;
+	size_t n = 0;
+
+	if (param_types != exp_param_types ||
+	    params[1].memref.size != sizeof(uuid))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	memcpy(&uuid, params[1].memref.buffer, sizeof(uuid));
+	memcpy(&clnt_id.uuid, &pta_uuid, sizeof(pta_uuid));
+	cmd = params[0].value.a;
+	rounds = params[0].value.b;
+	size = params[2].value.a;
+	mode = params[2].value.b;
+	if (!rounds || (mode != PTA_TA_CHAIN_PERF_MEMREF &&
+			mode != PTA_TA_CHAIN_PERF_PRIVATE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (size && mode == PTA_TA_CHAIN_PERF_PRIVATE) {
+		param.types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					      TEE_PARAM_TYPE_NONE,
+					      TEE_PARAM_TYPE_NONE,
+					      TEE_PARAM_TYPE_NONE);
+		param.u[0].val.a = size;
+	} else if (size) {
+		res = alloc_buf(size, &mobj);
+		if (res)
+			return res;
+		param.types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INOUT,
+					      TEE_PARAM_TYPE_NONE,
+					      TEE_PARAM_TYPE_NONE,
+					      TEE_PARAM_TYPE_NONE);
+		param.u[0].mem.mobj = mobj;
+	}
+
+	for (n = 0; n < rounds; n++) {
+		start = timeout_init_us(0);
+		res = tee_ta_open_session(&err, &s, &sessions, &uuid, &clnt_id,
+					  TEE_TIMEOUT_INFINITE, &open_param);
+		if (res)
+			goto out;
+		open_us += elapsed_us(start);
+
+		if (mobj)
+			param.u[0].mem.size = size;
+		start = timeout_init_us(0);
+		s = tee_ta_get_session(s->id, true, &sessions);
+		res = tee_ta_invoke_command(&err, s, &clnt_id,
+					    TEE_TIMEOUT_INFINITE, cmd, &param);
+		tee_ta_put_session(s);
+		invoke_us += elapsed_us(start);
+
+		start = timeout_init_us(0);
+		if (res)
+			tee_ta_close_session(s, &sessions, &clnt_id);
+		else
+			res = tee_ta_close_session(s, &sessions, &clnt_id);
+		if (res)
+			goto out;
+		close_us += elapsed_us(start);
+	}
+
+	params[2].value.a = close_us / rounds;
+	params[2].value.b = 0;
+	params[3].value.a = open_us / rounds;
+	params[3].value.b = invoke_us / rounds;
+
+	DMSG("%zu rounds: open %"PRIu32" us, invoke %"PRIu32" us, close %"PRIu32" us",
+	     rounds, params[3].value.a, params[3].value.b, params[2].value.a);
+out:
+	if (res)
+		DMSG("round %zu: res %#"PRIx32" origin %"PRIu32, n, res, err);
+	mobj_put(mobj);
+
+	return res;
+}
@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <kernel/mutex.h>
+#include <kernel/tee_time.h>
+#include <kernel/thread.h>
+#include <kernel/virtualization.h>
+#include <kernel/workqueue.h>
+#include <trace.h>
+
+#include "misc.h"
+
+/* Max time to wait for the bottom half to execute queued work */
+#define WQ_TEST_TIMEOUT_MS	2000
+#define WQ_TEST_DELAY_MS	20
+#define WQ_TEST_LONG_DELAY_MS	10000
+#define WQ_TEST_REQUEUES	3
+
+/*
+ * struct wq_test_work - work counting its callbacks
+ * @work:	the work
+ * @count:	number of times the callback has been called
+ * @requeue:	number of times the callback queues @work again
+ * @guest_id:	guest to execute @work
+ */
+struct wq_test_work {
+	struct work work;
+	unsigned int count;
+	unsigned int requeue;
+	uint16_t guest_id;
+};
+
+/*
+ * struct wq_test_dwork - delayed work counting its callbacks
+ * @dwork:	the delayed work
+ * @count:	number of times the callback has been called
+ */
+struct wq_test_dwork {
+	struct delayed_work dwork;
+	unsigned int count;
+};
+
+enum wq_test_work_id {
+	WQ_TEST_BLOCKER,
+	WQ_TEST_COALESCED,
+	WQ_TEST_REQUEUED,
+	WQ_TEST_CANCELLED,
+	WQ_TEST_NUM_WORKS,
+};
+
+/* Works are accessed from interrupt context and must be in nexus memory */
+static struct wq_test_work test_works[WQ_TEST_NUM_WORKS] __nex_bss;
+static struct wq_test_dwork test_dworks[2] __nex_bss;
+
+/* Protects the counters above, held while queueing to block callbacks */
+static struct mutex wq_test_mutex = MUTEX_INITIALIZER;
+static struct condvar wq_test_cv = CONDVAR_INITIALIZER;
+
+static void test_work_cb(struct work *work)
+{
+	struct wq_test_work *w = container_of(work, struct wq_test_work, work);
+
+	mutex_lock(&wq_test_mutex);
+	w->count++;
+	if (w->count <= w->requeue && !work_queue(work, w->guest_id))
+		EMSG("work %p pending in its own callback", (void *)work);
+	condvar_broadcast(&wq_test_cv);
+	mutex_unlock(&wq_test_mutex);
+}
+
+static void test_dwork_cb(struct work *work)
+{
+	struct wq_test_dwork *w = container_of(work, struct wq_test_dwork,
+					       dwork.work);
+
+	mutex_lock(&wq_test_mutex);
+	w->count++;
+	condvar_broadcast(&wq_test_cv);
+	mutex_unlock(&wq_test_mutex);
+}
+
+/* Waits until *@count reaches @expect, requires wq_test_mutex */
+static TEE_Result wait_count(unsigned int *count, unsigned int expect)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	while (*count < expect) {
+		res = condvar_wait_timeout(&wq_test_cv, &wq_test_mutex,
+					   WQ_TEST_TIMEOUT_MS);
+		if (res) {
+			EMSG("count %u, expected %u", *count, expect);
+			return res;
+		}
+	}
+
+	return TEE_SUCCESS;
+}
+
+static void cancel_all(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(test_works); n++)
+		work_cancel(&test_works[n].work);
+	for (n = 0; n < ARRAY_SIZE(test_dworks); n++)
+		work_cancel_delayed(&test_dworks[n].dwork);
+}
+
+/*
+ * Queues works while the callback of a first blocking work can't get
+ * wq_test_mutex. Foreign interrupts are masked so all works end up in
+ * the queue of the same CPU, behind the blocking work, and stay pending
+ * until wq_test_mutex is released.
+ */
+static TEE_Result test_queue(uint16_t guest_id)
+{
+	struct wq_test_work *blocker = test_works + WQ_TEST_BLOCKER;
+	struct wq_test_work *coalesced = test_works + WQ_TEST_COALESCED;
+	struct wq_test_work *requeued = test_works + WQ_TEST_REQUEUED;
+	struct wq_test_work *cancelled = test_works + WQ_TEST_CANCELLED;
+	TEE_Result res = TEE_ERROR_BAD_STATE;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(test_works); n++) {
+		work_init(&test_works[n].work, test_work_cb);
+		test_works[n].count = 0;
+		test_works[n].requeue = 0;
+		test_works[n].guest_id = guest_id;
+	}
+	requeued->requeue = WQ_TEST_REQUEUES;
+
+	mutex_lock(&wq_test_mutex);
+	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
+
+	if (!work_queue(&blocker->work, guest_id) ||
+	    !work_queue(&coalesced->work, guest_id)) {
+		EMSG("idle work not queued");
+		goto out_unmask;
+	}
+	if (work_queue(&coalesced->work, guest_id)) {
+		EMSG("pending work queued twice");
+		goto out_unmask;
+	}
+	if (!work_queue(&requeued->work, guest_id) ||
+	    !work_queue(&cancelled->work, guest_id)) {
+		EMSG("idle work not queued");
+		goto out_unmask;
+	}
+	if (!work_cancel(&cancelled->work) || work_cancel(&cancelled->work)) {
+		EMSG("pending work not cancelled exactly once");
+		goto out_unmask;
+	}
+
+	thread_unmask_exceptions(exceptions);
+
+	res = wait_count(&blocker->count, 1);
+	if (!res)
+		res = wait_count(&coalesced->count, 1);
+	if (!res)
+		res = wait_count(&requeued->count, WQ_TEST_REQUEUES + 1);
+	if (res)
+		goto out;
+
+	if (coalesced->count != 1 || cancelled->count) {
+		EMSG("coalesced work called %u times, cancelled work %u times",
+		     coalesced->count, cancelled->count);
+		res = TEE_ERROR_BAD_STATE;
+	}
+	goto out;
+
+out_unmask:
+	thread_unmask_exceptions(exceptions);
+out:
+	mutex_unlock(&wq_test_mutex);
+	return res;
+}
+
+static TEE_Result test_delayed(uint16_t guest_id)
+{
+	struct wq_test_dwork *delayed = test_dworks;
+	struct wq_test_dwork *cancelled = test_dworks + 1;
+	TEE_Result res = TEE_SUCCESS;
+	TEE_Time start = { };
+	TEE_Time end = { };
+	TEE_Time d = { };
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(test_dworks); n++) {
+		delayed_work_init(&test_dworks[n].dwork, test_dwork_cb);
+		test_dworks[n].count = 0;
+	}
+
+	res = tee_time_get_sys_time(&start);
+	if (res)
+		return res;
+
+	res = work_queue_delayed(&delayed->dwork, guest_id, WQ_TEST_DELAY_MS);
+	if (res == TEE_ERROR_NOT_SUPPORTED) {
+		DMSG("delayed work not supported, skipped");
+		return TEE_SUCCESS;
+	}
+	if (res)
+		return res;
+	if (work_queue_delayed(&delayed->dwork, guest_id,
+			       WQ_TEST_DELAY_MS) != TEE_ERROR_BUSY) {
+		EMSG("armed delayed work queued twice");
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	res = work_queue_delayed(&cancelled->dwork, guest_id,
+				 WQ_TEST_LONG_DELAY_MS);
+	if (res)
+		return res;
+	if (!work_cancel_delayed(&cancelled->dwork) ||
+	    work_cancel_delayed(&cancelled->dwork)) {
+		EMSG("armed delayed work not cancelled exactly once");
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	mutex_lock(&wq_test_mutex);
+	res = wait_count(&delayed->count, 1);
+	mutex_unlock(&wq_test_mutex);
+	if (res)
+		return res;
+
+	res = tee_time_get_sys_time(&end);
+	if (res)
+		return res;
+	TEE_TIME_SUB(end, start, d);
+	if (d.seconds * 1000 + d.millis < WQ_TEST_DELAY_MS) {
+		EMSG("delayed work executed after %"PRIu32" ms",
+		     d.seconds * 1000 + d.millis);
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	if (cancelled->count) {
+		EMSG("cancelled delayed work executed");
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * Tests queueing, coalescing, requeueing from the callback, delaying and
+ * cancelling of work. The work is executed by the bottom half so normal
+ * world must serve asynchronous notifications.
+ */
+TEE_Result core_workqueue_tests(uint32_t param_types,
+				TEE_Param params[TEE_NUM_PARAMS] __unused)
+{
+	uint16_t guest_id = virt_get_current_guest_id();
+	struct workqueue_stats before = { };
+	struct workqueue_stats after = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	if (param_types != TEE_PARAM_TYPES(TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE,
+					   TEE_PARAM_TYPE_NONE))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	workqueue_get_stats(&before);
+
+	res = test_queue(guest_id);
+	if (!res)
+		res = test_delayed(guest_id);
+	if (res) {
+		/* Don't leave work pending on static memory reused next run */
+		cancel_all();
+		return res;
+	}
+
+	workqueue_get_stats(&after);
+	DMSG("queued %"PRIu32", executed %"PRIu32", cancelled %"PRIu32", bottom halves %"PRIu32,
+	     after.queued - before.queued, after.executed - before.executed,
+	     after.cancelled - before.cancelled,
+	     after.bh_runs - before.bh_runs);
+	if (after.cancelled == before.cancelled ||
+	    after.executed - before.executed < WQ_TEST_REQUEUES + 3) {
+		EMSG("unexpected workqueue statistics");
+		return TEE_ERROR_BAD_STATE;
+	}
+
+	return TEE_SUCCESS;
+}
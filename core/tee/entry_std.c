@@ -166,6 +166,24 @@ static TEE_Result set_rmem_param(const struct optee_msg_param_rmem *rmem,
 	return TEE_SUCCESS;
 }
 #endif /*CFG_CORE_DYN_SHM*/
+
+#ifdef CFG_CORE_SGMEM
+static TEE_Result set_sgmem_param(const struct optee_msg_param_sgmem *sgmem,
+				  struct param_mem *mem)
+{
+	size_t sz = 0;
+
+	mem->mobj = msg_param_mobj_from_sgmem(sgmem, &sz, &mem->seg_mobjs,
+					      &mem->num_seg_mobjs);
+	if (!mem->mobj)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mem->offs = 0;
+	mem->size = sz;
+
+	return TEE_SUCCESS;
+}
+#endif /*CFG_CORE_SGMEM*/
 #endif /*!CFG_CORE_FFA*/
 
 static TEE_Result copy_in_params(const struct optee_msg_param *params,
@@ -237,6 +255,18 @@ static TEE_Result copy_in_params(const struct optee_msg_param *params,
 				OPTEE_MSG_ATTR_TYPE_RMEM_INPUT;
 			break;
 #endif /*CFG_CORE_DYN_SHM*/
+#ifdef CFG_CORE_SGMEM
+		case OPTEE_MSG_ATTR_TYPE_SGMEM_INPUT:
+		case OPTEE_MSG_ATTR_TYPE_SGMEM_OUTPUT:
+		case OPTEE_MSG_ATTR_TYPE_SGMEM_INOUT:
+			res = set_sgmem_param(&params[n].u.sgmem,
+					      &ta_param->u[n].mem);
+			if (res)
+				return res;
+			pt[n] = TEE_PARAM_TYPE_MEMREF_INPUT + attr -
+				OPTEE_MSG_ATTR_TYPE_SGMEM_INPUT;
+			break;
+#endif /*CFG_CORE_SGMEM*/
 #endif /*!CFG_CORE_FFA*/
 		default:
 			return TEE_ERROR_BAD_PARAMETERS;
@@ -265,6 +295,15 @@ static void cleanup_shm_refs(const uint64_t *saved_attr,
 #endif
 			mobj_put(param->u[n].mem.mobj);
 			break;
+#ifdef CFG_CORE_SGMEM
+		case OPTEE_MSG_ATTR_TYPE_SGMEM_INPUT:
+		case OPTEE_MSG_ATTR_TYPE_SGMEM_OUTPUT:
+		case OPTEE_MSG_ATTR_TYPE_SGMEM_INOUT:
+			mobj_put(param->u[n].mem.mobj);
+			msg_param_put_sgmem_segs(param->u[n].mem.seg_mobjs,
+						 param->u[n].mem.num_seg_mobjs);
+			break;
+#endif
 		default:
 			break;
 		}
@@ -289,6 +328,11 @@ static void copy_out_param(struct tee_ta_param *ta_param, uint32_t num_params,
 			case OPTEE_MSG_ATTR_TYPE_RMEM_INOUT:
 				params[n].u.rmem.size = ta_param->u[n].mem.size;
 				break;
+			case OPTEE_MSG_ATTR_TYPE_SGMEM_OUTPUT:
+			case OPTEE_MSG_ATTR_TYPE_SGMEM_INOUT:
+				params[n].u.sgmem.size =
+					ta_param->u[n].mem.size;
+				break;
 			default:
 				break;
 			}
@@ -500,7 +500,7 @@ static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
 err:
 	crypto_authenc_final(ctx);
 err_free:
-	crypto_authenc_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_FS_HTREE_AUTH_ENC_ALG);
 	return res;
 }
 
@@ -514,7 +514,7 @@ static TEE_Result authenc_decrypt_final(void *ctx, const uint8_t *tag,
 	res = crypto_authenc_dec_final(ctx, crypt, len, plain, &out_size, tag,
 				       TEE_FS_HTREE_TAG_SIZE);
 	crypto_authenc_final(ctx);
-	crypto_authenc_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_FS_HTREE_AUTH_ENC_ALG);
 
 	if (res == TEE_SUCCESS && out_size != len)
 		return TEE_ERROR_GENERIC;
@@ -535,7 +535,7 @@ static TEE_Result authenc_encrypt_final(void *ctx, uint8_t *tag,
 	res = crypto_authenc_enc_final(ctx, plain, len, crypt, &out_size, tag,
 				       &out_tag_size);
 	crypto_authenc_final(ctx);
-	crypto_authenc_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_FS_HTREE_AUTH_ENC_ALG);
 
 	if (res == TEE_SUCCESS &&
 	    (out_size != len || out_tag_size != TEE_FS_HTREE_TAG_SIZE))
@@ -590,7 +590,7 @@ static TEE_Result verify_tree(struct tee_fs_htree *ht)
 		return res;
 
 	res = htree_traverse_post_order(ht, verify_node, ctx);
-	crypto_hash_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_FS_HTREE_HASH_ALG);
 
 	return res;
 }
@@ -609,7 +609,7 @@ static TEE_Result init_root_node(struct tee_fs_htree *ht)
 
 	res = calc_node_hash(&ht->root, &ht->imeta.meta, ctx,
 			     ht->root.node.hash);
-	crypto_hash_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_FS_HTREE_HASH_ALG);
 
 	return res;
 }
@@ -796,7 +796,7 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (counter)
 		*counter = ht->head.counter;
 out:
-	crypto_hash_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_FS_HTREE_HASH_ALG);
 	if (res != TEE_SUCCESS)
 		tee_fs_htree_close(ht_arg);
 	return res;
@@ -66,7 +66,7 @@ static TEE_Result do_hmac(void *out_key, size_t out_key_size,
 	res = TEE_SUCCESS;
 
 exit:
-	crypto_mac_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_FS_KM_HMAC_ALG);
 	return res;
 }
 
@@ -123,7 +123,7 @@ TEE_Result tee_fs_fek_crypt(const TEE_UUID *uuid, TEE_OperationMode mode,
 	memcpy(out_key, dst_key, sizeof(dst_key));
 
 exit:
-	crypto_cipher_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_FS_KM_ENC_FEK_ALG);
 	memzero_explicit(tsk, sizeof(tsk));
 	memzero_explicit(dst_key, sizeof(dst_key));
 
@@ -198,7 +198,7 @@ static TEE_Result aes_ecb(uint8_t out[TEE_AES_BLOCK_SIZE],
 	res = TEE_SUCCESS;
 
 out:
-	crypto_cipher_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_ALG_AES_ECB_NOPAD);
 	return res;
 }
 
@@ -266,7 +266,7 @@ TEE_Result tee_fs_crypt_block(const TEE_UUID *uuid, uint8_t *out,
 	crypto_cipher_final(ctx);
 
 exit:
-	crypto_cipher_free_ctx(ctx);
+	crypto_recycle_ctx(ctx, TEE_ALG_AES_CBC_NOPAD);
 wipe:
 	memzero_explicit(fek, sizeof(fek));
 	memzero_explicit(iv, sizeof(iv));
@@ -3,6 +3,7 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <kernel/user_ta.h>
 #include <mm/vm.h>
 #include <stdlib.h>
 #include <tee_api_defines.h>
@@ -15,6 +16,8 @@
 void tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o)
 {
 	TAILQ_INSERT_TAIL(&utc->objects, o, link);
+	LIST_INSERT_HEAD(utc->obj_hash + user_ta_handle_hash((vaddr_t)o), o,
+			 hash_link);
 }
 
 TEE_Result tee_obj_get(struct user_ta_ctx *utc, vaddr_t obj_id,
@@ -22,7 +25,8 @@ TEE_Result tee_obj_get(struct user_ta_ctx *utc, vaddr_t obj_id,
 {
 	struct tee_obj *o;
 
-	TAILQ_FOREACH(o, &utc->objects, link) {
+	LIST_FOREACH(o, utc->obj_hash + user_ta_handle_hash(obj_id),
+		     hash_link) {
 		if (obj_id == (vaddr_t)o) {
 			*obj = o;
 			return TEE_SUCCESS;
@@ -34,6 +38,7 @@ TEE_Result tee_obj_get(struct user_ta_ctx *utc, vaddr_t obj_id,
 void tee_obj_close(struct user_ta_ctx *utc, struct tee_obj *o)
 {
 	TAILQ_REMOVE(&utc->objects, o, link);
+	LIST_REMOVE(o, hash_link);
 
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT)) {
 		o->pobj->fops->close(&o->fh);
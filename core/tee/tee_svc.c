@@ -646,11 +646,31 @@ out:
 	return res;
 }
 
+/*
+ * A buffer in TA private memory may only be exposed to another TA if it
+ * covers whole pages, nothing but the buffer itself is shared then.
+ */
+static bool is_zero_copy_buf(void *va, size_t size)
+{
+	return IS_ENABLED(CFG_TA_ZERO_COPY_PARAMS) &&
+	       IS_ALIGNED((vaddr_t)va, UTEE_ZERO_COPY_ALIGN) &&
+	       IS_ALIGNED(size, UTEE_ZERO_COPY_ALIGN);
+}
+
+static bool is_user_writable(struct user_ta_ctx *utc, void *va, size_t size)
+{
+	uint32_t flags = TEE_MEMORY_ACCESS_WRITE | TEE_MEMORY_ACCESS_ANY_OWNER;
+
+	return !vm_check_access_rights(&utc->uctx, flags, (uaddr_t)va, size);
+}
+
 /*
  * TA invokes some TA with parameter.
  * If some parameters are memory references:
  * - either the memref is inside TA private RAM: TA is not allowed to expose
- *   its private RAM: use a temporary memory buffer and copy the data.
+ *   its private RAM: use a temporary memory buffer and copy the data. With
+ *   CFG_TA_ZERO_COPY_PARAMS whole pages of private RAM are exposed as is,
+ *   read-only for MEMREF_INPUT.
  * - or the memref is not in the TA private RAM:
  *   - if the memref was mapped to the TA, TA is allowed to expose it.
  *   - if so, converts memref virtual address into a physical address.
@@ -694,7 +714,10 @@ static TEE_Result tee_svc_copy_param(struct ts_session *sess,
 	/* All mobj in param are of type MOJB_TYPE_VIRT */
 
 	for (n = 0; n < TEE_NUM_PARAMS; n++) {
-		switch (TEE_PARAM_TYPE_GET(param->types, n)) {
+		uint32_t type = TEE_PARAM_TYPE_GET(param->types, n);
+		bool priv = false;
+
+		switch (type) {
 		case TEE_PARAM_TYPE_MEMREF_INPUT:
 		case TEE_PARAM_TYPE_MEMREF_OUTPUT:
 		case TEE_PARAM_TYPE_MEMREF_INOUT:
@@ -708,7 +731,8 @@ static TEE_Result tee_svc_copy_param(struct ts_session *sess,
 				return TEE_ERROR_BAD_PARAMETERS;
 
 			/* uTA cannot expose its private memory */
-			if (vm_buf_is_inside_um_private(&utc->uctx, va, s))
+			priv = vm_buf_is_inside_um_private(&utc->uctx, va, s);
+			if (priv && !is_zero_copy_buf(va, s))
 				return TEE_ERROR_BAD_PARAMETERS;
 
 			res = vm_buf_to_mboj_offs(&utc->uctx, va, s,
@@ -716,6 +740,15 @@ static TEE_Result tee_svc_copy_param(struct ts_session *sess,
 						  &param->u[n].mem.offs);
 			if (res != TEE_SUCCESS)
 				return res;
+
+			/*
+			 * Private memory and memory the calling TA can't
+			 * write, such as a read-only memref it has been
+			 * passed itself, is read-only in the called TA.
+			 */
+			if (type == TEE_PARAM_TYPE_MEMREF_INPUT &&
+			    (priv || !is_user_writable(utc, va, s)))
+				param->u[n].mem.read_only = true;
 			break;
 		default:
 			break;
@@ -1002,6 +1035,22 @@ TEE_Result syscall_get_time(unsigned long cat, TEE_Time *mytime)
 	return res;
 }
 
+TEE_Result syscall_get_time_page(uint64_t *va __maybe_unused)
+{
+#ifdef CFG_TA_TIME_PAGE
+	struct ts_session *s = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(s->ctx);
+	uint64_t v = utc->uctx.time_page_va;
+
+	if (!v)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	return copy_to_user_private(va, &v, sizeof(v));
+#else
+	return TEE_ERROR_NOT_SUPPORTED;
+#endif
+}
+
 TEE_Result syscall_set_ta_time(const TEE_Time *mytime)
 {
 	struct ts_session *s = ts_get_current_session();
@@ -47,6 +47,7 @@ enum cryp_state {
 typedef void (*tee_cryp_ctx_finalize_func_t) (void *ctx);
 struct tee_cryp_state {
 	TAILQ_ENTRY(tee_cryp_state) link;
+	LIST_ENTRY(tee_cryp_state) hash_link;
 	uint32_t algo;
 	uint32_t mode;
 	vaddr_t key1;
@@ -54,6 +55,10 @@ struct tee_cryp_state {
 	void *ctx;
 	tee_cryp_ctx_finalize_func_t ctx_finalize;
 	enum cryp_state state;
+	/* Key cache, see init_with_key() */
+	void *key_ctx;
+	uint8_t *key;
+	size_t key_len;
 };
 
 struct tee_cryp_obj_secret {
@@ -2582,7 +2587,8 @@ static TEE_Result tee_svc_cryp_get_state(struct ts_session *sess,
 	struct tee_cryp_state *s;
 	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
 
-	TAILQ_FOREACH(s, &utc->cryp_states, link) {
+	LIST_FOREACH(s, utc->cryp_state_hash + user_ta_handle_hash(state_id),
+		     hash_link) {
 		if (state_id == (vaddr_t)s) {
 			*state = s;
 			return TEE_SUCCESS;
@@ -2591,6 +2597,88 @@ static TEE_Result tee_svc_cryp_get_state(struct ts_session *sess,
 	return TEE_ERROR_BAD_PARAMETERS;
 }
 
+static void key_cache_clear(struct tee_cryp_state *cs)
+{
+	crypto_recycle_ctx(cs->key_ctx, cs->algo);
+	cs->key_ctx = NULL;
+	if (cs->key) {
+		memzero_explicit(cs->key, cs->key_len);
+		free(cs->key);
+		cs->key = NULL;
+	}
+	cs->key_len = 0;
+}
+
+static TEE_Result init_ctx_with_key(struct tee_cryp_state *cs, void *ctx,
+				    const uint8_t *key, size_t key_len)
+{
+	if (TEE_ALG_GET_CLASS(cs->algo) == TEE_OPERATION_MAC)
+		return crypto_mac_init(ctx, key, key_len);
+
+	return crypto_cipher_init(ctx, cs->mode, key, key_len, NULL, 0, NULL,
+				  0);
+}
+
+static void copy_ctx_state(struct tee_cryp_state *cs, void *dst, void *src)
+{
+	if (TEE_ALG_GET_CLASS(cs->algo) == TEE_OPERATION_MAC)
+		crypto_mac_copy_state(dst, src);
+	else
+		crypto_cipher_copy_state(dst, src);
+}
+
+static TEE_Result alloc_key_ctx(struct tee_cryp_state *cs)
+{
+	if (TEE_ALG_GET_CLASS(cs->algo) == TEE_OPERATION_MAC)
+		return crypto_mac_alloc_ctx(&cs->key_ctx, cs->algo);
+
+	return crypto_cipher_alloc_ctx(&cs->key_ctx, cs->algo);
+}
+
+/*
+ * Initializes the MAC or cipher context of @cs with @key only, no IV or
+ * second key. If the previous initialization used the same key the state
+ * of cs->key_ctx, a context initialized with that key, is copied instead
+ * of expanding the key again. cs->key_ctx is only allocated once a key is
+ * used a second time so operations initialized once don't pay for it.
+ */
+static TEE_Result init_with_key(struct tee_cryp_state *cs,
+				const uint8_t *key, size_t key_len)
+{
+	TEE_Result res = TEE_SUCCESS;
+	bool same_key = false;
+
+	if (!IS_ENABLED(CFG_CRYPTO_KEY_CACHE))
+		return init_ctx_with_key(cs, cs->ctx, key, key_len);
+
+	same_key = cs->key && cs->key_len == key_len &&
+		   !consttime_memcmp(cs->key, key, key_len);
+	if (same_key && cs->key_ctx) {
+		copy_ctx_state(cs, cs->ctx, cs->key_ctx);
+		return TEE_SUCCESS;
+	}
+
+	res = init_ctx_with_key(cs, cs->ctx, key, key_len);
+	if (res)
+		return res;
+
+	if (same_key) {
+		/* The cache is an optimization, ignore allocation errors */
+		if (!alloc_key_ctx(cs))
+			copy_ctx_state(cs, cs->key_ctx, cs->ctx);
+		return TEE_SUCCESS;
+	}
+
+	key_cache_clear(cs);
+	cs->key = malloc(key_len);
+	if (cs->key) {
+		memcpy(cs->key, key, key_len);
+		cs->key_len = key_len;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
 {
 	struct tee_obj *o;
@@ -2601,21 +2689,17 @@ static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
 		tee_obj_close(utc, o);
 
 	TAILQ_REMOVE(&utc->cryp_states, cs, link);
+	LIST_REMOVE(cs, hash_link);
 	if (cs->ctx_finalize != NULL)
 		cs->ctx_finalize(cs->ctx);
 
 	switch (TEE_ALG_GET_CLASS(cs->algo)) {
 	case TEE_OPERATION_CIPHER:
-		crypto_cipher_free_ctx(cs->ctx);
-		break;
 	case TEE_OPERATION_AE:
-		crypto_authenc_free_ctx(cs->ctx);
-		break;
 	case TEE_OPERATION_DIGEST:
-		crypto_hash_free_ctx(cs->ctx);
-		break;
 	case TEE_OPERATION_MAC:
-		crypto_mac_free_ctx(cs->ctx);
+		key_cache_clear(cs);
+		crypto_recycle_ctx(cs->ctx, cs->algo);
 		break;
 	default:
 		assert(!cs->ctx);
@@ -2814,6 +2898,8 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	if (!cs)
 		return TEE_ERROR_OUT_OF_MEMORY;
 	TAILQ_INSERT_TAIL(&utc->cryp_states, cs, link);
+	LIST_INSERT_HEAD(utc->cryp_state_hash + user_ta_handle_hash((vaddr_t)cs),
+			 cs, hash_link);
 	cs->algo = algo;
 	cs->mode = mode;
 	cs->state = CRYP_STATE_UNINITIALIZED;
@@ -2997,8 +3083,8 @@ TEE_Result syscall_hash_init(unsigned long state,
 				return TEE_ERROR_BAD_PARAMETERS;
 
 			key = (struct tee_cryp_obj_secret *)o->attr;
-			res = crypto_mac_init(cs->ctx, (void *)(key + 1),
-					      key->key_size);
+			res = init_with_key(cs, (void *)(key + 1),
+					    key->key_size);
 			if (res != TEE_SUCCESS)
 				return res;
 			break;
@@ -3232,6 +3318,8 @@ TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
 					 (uint8_t *)(key1 + 1), key1->key_size,
 					 (uint8_t *)(key2 + 1), key2->key_size,
 					 iv_bbuf, iv_len);
+	} else if (!iv_len) {
+		res = init_with_key(cs, (uint8_t *)(key1 + 1), key1->key_size);
 	} else {
 		res = crypto_cipher_init(cs->ctx, cs->mode,
 					 (uint8_t *)(key1 + 1), key1->key_size,
@@ -4389,6 +4477,198 @@ out:
 	return res;
 }
 
+static TEE_Result get_user_buf_u64(uint64_t va, uint64_t len, void **buf,
+				   size_t *buf_len)
+{
+	vaddr_t v = 0;
+
+	if (ADD_OVERFLOW(0, va, &v) || ADD_OVERFLOW(0, len, buf_len))
+		return TEE_ERROR_OVERFLOW;
+	*buf = (void *)v;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result syscall_cryp_oneshot(unsigned long state,
+				struct utee_cryp_oneshot *usr_args)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct utee_cryp_oneshot args = { };
+	struct tee_cryp_state *cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t iv_len = 0;
+	size_t aad_len = 0;
+	size_t src_len = 0;
+	size_t tag_len = 0;
+	size_t dst_len = 0;
+	void *iv = NULL;
+	void *aad = NULL;
+	void *src = NULL;
+	void *dst = NULL;
+	void *tag = NULL;
+
+	res = copy_from_user(&args, usr_args, sizeof(args));
+	if (res)
+		return res;
+
+	/*
+	 * The buffers are checked by the functions below, the output
+	 * lengths are read and updated directly in @usr_args.
+	 */
+	res = get_user_buf_u64(args.iv, args.iv_len, &iv, &iv_len);
+	if (!res)
+		res = get_user_buf_u64(args.aad, args.aad_len, &aad, &aad_len);
+	if (!res)
+		res = get_user_buf_u64(args.src, args.src_len, &src, &src_len);
+	if (!res)
+		res = get_user_buf_u64(args.dst, args.dst_len, &dst, &dst_len);
+	if (!res)
+		res = get_user_buf_u64(args.tag, args.tag_len, &tag, &tag_len);
+	if (res)
+		return res;
+
+	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	if (res)
+		return res;
+
+	switch (TEE_ALG_GET_CLASS(cs->algo)) {
+	case TEE_OPERATION_DIGEST:
+	case TEE_OPERATION_MAC:
+		res = syscall_hash_init(state, iv, iv_len);
+		if (res)
+			return res;
+		res = syscall_hash_final(state, src, src_len, dst,
+					 &usr_args->dst_len);
+		if (res || TEE_ALG_GET_CLASS(cs->algo) == TEE_OPERATION_MAC)
+			return res;
+		/* Ready for the next digest as after TEE_DigestDoFinal() */
+		return syscall_hash_init(state, NULL, 0);
+	case TEE_OPERATION_CIPHER:
+		res = syscall_cipher_init(state, iv, iv_len);
+		if (res)
+			return res;
+		return syscall_cipher_final(state, src, src_len, dst,
+					    &usr_args->dst_len);
+	case TEE_OPERATION_AE:
+		res = syscall_authenc_init(state, iv, iv_len, tag_len, aad_len,
+					   src_len);
+		if (res)
+			return res;
+		if (aad_len) {
+			res = syscall_authenc_update_aad(state, aad, aad_len);
+			if (res)
+				return res;
+		}
+		if (cs->mode == TEE_MODE_ENCRYPT)
+			return syscall_authenc_enc_final(state, src, src_len,
+							 dst,
+							 &usr_args->dst_len,
+							 tag,
+							 &usr_args->tag_len);
+		return syscall_authenc_dec_final(state, src, src_len, dst,
+						 &usr_args->dst_len, tag,
+						 tag_len);
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+TEE_Result syscall_cryp_update_vec(unsigned long state,
+				   struct utee_cryp_iov *usr_iov, size_t iov_cnt)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_mode_ctx *uctx = &to_user_ta_ctx(sess->ctx)->uctx;
+	uint32_t rflags = TEE_MEMORY_ACCESS_READ | TEE_MEMORY_ACCESS_ANY_OWNER;
+	uint32_t wflags = rflags | TEE_MEMORY_ACCESS_WRITE;
+	struct utee_cryp_iov *iov = NULL;
+	struct tee_cryp_state *cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t op_class = 0;
+	size_t src_len = 0;
+	size_t dst_len = 0;
+	void *src = NULL;
+	void *dst = NULL;
+	size_t n = 0;
+
+	if (iov_cnt > UTEE_CRYP_IOV_MAX)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!iov_cnt)
+		return TEE_SUCCESS;
+
+	res = BB_MEMDUP_USER(usr_iov, iov_cnt * sizeof(*iov), &iov);
+	if (res)
+		return res;
+
+	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	if (res)
+		return res;
+	if (cs->state != CRYP_STATE_INITIALIZED)
+		return TEE_ERROR_BAD_STATE;
+
+	op_class = TEE_ALG_GET_CLASS(cs->algo);
+	if (op_class != TEE_OPERATION_DIGEST && op_class != TEE_OPERATION_MAC &&
+	    op_class != TEE_OPERATION_CIPHER && op_class != TEE_OPERATION_AE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/*
+	 * Check all segments before processing any so that an invalid
+	 * segment leaves the operation unchanged.
+	 */
+	for (n = 0; n < iov_cnt; n++) {
+		res = get_user_buf_u64(iov[n].src, iov[n].src_len, &src,
+				       &src_len);
+		if (res)
+			return res;
+		src = memtag_strip_tag(src);
+		res = vm_check_access_rights(uctx, rflags, (uaddr_t)src,
+					     src_len);
+		if (res)
+			return res;
+
+		if (op_class == TEE_OPERATION_DIGEST ||
+		    op_class == TEE_OPERATION_MAC)
+			continue;
+
+		res = get_user_buf_u64(iov[n].dst, iov[n].dst_len, &dst,
+				       &dst_len);
+		if (res)
+			return res;
+		if (dst_len < src_len)
+			return TEE_ERROR_SHORT_BUFFER;
+		dst = memtag_strip_tag(dst);
+		res = vm_check_access_rights(uctx, wflags, (uaddr_t)dst,
+					     dst_len);
+		if (res)
+			return res;
+	}
+
+	for (n = 0; n < iov_cnt; n++) {
+		src = (void *)(vaddr_t)iov[n].src;
+		src_len = iov[n].src_len;
+		dst = (void *)(vaddr_t)iov[n].dst;
+
+		switch (op_class) {
+		case TEE_OPERATION_DIGEST:
+		case TEE_OPERATION_MAC:
+			res = syscall_hash_update(state, src, src_len);
+			break;
+		case TEE_OPERATION_CIPHER:
+			res = syscall_cipher_update(state, src, src_len, dst,
+						    &usr_iov[n].dst_len);
+			break;
+		default:
+			res = syscall_authenc_update_payload(state, src,
+							     src_len, dst,
+							     &usr_iov[n].dst_len);
+			break;
+		}
+		if (res)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
 static int pkcs1_get_salt_len(const TEE_Attribute *params, uint32_t num_params,
 			      size_t default_len)
 {
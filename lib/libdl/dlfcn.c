@@ -48,6 +48,15 @@ void *dlopen(const char *filename, int flags)
 		return NULL;
 
 	if (filename) {
+		/*
+		 * Other invocations may be using the TLS blocks which the
+		 * new module could need to grow.
+		 */
+		if (!__utee_tcb_can_grow()) {
+			EMSG("dlopen() from a parallel invocation");
+			goto err;
+		}
+
 		res = tee_uuid_from_str(&uuid, filename);
 		if (res)
 			goto err;
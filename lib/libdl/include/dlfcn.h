@@ -14,7 +14,13 @@
 #define RTLD_NODELETE	0x1000
 /* Other flags are not supported */
 
-/* Note: @flags must be (RTLD_NOW | RTLD_GLOBAL | RTLD_NODELETE) */
+/*
+ * Note: @flags must be (RTLD_NOW | RTLD_GLOBAL | RTLD_NODELETE)
+ *
+ * A TA with TA_FLAG_CONCURRENT set can't load libraries from invocations
+ * which may execute in parallel with others, that is, invocations of
+ * commands with only value parameters.
+ */
 void *dlopen(const char *filename, int flags);
 int dlclose(void *handle);
 void *dlsym(void *handle, const char *symbol);
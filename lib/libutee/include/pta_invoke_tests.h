@@ -93,6 +93,13 @@
  * [in]     value[1].b	unit size
  * [in]     memref[2]	In buffer
  * [in]     memref[3]	Out buffer
+ *
+ * If value[1] is passed as TEE_PARAM_TYPE_VALUE_INOUT the throughput of
+ * the TEE Core crypto implementation is returned. This doesn't involve
+ * libutee, a TA using the GP Internal Core API with the same parameters
+ * is needed to measure that:
+ * [out]    value[1].a	Elapsed time in milliseconds
+ * [out]    value[1].b	Throughput in KiB per second
  */
 #define PTA_INVOKE_TEST_CMD_AES_PERF		9
 
@@ -108,5 +115,61 @@
  */
 #define PTA_INVOKE_TESTS_CMD_DT_DRIVER_TESTS	11
 
+/*
+ * Pager page replacement benchmark, accesses a working set of paged pages
+ * repeatedly together with one page outside the working set each round
+ *
+ * [in]     value[0].a	Number of pages in the working set, max 128
+ * [in]     value[0].b	Number of rounds
+ * [out]    value[1].a	Number of page faults loading a page
+ * [out]    value[1].b	Number of faults on hidden pages
+ * [out]    value[2].a	Number of physical pages available to the pager
+ * [out]    value[2].b	Elapsed time in milliseconds
+ */
+#define PTA_INVOKE_TESTS_CMD_PAGER_PERF		12
+
+/*
+ * TA to TA latency benchmark, each round opens a session to a user TA,
+ * invokes a command once and closes the session. A TA which forwards the
+ * request to other TAs gives the latency of the chain.
+ *
+ * [in]     value[0].a	Command ID to invoke
+ * [in]     value[0].b	Number of rounds
+ * [in]     memref[1]	UUID of the TA, a TEE_UUID
+ * [in]     value[2].a	Buffer size, 0 for no parameters
+ * [in]     value[2].b	PTA_TA_CHAIN_PERF_MEMREF: a secure buffer of
+ *			value[2].a bytes is passed as memref[0] MEMREF_INOUT
+ *			to the command.
+ *			PTA_TA_CHAIN_PERF_PRIVATE: value[2].a is passed as
+ *			value[0].a VALUE_INPUT to the command, the TA is
+ *			expected to forward a page aligned buffer of that
+ *			size in its private memory to the next TA, which
+ *			is passed without a copy with CFG_TA_ZERO_COPY_PARAMS.
+ * [out]    value[2].a	Average close session latency in microseconds
+ * [out]    value[3].a	Average open session latency in microseconds
+ * [out]    value[3].b	Average invoke command latency in microseconds
+ */
+#define PTA_INVOKE_TESTS_CMD_TA_CHAIN_PERF	13
+
+#define PTA_TA_CHAIN_PERF_MEMREF		0
+#define PTA_TA_CHAIN_PERF_PRIVATE		1
+
+/*
+ * Tests the workqueue: queueing, coalescing of pending work, requeueing
+ * from the callback, delayed work and cancelling. Requires normal world
+ * to serve asynchronous notifications.
+ */
+#define PTA_INVOKE_TESTS_CMD_WORKQUEUE		14
+
+/*
+ * Tests the validation of scatter-gather memory references from normal
+ * world (CFG_CORE_SGMEM): segments joined on page boundaries are accepted
+ * and referenced, unaligned joins, a size mismatch and too many segments
+ * are rejected. The test registers shared memory over pages of the
+ * buffer.
+ * [in/out] memref[0]	Non-secure buffer covering at least 3 whole pages
+ */
+#define PTA_INVOKE_TESTS_CMD_SGMEM		15
+
 #endif /*__PTA_INVOKE_TESTS_H*/
 
@@ -22,6 +22,9 @@
  * [out]    value[1].b        R/W faults since last stats dump
  * [out]    value[2].a        Hidden faults since last stats dump
  * [out]    value[2].b        Zi pages released since last stats dump
+ * [out]    value[3].a        Optional, pages read ahead since last stats dump
+ * [out]    value[3].b        Optional, most pages read ahead by a single
+ *                            fault since last stats dump
  */
 #define STATS_CMD_PAGER_STATS		0
 
@@ -92,4 +95,150 @@ struct pta_stats_ta {
 #define STATS_DRIVER_TYPE_CLOCK		0
 #define STATS_DRIVER_TYPE_REGULATOR	1
 
+/*
+ * STATS_CMD_PHYS_MEM_STATS - Get fragmentation statistics on the secure
+ * physical memory allocator, complements the ALLOC_ID_TA_RAM entry of
+ * STATS_CMD_ALLOC_STATS
+ *
+ * [out]    memref[0]        struct pta_stats_phys_mem
+ *
+ * Returns TEE_ERROR_NOT_SUPPORTED unless the buddy allocator is enabled.
+ */
+#define STATS_CMD_PHYS_MEM_STATS	6
+
+#define STATS_PHYS_MEM_NB_ORDERS	32
+
+struct pta_stats_phys_mem {
+	uint32_t unit_size;	/* Size in bytes of an order 0 block */
+	uint32_t free_units;	/* Number of free order 0 blocks */
+	uint32_t num_orders;	/* Highest order with a free block + 1 */
+	uint32_t frag_index;	/* Free memory outside largest block, 1/1000 */
+	uint32_t nr_free[STATS_PHYS_MEM_NB_ORDERS]; /* Free blocks per order */
+};
+
+/*
+ * STATS_CMD_PGT_CACHE_STATS - Get statistics on the translation table cache
+ *
+ * [out]    value[0].a        Cache hits since last stats dump
+ * [out]    value[0].b        Cache misses since last stats dump
+ * [out]    value[1].a        Evictions since last stats dump
+ * [out]    value[1].b        Number of translation tables currently cached
+ * [out]    value[2].a        Total number of translation tables
+ */
+#define STATS_CMD_PGT_CACHE_STATS	7
+
+/*
+ * STATS_CMD_PAGER_POLICY_STATS - Get statistics on pager page replacement
+ *
+ * [out]    value[0].a        Replacement policy, STATS_PAGER_POLICY_*
+ * [out]    value[0].b        Pages evicted since last stats dump
+ * [out]    value[1].a        Pages hidden since last stats dump
+ * [out]    value[1].b        Hidden faults since last stats dump
+ *
+ * The counters are independent of those of STATS_CMD_PAGER_STATS, each
+ * command only resets its own. Returns TEE_ERROR_NOT_SUPPORTED unless the
+ * pager is enabled.
+ */
+#define STATS_CMD_PAGER_POLICY_STATS	8
+
+#define STATS_PAGER_POLICY_FIFO		0
+#define STATS_PAGER_POLICY_CLOCK	1
+
+/*
+ * STATS_CMD_PAGER_COMPR_STATS - Get statistics on the compressed R/W page
+ * store
+ *
+ * [out]    value[0].a        Number of pages in the store
+ * [out]    value[0].b        Number of bytes used by those pages
+ * [out]    value[1].a        Size in bytes of the memory backing the store
+ * [out]    value[1].b        Compression ratio in 1/100, pages in the store
+ *                            times the page size divided by bytes used
+ * [out]    value[2].a        Pages decompressed since last stats dump
+ * [out]    value[2].b        Time in microseconds spent decompressing since
+ *                            last stats dump
+ *
+ * The counters are shared with STATS_CMD_PAGER_STATS and reset by both
+ * commands. Returns TEE_ERROR_NOT_SUPPORTED unless the compressed store is
+ * enabled.
+ */
+#define STATS_CMD_PAGER_COMPR_STATS	9
+
+/*
+ * STATS_CMD_MUTEX_STATS - Get contention statistics of a core mutex
+ *
+ * [in]     value[0].a        ID of the mutex, STATS_MUTEX_ID_*
+ * [out]    value[1].a        Number of times the mutex was locked
+ * [out]    value[1].b        Number of lock attempts finding it held
+ * [out]    value[2].a        Number of contended locks acquired spinning
+ * [out]    value[2].b        Number of waits in normal world
+ *
+ * Counters are cumulative since boot.
+ */
+#define STATS_CMD_MUTEX_STATS		10
+
+#define STATS_MUTEX_ID_TA_MANAGER	0	/* tee_ta_mutex */
+#define STATS_MUTEX_ID_TA_SESSIONS	1	/* tee_ta_sess_mutex */
+
+/*
+ * STATS_CMD_TA_BUSY_STATS - Get wait queue statistics of loaded TAs which
+ * can't be entered concurrently, such as single-instance TAs
+ *
+ * [out]    memref[0]        Array of struct pta_stats_ta_busy
+ *
+ * Counters are cumulative since the TA instance was created.
+ */
+#define STATS_CMD_TA_BUSY_STATS		11
+
+struct pta_stats_ta_busy {
+	TEE_UUID uuid;
+	uint32_t queue_depth;		/* Threads currently waiting */
+	uint32_t max_queue_depth;	/* Most threads waiting at once */
+	uint32_t waits;			/* Number of times a thread waited */
+	uint32_t total_wait_ms;		/* Accumulated wait time */
+	uint32_t max_wait_ms;		/* Longest wait */
+};
+
+/*
+ * STATS_CMD_WORKQUEUE_STATS - Get statistics on deferred work executed in
+ * the asynchronous notification bottom half
+ *
+ * [out]    value[0].a        Number of works queued
+ * [out]    value[0].b        Number of works executed
+ * [out]    value[1].a        Number of bottom halves requested
+ * [out]    value[1].b        Number of bottom halves executing works
+ * [out]    value[2].a        Longest queue latency in microseconds
+ * [out]    value[2].b        Average queue latency in microseconds
+ * [out]    value[3].a        Number of currently pending works
+ * [out]    value[3].b        Number of pending works cancelled
+ *
+ * Counters are cumulative since boot. Returns TEE_ERROR_NOT_SUPPORTED
+ * unless CFG_CORE_WORKQUEUE=y.
+ */
+#define STATS_CMD_WORKQUEUE_STATS	12
+
+/*
+ * STATS_CMD_ITR_STATS - Get statistics on secure interrupts with a
+ * registered handler
+ *
+ * [out]    memref[0]        Array of struct pta_stats_itr
+ *
+ * Counters are cumulative since the first handler was registered for the
+ * interrupt. Handler durations are only measured if the core has a
+ * generic timer.
+ */
+#define STATS_CMD_ITR_STATS		13
+
+#define STATS_ITR_CHIP_NAME_SIZE	16
+/* Bucket n counts handler durations below 2^n us, the last one the rest */
+#define STATS_ITR_NB_LAT_BUCKETS	8
+
+struct pta_stats_itr {
+	char chip_name[STATS_ITR_CHIP_NAME_SIZE]; /* Truncated, zero ended */
+	uint32_t itr_num;
+	uint32_t count;			/* Number of times delivered */
+	uint32_t unhandled;		/* Times no handler handled it */
+	uint32_t max_us;		/* Longest time in handlers */
+	uint32_t lat_hist[STATS_ITR_NB_LAT_BUCKETS];
+};
+
 #endif /*__PTA_STATS_H*/
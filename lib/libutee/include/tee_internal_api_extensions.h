@@ -78,4 +78,105 @@ TEE_Result tee_invoke_supp_plugin(const TEE_UUID *uuid, uint32_t cmd,
 				  uint32_t sub_cmd, void *buf, size_t len,
 				  size_t *outlen);
 
+/*
+ * One-shot cryptographic operations
+ *
+ * Each function initializes the operation and processes all the data
+ * with a single system call, where the multi-stage API needs one system
+ * call per stage. The operation must have a key set, except for digests,
+ * and must not be in the middle of a multi-stage operation. The same
+ * operation, and thus the same crypto context in TEE Core, can be used
+ * for any number of one-shot operations. Errors are handled as by the
+ * corresponding multi-stage functions, for instance TEE_AEEncryptFinal().
+ *
+ * TEE_DigestOneShot()	   Digest of @chunk, same as TEE_DigestDoFinal()
+ *			   on a freshly reset operation
+ * TEE_MACComputeOneShot() TEE_MACInit() and TEE_MACComputeFinal()
+ * TEE_CipherOneShot()	   TEE_CipherInit() and TEE_CipherDoFinal()
+ * TEE_AEEncryptOneShot()  TEE_AEInit() with the tag length *@tagLen in
+ *			   bytes, TEE_AEUpdateAAD() and TEE_AEEncryptFinal()
+ * TEE_AEDecryptOneShot()  TEE_AEInit() with the tag length @tagLen in
+ *			   bytes, TEE_AEUpdateAAD() and TEE_AEDecryptFinal()
+ */
+TEE_Result TEE_DigestOneShot(TEE_OperationHandle operation, const void *chunk,
+			     size_t chunkLen, void *hash, size_t *hashLen);
+TEE_Result TEE_MACComputeOneShot(TEE_OperationHandle operation,
+				 const void *IV, size_t IVLen,
+				 const void *message, size_t messageLen,
+				 void *mac, size_t *macLen);
+TEE_Result TEE_CipherOneShot(TEE_OperationHandle operation, const void *IV,
+			     size_t IVLen, const void *srcData, size_t srcLen,
+			     void *destData, size_t *destLen);
+TEE_Result TEE_AEEncryptOneShot(TEE_OperationHandle operation,
+				const void *nonce, size_t nonceLen,
+				const void *AADdata, size_t AADdataLen,
+				const void *srcData, size_t srcLen,
+				void *destData, size_t *destLen,
+				void *tag, size_t *tagLen);
+TEE_Result TEE_AEDecryptOneShot(TEE_OperationHandle operation,
+				const void *nonce, size_t nonceLen,
+				const void *AADdata, size_t AADdataLen,
+				const void *srcData, size_t srcLen,
+				void *destData, size_t *destLen,
+				const void *tag, size_t tagLen);
+
+/*
+ * struct tee_cryp_iov - data segment of a vectored update
+ * @src:	input data
+ * @src_len:	length of @src
+ * @dst:	output data, unused for digest and MAC operations
+ * @dst_len:	[in] size of @dst, [out] length of the output data
+ */
+struct tee_cryp_iov {
+	const void *src;
+	size_t src_len;
+	void *dst;
+	size_t dst_len;
+};
+
+/*
+ * Vectored updates feed all segments of @iov in order to an operation, as
+ * the same number of calls to TEE_DigestUpdate(), TEE_MACUpdate(),
+ * TEE_CipherUpdate() or TEE_AEUpdate() would, but with one system call
+ * for up to 64 segments (UTEE_CRYP_IOV_MAX). If partial blocks would have
+ * to be buffered in the TA between segments, the segments are processed
+ * one at a time.
+ *
+ * TEE_CipherUpdateVec() and TEE_AEUpdateVec() check all destination
+ * buffers before any data is processed. If any is too small, nothing is
+ * processed, the required size is stored in @dst_len of each short
+ * segment and TEE_ERROR_SHORT_BUFFER is returned.
+ */
+void TEE_DigestUpdateVec(TEE_OperationHandle operation,
+			 const struct tee_cryp_iov *iov, size_t iov_cnt);
+void TEE_MACUpdateVec(TEE_OperationHandle operation,
+		      const struct tee_cryp_iov *iov, size_t iov_cnt);
+TEE_Result TEE_CipherUpdateVec(TEE_OperationHandle operation,
+			       struct tee_cryp_iov *iov, size_t iov_cnt);
+TEE_Result TEE_AEUpdateVec(TEE_OperationHandle operation,
+			   struct tee_cryp_iov *iov, size_t iov_cnt);
+
+/*
+ * Spinlocks for TAs with TA_FLAG_CONCURRENT set, which may be executing
+ * several invocations in parallel. Initialize with TEE_SPINLOCK_UNLOCK.
+ * A thread holding a spinlock may be preempted by the TEE, so keep the
+ * critical sections short.
+ */
+#define TEE_SPINLOCK_UNLOCK	0
+#define TEE_SPINLOCK_LOCK	1
+
+/*
+ * tee_spin_trylock() - Try to take a spinlock
+ * @lock:	Spinlock
+ *
+ * Returns true if the lock was taken, false if it's held already.
+ */
+bool tee_spin_trylock(unsigned int *lock);
+
+/* tee_spin_lock() - Take a spinlock, spins until it's available */
+void tee_spin_lock(unsigned int *lock);
+
+/* tee_spin_unlock() - Release a spinlock taken by the caller */
+void tee_spin_unlock(unsigned int *lock);
+
 #endif
@@ -106,6 +106,9 @@ void __utee_call_elf_init_fn(void);
 void __utee_call_elf_fini_fn(void);
 
 void __utee_tcb_init(void);
+bool __utee_tcb_can_grow(void);
+void *__utee_tcb_enter(bool parallel);
+void __utee_tcb_exit(void *tcb, bool parallel);
 
 /*
  * Information about the ELF objects loaded by the application
@@ -79,6 +79,9 @@ TEE_Result _utee_wait(unsigned long timeout);
 /* cat has type enum _utee_time_category */
 TEE_Result _utee_get_time(unsigned long cat, TEE_Time *time);
 
+/* Returns the address of the struct utee_time_page mapped into the TA */
+TEE_Result _utee_get_time_page(uint64_t *va);
+
 TEE_Result _utee_set_ta_time(const TEE_Time *time);
 
 TEE_Result _utee_cryp_state_alloc(unsigned long algo, unsigned long op_mode,
@@ -149,6 +152,20 @@ TEE_Result _utee_authenc_dec_final(unsigned long state, const void *src_data,
 				   uint64_t *dest_len, const void *tag,
 				   size_t tag_len);
 
+/*
+ * Initializes the operation and processes all data in one go, see struct
+ * utee_cryp_oneshot for the arguments
+ */
+TEE_Result _utee_cryp_oneshot(unsigned long state,
+			      struct utee_cryp_oneshot *args);
+
+/*
+ * Updates a digest, MAC, cipher or AE payload operation with each segment
+ * in turn, at most UTEE_CRYP_IOV_MAX segments
+ */
+TEE_Result _utee_cryp_update_vec(unsigned long state,
+				 struct utee_cryp_iov *iov, size_t iov_cnt);
+
 TEE_Result _utee_asymm_operate(unsigned long state,
 			       const struct utee_attribute *params,
 			       unsigned long num_params, const void *src_data,
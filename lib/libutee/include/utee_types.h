@@ -67,4 +67,81 @@ struct utee_object_info {
 	uint32_t handle_flags;
 };
 
+/*
+ * struct utee_cryp_oneshot - arguments of _utee_cryp_oneshot()
+ * @iv:		IV or nonce, unused for digests
+ * @iv_len:	length of @iv
+ * @aad:	additional authenticated data, AE only
+ * @aad_len:	length of @aad
+ * @src:	input data
+ * @src_len:	length of @src
+ * @dst:	output data, the digest or MAC for digest and MAC operations
+ * @dst_len:	[in] size of @dst, [out] length of the output data
+ * @tag:	tag, AE only
+ * @tag_len:	[in] size of the tag, [out] length of the encryption tag
+ */
+struct utee_cryp_oneshot {
+	uint64_t iv;
+	uint64_t iv_len;
+	uint64_t aad;
+	uint64_t aad_len;
+	uint64_t src;
+	uint64_t src_len;
+	uint64_t dst;
+	uint64_t dst_len;
+	uint64_t tag;
+	uint64_t tag_len;
+};
+
+/* Maximum number of segments passed to _utee_cryp_update_vec() */
+#define UTEE_CRYP_IOV_MAX	64
+
+/*
+ * struct utee_cryp_iov - segment of _utee_cryp_update_vec()
+ * @src:	input data
+ * @src_len:	length of @src
+ * @dst:	output data, unused for digest and MAC operations
+ * @dst_len:	[in] size of @dst, [out] length of the output data
+ */
+struct utee_cryp_iov {
+	uint64_t src;
+	uint64_t src_len;
+	uint64_t dst;
+	uint64_t dst_len;
+};
+
+/*
+ * A memref into TA private memory passed to another TA with start and size
+ * aligned to this is mapped directly into the called TA, see
+ * CFG_TA_ZERO_COPY_PARAMS
+ */
+#define UTEE_ZERO_COPY_ALIGN		4096
+
+/* System time is counter / @cnt_freq */
+#define UTEE_TIME_PAGE_SYS_VALID	0x1
+/* @ree_seconds and @ree_millis hold a sample of the REE time */
+#define UTEE_TIME_PAGE_REE_VALID	0x2
+
+/*
+ * struct utee_time_page - read-only time data mapped into each TA
+ * @seq:	Sequence count, odd while the core updates the page. A
+ *		reader retries if it's odd or changed while reading.
+ * @flags:	UTEE_TIME_PAGE_* flags
+ * @cnt_freq:	Frequency of the counter in Hz
+ * @ree_cnt:	Counter value when the REE time was sampled
+ * @ree_max_age: Counter ticks after @ree_cnt the REE time sample can be
+ *		used before it has to be fetched again
+ * @ree_seconds: Seconds part of the REE time sample
+ * @ree_millis:	Milliseconds part of the REE time sample
+ */
+struct utee_time_page {
+	uint32_t seq;
+	uint32_t flags;
+	uint64_t cnt_freq;
+	uint64_t ree_cnt;
+	uint64_t ree_max_age;
+	uint32_t ree_seconds;
+	uint32_t ree_millis;
+};
+
 #endif /* UTEE_TYPES_H */
@@ -14,6 +14,7 @@ srcs-y += tee_api_operations.c
 srcs-y += tee_api_panic.c
 srcs-y += tee_api_property.c
 srcs-y += tee_socket_pta.c
+srcs-y += tee_spinlock.c
 srcs-y += tee_system_pta.c
 srcs-y += tee_tcpudp_socket.c
 srcs-y += tcb.c
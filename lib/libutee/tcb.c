@@ -5,13 +5,21 @@
 /*
  * Support for Thread-Local Storage (TLS) ABIs for ARMv7/Aarch32 and Aarch64.
  *
- * TAs are currently single-threaded, so the only benefit of implementing these
+ * TAs are mostly single-threaded, so the main benefit of implementing these
  * ABIs is to support toolchains that need them even when the target program is
  * single-threaded. Such as, the g++ compiler from the GCC toolchain targeting a
  * "Posix thread" Linux runtime, which OP-TEE has been using for quite some time
  * (arm-linux-gnueabihf-* and aarch64-linux-gnu-*). This allows building C++ TAs
  * without having to build a specific toolchain with --disable-threads.
  *
+ * A TA with TA_FLAG_CONCURRENT set may execute several invocations in
+ * parallel when CFG_TA_CONCURRENT=y. On Aarch64 an invocation entering
+ * while the TCB of the instance is used by another one gets a private copy
+ * of the TLS blocks. ARMv7/Aarch32 TAs have no thread pointer preserved by
+ * the TEE so all invocations share the TCB. The TLS blocks can't grow
+ * while other invocations may be using them, so dlopen() is refused from
+ * invocations which may execute in parallel.
+ *
  * This implementation is based on [1].
  *
  *  - "TLS data structures variant 1" (section 3): the AArch64 compiler uses the
@@ -38,6 +46,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/queue.h>
+#include <tee_internal_api_extensions.h>
 #include "user_ta_header.h"
 
 /* DTV - Dynamic Thread Vector
@@ -70,14 +79,59 @@ struct tcb_head {
 };
 
 /*
- * Since TAs are single threaded, only one TCB is needed. This would need to
- * change if multi-threading is introduced.
+ * The TCB of the TA instance, invocations executing in parallel use
+ * private copies.
  */
 static struct tcb_head *_tcb;
 static size_t _tls_size;
 
+/*
+ * Entries which may execute in parallel with other entries are counted
+ * in tcb_parallel_count. tcb_shared_busy tells if one of them uses _tcb.
+ * Both are protected by tcb_lock. Other entries execute alone.
+ */
+static unsigned int tcb_lock = TEE_SPINLOCK_UNLOCK;
+static unsigned int tcb_parallel_count;
+static bool tcb_shared_busy;
+
 #define TCB_SIZE(tls_size) (sizeof(*_tcb) + (tls_size))
 
+/*
+ * Copy the initial TLS data of each module to the TCB, skipping the
+ * modules within the first @copied bytes of TLS blocks
+ */
+static void init_tls(struct tcb_head *tcb, size_t copied)
+{
+	struct dl_phdr_info *dlpi = NULL;
+	const Elf_Phdr *phdr = NULL;
+	size_t size = 0;
+	size_t i = 0;
+	size_t j = 0;
+
+	for (i = 0; i < __elf_phdr_info.count; i++) {
+		dlpi = __elf_phdr_info.dlpi + i;
+		for (j = 0; j < dlpi->dlpi_phnum; j++) {
+			phdr = dlpi->dlpi_phdr + j;
+			if (phdr->p_type != PT_TLS)
+				continue;
+			if (size + phdr->p_memsz <= copied) {
+				/* Already copied */
+				break;
+			}
+			tcb->dtv[i + 1].tls = tcb->tls + size;
+			/* Copy .tdata */
+			memcpy(tcb->tls + size,
+			       (void *)(dlpi->dlpi_addr + phdr->p_vaddr),
+			       phdr->p_filesz);
+			/* Initialize .tbss */
+			memset(tcb->tls + size + phdr->p_filesz, 0,
+			       phdr->p_memsz - phdr->p_filesz);
+			size += phdr->p_memsz;
+		}
+	}
+	tcb->dtv[0].size = i;
+}
+
 /*
  * Initialize or update the TCB.
  * Called on application initialization and when additional shared objects are
@@ -110,6 +164,9 @@ void __utee_tcb_init(void)
 	if (total_size == _tls_size)
 		return;
 
+	/* Other entries may be using _tcb, see __utee_tcb_can_grow() */
+	assert(!tcb_parallel_count);
+
 	/* (Re-)allocate the TCB */
 	_tcb = malloc_flags(MAF_ZERO_INIT, _tcb, 1, TCB_SIZE(total_size));
 	if (!_tcb) {
@@ -126,29 +183,7 @@ void __utee_tcb_init(void)
 	}
 
 	/* Copy TLS data to the TCB */
-	size = 0;
-	for (i = 0; i < __elf_phdr_info.count; i++) {
-		dlpi = __elf_phdr_info.dlpi + i;
-		for (j = 0; j < dlpi->dlpi_phnum; j++) {
-			phdr = dlpi->dlpi_phdr + j;
-			if (phdr->p_type != PT_TLS)
-				continue;
-			if (size + phdr->p_memsz <= _tls_size) {
-				/* Already copied */
-				break;
-			}
-			_tcb->dtv[i + 1].tls = _tcb->tls + size;
-			/* Copy .tdata */
-			memcpy(_tcb->tls + size,
-			       (void *)(dlpi->dlpi_addr + phdr->p_vaddr),
-			       phdr->p_filesz);
-			/* Initialize .tbss */
-			memset(_tcb->tls + size + phdr->p_filesz, 0,
-			       phdr->p_memsz - phdr->p_filesz);
-			size += phdr->p_memsz;
-		}
-	}
-	_tcb->dtv[0].size = i;
+	init_tls(_tcb, _tls_size);
 
 	_tls_size = total_size;
 #ifdef ARM64
@@ -160,6 +195,104 @@ void __utee_tcb_init(void)
 #endif
 }
 
+/*
+ * Returns true if the TLS blocks may be reallocated, that is, if no entry
+ * which may execute in parallel with others is executing. The caller is
+ * then executing alone and no other entry can start before it returns.
+ */
+bool __utee_tcb_can_grow(void)
+{
+	bool ret = false;
+
+	tee_spin_lock(&tcb_lock);
+	ret = !tcb_parallel_count;
+	tee_spin_unlock(&tcb_lock);
+
+	return ret;
+}
+
+static struct tcb_head *alloc_private_tcb(void)
+{
+	struct tcb_head *tcb = NULL;
+	size_t size = 0;
+
+	tcb = calloc(1, TCB_SIZE(_tls_size));
+	if (!tcb) {
+		EMSG("TCB allocation failed (%zu bytes)", TCB_SIZE(_tls_size));
+		abort();
+	}
+	size = DTV_SIZE((__elf_phdr_info.count + 1) * sizeof(union dtv));
+	tcb->dtv = calloc(1, size);
+	if (!tcb->dtv) {
+		EMSG("DTV allocation failed (%zu bytes)", size);
+		abort();
+	}
+	init_tls(tcb, 0);
+
+	return tcb;
+}
+
+/*
+ * Called on each entry to the TA. The thread pointer isn't preserved
+ * between entries so it's set again here. @parallel tells if the entry
+ * may execute in parallel with other entries. Returns the TCB to pass to
+ * __utee_tcb_exit().
+ */
+void *__utee_tcb_enter(bool parallel)
+{
+	struct tcb_head *tcb = _tcb;
+	bool private_tcb = false;
+
+	if (parallel) {
+		tee_spin_lock(&tcb_lock);
+		tcb_parallel_count++;
+#ifdef ARM64
+		if (_tls_size) {
+			if (tcb_shared_busy)
+				private_tcb = true;
+			else
+				tcb_shared_busy = true;
+		}
+#endif
+		tee_spin_unlock(&tcb_lock);
+	}
+
+	if (private_tcb)
+		tcb = alloc_private_tcb();
+#ifdef ARM64
+	write_tpidr_el0((vaddr_t)tcb);
+#endif
+	return tcb;
+}
+
+void __utee_tcb_exit(void *tcb, bool parallel)
+{
+	struct tcb_head *t = tcb;
+
+	if (!parallel)
+		return;
+
+	tee_spin_lock(&tcb_lock);
+	tcb_parallel_count--;
+	if (t == _tcb)
+		tcb_shared_busy = false;
+	tee_spin_unlock(&tcb_lock);
+
+	if (t != _tcb) {
+		free(t->dtv);
+		free(t);
+	}
+}
+
+static struct tcb_head *get_tcb(void)
+{
+#ifdef ARM64
+	return (struct tcb_head *)read_tpidr_el0();
+#else
+	return _tcb;
+#endif
+}
+
 struct tls_index {
 	unsigned long module;
 	unsigned long offset;
@@ -198,7 +331,7 @@ int dl_iterate_phdr(int (*callback)(struct dl_phdr_info *, size_t, void *),
 		dlpi->dlpi_tls_data = NULL;
 		id = dlpi->dlpi_tls_modid;
 		if (id)
-			dlpi->dlpi_tls_data = _tcb->dtv[id].tls;
+			dlpi->dlpi_tls_data = get_tcb()->dtv[id].tls;
 		st = callback(dlpi, sizeof(*dlpi), data);
 	}
 
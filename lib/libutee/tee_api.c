@@ -2,6 +2,11 @@
 /*
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
+#if defined(ARM32) || defined(ARM64)
+#include <arm_user_sysreg.h>
+#endif
+#include <config.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string_ext.h>
@@ -9,7 +14,9 @@
 #include <tee_internal_api_extensions.h>
 #include <types_ext.h>
 #include <user_ta_header.h>
+#include <utee_defines.h>
 #include <utee_syscalls.h>
+#include <utee_types.h>
 #include "tee_api_private.h"
 
 /*
@@ -93,14 +100,32 @@ static void copy_gp11_param(struct utee_params *up, uint32_t param_types,
 	}
 }
 
+/*
+ * Whole pages of TA private memory are mapped directly into the called TA
+ * by the core, see CFG_TA_ZERO_COPY_PARAMS
+ */
+static bool is_zero_copy_buf(void *buf, size_t size)
+{
+	return IS_ENABLED(CFG_TA_ZERO_COPY_PARAMS) &&
+	       IS_ALIGNED((vaddr_t)buf, UTEE_ZERO_COPY_ALIGN) &&
+	       IS_ALIGNED(size, UTEE_ZERO_COPY_ALIGN);
+}
+
+/*
+ * If *@zero_copy is true on entry, buffers made of whole pages are passed
+ * as is instead of being copied. On return *@zero_copy tells if any
+ * buffer of TA private memory was passed that way.
+ */
 static TEE_Result map_tmp_param(struct utee_params *up, void **tmp_buf,
-				size_t *tmp_len, void *tmp_va[TEE_NUM_PARAMS])
+				size_t *tmp_len, void *tmp_va[TEE_NUM_PARAMS],
+				bool *zero_copy)
 {
 	size_t n = 0;
 	uint8_t *tb = NULL;
 	size_t tbl = 0;
 	size_t tmp_align = sizeof(vaddr_t) * 2;
 	bool is_tmp_mem[TEE_NUM_PARAMS] = { false };
+	bool zero_copied = false;
 	void *b = NULL;
 	size_t s = 0;
 	const uint32_t flags = TEE_MEMORY_ACCESS_READ;
@@ -123,15 +148,20 @@ static TEE_Result map_tmp_param(struct utee_params *up, void **tmp_buf,
 			s = up->vals[n * 2 + 1];
 			/*
 			 * We're only allocating temporary memory if the
-			 * buffer is completely within TA memory. If it's
-			 * NULL, empty, partially outside or completely
-			 * outside TA memory there's nothing more we need
-			 * to do here. If there's security/permissions
-			 * problem we'll get an error in the
-			 * invoke_command/open_session below.
+			 * buffer is completely within TA memory and not
+			 * made of whole pages. If it's NULL, empty,
+			 * partially outside or completely outside TA
+			 * memory there's nothing more we need to do here.
+			 * If there's security/permissions problem we'll
+			 * get an error in the invoke_command/open_session
+			 * below.
 			 */
-			if (b && s &&
-			    !TEE_CheckMemoryAccessRights(flags, b, s)) {
+			if (!b || !s ||
+			    TEE_CheckMemoryAccessRights(flags, b, s))
+				break;
+			if (*zero_copy && is_zero_copy_buf(b, s)) {
+				zero_copied = true;
+			} else {
 				is_tmp_mem[n] = true;
 				tbl += ROUNDUP2(s, tmp_align);
 			}
@@ -141,6 +171,8 @@ static TEE_Result map_tmp_param(struct utee_params *up, void **tmp_buf,
 		}
 	}
 
+	*zero_copy = zero_copied;
+
 	if (tbl) {
 		tb = tee_map_zi(tbl, TEE_MEMORY_ACCESS_ANY_OWNER);
 		if (!tb)
@@ -174,6 +206,31 @@ static TEE_Result map_tmp_param(struct utee_params *up, void **tmp_buf,
 
 }
 
+static void unmap_tmp_param(void *tmp_buf, size_t tmp_len)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!tmp_buf)
+		return;
+
+	res = tee_unmap(tmp_buf, tmp_len);
+	if (res)
+		TEE_Panic(res);
+}
+
+/*
+ * The TEE Core only accepts private memory passed without a copy if the
+ * buffer is inside a single memory region of the TA, else it fails with
+ * TEE_ERROR_BAD_PARAMETERS before the called TA is reached. The call is
+ * then retried with temporary copies of the buffers.
+ */
+static bool retry_with_copies(TEE_Result res, uint32_t origin,
+			      bool zero_copied)
+{
+	return zero_copied && res == TEE_ERROR_BAD_PARAMETERS &&
+	       origin == TEE_ORIGIN_TEE;
+}
+
 static void update_out_param(TEE_Param params[TEE_NUM_PARAMS],
 			     void *tmp_va[TEE_NUM_PARAMS],
 			     const struct utee_params *up)
@@ -322,7 +379,9 @@ TEE_Result TEE_OpenTASession(const TEE_UUID *destination,
 				uint32_t *returnOrigin)
 {
 	TEE_Result res = TEE_SUCCESS;
+	uint32_t ret_origin = TEE_ORIGIN_TEE;
 	struct utee_params up = { };
+	bool zero_copy = true;
 	uint32_t s = 0;
 	void *tmp_buf = NULL;
 	size_t tmp_len = 0;
@@ -336,19 +395,23 @@ TEE_Result TEE_OpenTASession(const TEE_UUID *destination,
 	}
 	__utee_check_out_annotation(session, sizeof(*session));
 
-	copy_param(&up, paramTypes, params);
-	res = map_tmp_param(&up, &tmp_buf, &tmp_len, tmp_va);
-	if (res)
-		goto out;
-	res = _utee_open_ta_session(destination, cancellationRequestTimeout,
-				    &up, &s, returnOrigin);
-	update_out_param(params, tmp_va, &up);
-	if (tmp_buf) {
-		TEE_Result res2 = tee_unmap(tmp_buf, tmp_len);
-
-		if (res2)
-			TEE_Panic(res2);
+	while (true) {
+		copy_param(&up, paramTypes, params);
+		res = map_tmp_param(&up, &tmp_buf, &tmp_len, tmp_va,
+				    &zero_copy);
+		if (res)
+			goto out;
+		res = _utee_open_ta_session(destination,
+					    cancellationRequestTimeout,
+					    &up, &s, &ret_origin);
+		if (!retry_with_copies(res, ret_origin, zero_copy))
+			break;
+		/* Retry once, with all private buffers copied */
+		zero_copy = false;
+		unmap_tmp_param(tmp_buf, tmp_len);
 	}
+	update_out_param(params, tmp_va, &up);
+	unmap_tmp_param(tmp_buf, tmp_len);
 
 out:
 	/*
@@ -360,6 +423,8 @@ out:
 		s = TEE_HANDLE_NULL;
 
 	*session = (TEE_TASessionHandle)(uintptr_t)s;
+	if (returnOrigin)
+		*returnOrigin = ret_origin;
 	return res;
 }
 
@@ -371,7 +436,9 @@ TEE_Result __GP11_TEE_OpenTASession(const TEE_UUID *destination,
 				    uint32_t *returnOrigin)
 {
 	TEE_Result res = TEE_SUCCESS;
+	uint32_t ret_origin = TEE_ORIGIN_TEE;
 	struct utee_params up = { };
+	bool zero_copy = true;
 	uint32_t s = 0;
 	void *tmp_buf = NULL;
 	size_t tmp_len = 0;
@@ -383,19 +450,23 @@ TEE_Result __GP11_TEE_OpenTASession(const TEE_UUID *destination,
 					      TEE_NUM_PARAMS);
 	__utee_check_out_annotation(session, sizeof(*session));
 
-	copy_gp11_param(&up, paramTypes, params);
-	res = map_tmp_param(&up, &tmp_buf, &tmp_len, tmp_va);
-	if (res)
-		goto out;
-	res = _utee_open_ta_session(destination, cancellationRequestTimeout,
-				    &up, &s, returnOrigin);
-	update_out_gp11_param(params, tmp_va, &up);
-	if (tmp_buf) {
-		TEE_Result res2 = tee_unmap(tmp_buf, tmp_len);
-
-		if (res2)
-			TEE_Panic(res2);
+	while (true) {
+		copy_gp11_param(&up, paramTypes, params);
+		res = map_tmp_param(&up, &tmp_buf, &tmp_len, tmp_va,
+				    &zero_copy);
+		if (res)
+			goto out;
+		res = _utee_open_ta_session(destination,
+					    cancellationRequestTimeout,
+					    &up, &s, &ret_origin);
+		if (!retry_with_copies(res, ret_origin, zero_copy))
+			break;
+		/* Retry once, with all private buffers copied */
+		zero_copy = false;
+		unmap_tmp_param(tmp_buf, tmp_len);
 	}
+	update_out_gp11_param(params, tmp_va, &up);
+	unmap_tmp_param(tmp_buf, tmp_len);
 
 out:
 	/*
@@ -407,6 +478,8 @@ out:
 		s = TEE_HANDLE_NULL;
 
 	*session = (TEE_TASessionHandle)(uintptr_t)s;
+	if (returnOrigin)
+		*returnOrigin = ret_origin;
 	return res;
 }
 
@@ -429,6 +502,7 @@ TEE_Result TEE_InvokeTACommand(TEE_TASessionHandle session,
 	TEE_Result res = TEE_SUCCESS;
 	uint32_t ret_origin = TEE_ORIGIN_TEE;
 	struct utee_params up = { };
+	bool zero_copy = true;
 	void *tmp_buf = NULL;
 	size_t tmp_len = 0;
 	void *tmp_va[TEE_NUM_PARAMS] = { NULL };
@@ -443,20 +517,23 @@ TEE_Result TEE_InvokeTACommand(TEE_TASessionHandle session,
 		__utee_check_out_annotation(returnOrigin,
 					    sizeof(*returnOrigin));
 
-	copy_param(&up, paramTypes, params);
-	res = map_tmp_param(&up, &tmp_buf, &tmp_len, tmp_va);
-	if (res)
-		goto out;
-	res = _utee_invoke_ta_command((uintptr_t)session,
-				      cancellationRequestTimeout,
-				      commandID, &up, &ret_origin);
-	update_out_param(params, tmp_va, &up);
-	if (tmp_buf) {
-		TEE_Result res2 = tee_unmap(tmp_buf, tmp_len);
-
-		if (res2)
-			TEE_Panic(res2);
+	while (true) {
+		copy_param(&up, paramTypes, params);
+		res = map_tmp_param(&up, &tmp_buf, &tmp_len, tmp_va,
+				    &zero_copy);
+		if (res)
+			goto out;
+		res = _utee_invoke_ta_command((uintptr_t)session,
+					      cancellationRequestTimeout,
+					      commandID, &up, &ret_origin);
+		if (!retry_with_copies(res, ret_origin, zero_copy))
+			break;
+		/* Retry once, with all private buffers copied */
+		zero_copy = false;
+		unmap_tmp_param(tmp_buf, tmp_len);
 	}
+	update_out_param(params, tmp_va, &up);
+	unmap_tmp_param(tmp_buf, tmp_len);
 
 out:
 	if (returnOrigin != NULL)
@@ -482,6 +559,7 @@ TEE_Result __GP11_TEE_InvokeTACommand(TEE_TASessionHandle session,
 	TEE_Result res = TEE_SUCCESS;
 	uint32_t ret_origin = TEE_ORIGIN_TEE;
 	struct utee_params up = { };
+	bool zero_copy = true;
 	void *tmp_buf = NULL;
 	size_t tmp_len = 0;
 	void *tmp_va[TEE_NUM_PARAMS] = { NULL };
@@ -494,20 +572,23 @@ TEE_Result __GP11_TEE_InvokeTACommand(TEE_TASessionHandle session,
 		__utee_check_out_annotation(returnOrigin,
 					    sizeof(*returnOrigin));
 
-	copy_gp11_param(&up, paramTypes, params);
-	res = map_tmp_param(&up, &tmp_buf, &tmp_len, tmp_va);
-	if (res)
-		goto out;
-	res = _utee_invoke_ta_command((uintptr_t)session,
-				      cancellationRequestTimeout,
-				      commandID, &up, &ret_origin);
-	update_out_gp11_param(params, tmp_va, &up);
-	if (tmp_buf) {
-		TEE_Result res2 = tee_unmap(tmp_buf, tmp_len);
-
-		if (res2)
-			TEE_Panic(res2);
+	while (true) {
+		copy_gp11_param(&up, paramTypes, params);
+		res = map_tmp_param(&up, &tmp_buf, &tmp_len, tmp_va,
+				    &zero_copy);
+		if (res)
+			goto out;
+		res = _utee_invoke_ta_command((uintptr_t)session,
+					      cancellationRequestTimeout,
+					      commandID, &up, &ret_origin);
+		if (!retry_with_copies(res, ret_origin, zero_copy))
+			break;
+		/* Retry once, with all private buffers copied */
+		zero_copy = false;
+		unmap_tmp_param(tmp_buf, tmp_len);
 	}
+	update_out_gp11_param(params, tmp_va, &up);
+	unmap_tmp_param(tmp_buf, tmp_len);
 
 out:
 	if (returnOrigin)
@@ -640,9 +721,101 @@ void __GP11_TEE_MemFill(void *buff, uint32_t x, uint32_t size)
 
 /* Date & Time API */
 
+#if defined(ARM32) || defined(ARM64)
+/*
+ * User address of the struct utee_time_page mapped by the core, 0 until
+ * it has been looked up and 1 if there's no such page.
+ */
+static uintptr_t time_page_va;
+
+static const struct utee_time_page *get_time_page(void)
+{
+	uintptr_t va = __atomic_load_n(&time_page_va, __ATOMIC_RELAXED);
+	uint64_t v = 0;
+
+	if (!va) {
+		if (_utee_get_time_page(&v) || !v)
+			va = 1;
+		else
+			va = v;
+		__atomic_store_n(&time_page_va, va, __ATOMIC_RELAXED);
+	}
+
+	if (va == 1)
+		return NULL;
+	return (const void *)va;
+}
+
+/*
+ * Reads the system time (@flag is UTEE_TIME_PAGE_SYS_VALID) or the REE
+ * time (@flag is UTEE_TIME_PAGE_REE_VALID) from the counter and the time
+ * page. Returns false if the time has to be fetched from the core instead.
+ */
+static bool time_page_read(uint32_t flag, TEE_Time *time)
+{
+	const struct utee_time_page *tp = get_time_page();
+	uint64_t ree_cnt = 0;
+	uint64_t max_age = 0;
+	uint64_t freq = 0;
+	uint64_t cnt = 0;
+	uint64_t ms = 0;
+	uint32_t millis = 0;
+	uint32_t flags = 0;
+	uint32_t secs = 0;
+	uint32_t seq = 0;
+
+	if (!tp)
+		return false;
+
+	while (true) {
+		seq = __atomic_load_n(&tp->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1)
+			continue;
+		flags = tp->flags;
+		freq = tp->cnt_freq;
+		ree_cnt = tp->ree_cnt;
+		max_age = tp->ree_max_age;
+		secs = tp->ree_seconds;
+		millis = tp->ree_millis;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&tp->seq, __ATOMIC_RELAXED) == seq)
+			break;
+	}
+
+	if (!(flags & flag))
+		return false;
+
+	cnt = barrier_read_counter_timer();
+	if (flag == UTEE_TIME_PAGE_SYS_VALID) {
+		time->seconds = cnt / freq;
+		time->millis = (cnt % freq) / (freq / TEE_TIME_MILLIS_BASE);
+		return true;
+	}
+
+	/* A stale sample is refreshed by the core with _utee_get_time() */
+	cnt -= ree_cnt;
+	if (cnt > max_age)
+		return false;
+	ms = millis + cnt * TEE_TIME_MILLIS_BASE / freq;
+	time->seconds = secs + ms / TEE_TIME_MILLIS_BASE;
+	time->millis = ms % TEE_TIME_MILLIS_BASE;
+	return true;
+}
+#else
+static bool time_page_read(uint32_t flag __unused, TEE_Time *time __unused)
+{
+	return false;
+}
+#endif
+
 void TEE_GetSystemTime(TEE_Time *time)
 {
-	TEE_Result res = _utee_get_time(UTEE_TIME_CAT_SYSTEM, time);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (time_page_read(UTEE_TIME_PAGE_SYS_VALID, time))
+		return;
+
+	res = _utee_get_time(UTEE_TIME_CAT_SYSTEM, time);
 
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
@@ -695,14 +868,42 @@ TEE_Result TEE_SetTAPersistentTime(const TEE_Time *time)
 
 void TEE_GetREETime(TEE_Time *time)
 {
-	TEE_Result res = _utee_get_time(UTEE_TIME_CAT_REE, time);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (time_page_read(UTEE_TIME_PAGE_REE_VALID, time))
+		return;
+
+	res = _utee_get_time(UTEE_TIME_CAT_REE, time);
 
 	if (res != TEE_SUCCESS)
 		TEE_Panic(res);
 }
 
+/*
+ * The no share heap is managed with the raw malloc functions which don't
+ * lock the heap, TEE_Malloc() and friends do that instead for concurrent
+ * TAs.
+ */
+static unsigned int no_share_lock __maybe_unused = TEE_SPINLOCK_UNLOCK;
+
+static void lock_no_share_heap(void)
+{
+#ifdef CFG_TA_CONCURRENT
+	tee_spin_lock(&no_share_lock);
+#endif
+}
+
+static void unlock_no_share_heap(void)
+{
+#ifdef CFG_TA_CONCURRENT
+	tee_spin_unlock(&no_share_lock);
+#endif
+}
+
 void *TEE_Malloc(size_t len, uint32_t hint)
 {
+	void *p = NULL;
+
 	switch (hint) {
 	case TEE_MALLOC_FILL_ZERO:
 		if (!len)
@@ -718,14 +919,20 @@ void *TEE_Malloc(size_t len, uint32_t hint)
 			return TEE_NULL_SIZED_NO_SHARE_VA;
 		if (!__ta_no_share_malloc_ctx)
 			return NULL;
-		return raw_calloc(0, 0, 1, len, __ta_no_share_malloc_ctx);
+		lock_no_share_heap();
+		p = raw_calloc(0, 0, 1, len, __ta_no_share_malloc_ctx);
+		unlock_no_share_heap();
+		return p;
 
 	case TEE_MALLOC_NO_FILL | TEE_MALLOC_NO_SHARE:
 		if (!len)
 			return TEE_NULL_SIZED_NO_SHARE_VA;
 		if (!__ta_no_share_malloc_ctx)
 			return NULL;
-		return raw_malloc(0, 0, len, __ta_no_share_malloc_ctx);
+		lock_no_share_heap();
+		p = raw_malloc(0, 0, len, __ta_no_share_malloc_ctx);
+		unlock_no_share_heap();
+		return p;
 
 	case TEE_USER_MEM_HINT_NO_FILL_ZERO:
 		if (!len)
@@ -771,9 +978,12 @@ void *TEE_Realloc(void *buffer, size_t newSize)
 	if (no_share) {
 		if (!__ta_no_share_malloc_ctx)
 			return NULL;
-		return raw_malloc_flags(MAF_ZERO_INIT, p, 0, 0,
-					MALLOC_DEFAULT_ALIGNMENT, 1, newSize,
-					__ta_no_share_malloc_ctx);
+		lock_no_share_heap();
+		p = raw_malloc_flags(MAF_ZERO_INIT, p, 0, 0,
+				     MALLOC_DEFAULT_ALIGNMENT, 1, newSize,
+				     __ta_no_share_malloc_ctx);
+		unlock_no_share_heap();
+		return p;
 	}
 
 	return malloc_flags(MAF_ZERO_INIT, p, 1, newSize);
@@ -788,10 +998,13 @@ void TEE_Free(void *buffer)
 {
 	if (buffer != TEE_NULL_SIZED_VA &&
 	    buffer != TEE_NULL_SIZED_NO_SHARE_VA) {
-		if (addr_is_in_no_share_heap(buffer))
+		if (addr_is_in_no_share_heap(buffer)) {
+			lock_no_share_heap();
 			raw_free(buffer, __ta_no_share_malloc_ctx, false);
-		else
+			unlock_no_share_heap();
+		} else {
 			free(buffer);
+		}
 	}
 }
 
@@ -1066,6 +1066,56 @@ void __GP11_TEE_CipherInit(TEE_OperationHandle operation, const void *IV,
 	return TEE_CipherInit(operation, IV, IVLen);
 }
 
+/*
+ * Returns the number of bytes of @slen bytes to pass directly to TEE Core
+ * when the buffer is empty. Only the minimum needed to complete the
+ * operation is held back: a possibly partial last block, or the last two
+ * blocks if the algorithm needs two blocks buffered. This is called when
+ * @slen is at least @buffer_size, plus one if single blocks are buffered.
+ */
+static size_t bulk_len(TEE_OperationHandle op, size_t slen,
+		       size_t buffer_size)
+{
+	if (op->buffer_two_blocks)
+		return ROUNDUP2(slen - buffer_size, op->block_size);
+	return ROUNDUP2(slen - buffer_size + 1, op->block_size);
+}
+
+/*
+ * Feeds the full buffer followed by @len bytes of @src with a single
+ * system call instead of one call for each. Both ranges are a multiple
+ * of the block size so the output of each is as long as its input and
+ * the output of @src follows directly after the output of the buffer.
+ */
+static TEE_Result update_buf_and_src(TEE_OperationHandle op, const void *src,
+				     size_t len, void *dst, uint64_t *dlen)
+{
+	struct utee_cryp_iov iov[2] = {
+		{
+			.src = (vaddr_t)op->buffer,
+			.src_len = op->buffer_offs,
+			.dst = (vaddr_t)dst,
+			.dst_len = op->buffer_offs,
+		},
+		{
+			.src = (vaddr_t)src,
+			.src_len = len,
+			.dst = (vaddr_t)dst + op->buffer_offs,
+			.dst_len = *dlen - op->buffer_offs,
+		},
+	};
+	TEE_Result res = TEE_SUCCESS;
+
+	res = _utee_cryp_update_vec(op->state, iov, ARRAY_SIZE(iov));
+	if (res)
+		return res;
+	if (iov[0].dst_len != op->buffer_offs || iov[1].dst_len != len)
+		return TEE_ERROR_GENERIC;
+
+	*dlen = op->buffer_offs + len;
+	return TEE_SUCCESS;
+}
+
 static TEE_Result tee_buffer_update(
 		TEE_OperationHandle op,
 		TEE_Result(*update_func)(unsigned long state, const void *src,
@@ -1124,6 +1174,23 @@ static TEE_Result tee_buffer_update(
 		 */
 		if (!op->buffer_two_blocks)
 			l = op->block_size;
+		if (l == op->buffer_offs &&
+		    slen >= (buffer_size + buffer_left)) {
+			/*
+			 * The buffer is emptied and there's enough data left
+			 * to feed directly from src, pass both at once.
+			 */
+			l = bulk_len(op, slen, buffer_size);
+			tmp_dlen = dlen;
+			res = update_buf_and_src(op, src, l, dst, &tmp_dlen);
+			if (res != TEE_SUCCESS)
+				TEE_Panic(res);
+			src += l;
+			slen -= l;
+			acc_dlen += tmp_dlen;
+			op->buffer_offs = 0;
+			goto buffer_tail;
+		}
 		tmp_dlen = dlen;
 		res = update_func(op->state, op->buffer, l, dst, &tmp_dlen);
 		if (res != TEE_SUCCESS)
@@ -1145,11 +1212,7 @@ static TEE_Result tee_buffer_update(
 
 	if (slen >= (buffer_size + buffer_left)) {
 		/* Buffer is empty, feed as much as possible from src */
-		if (op->buffer_two_blocks)
-			l = ROUNDUP2(slen - buffer_size, op->block_size);
-		else
-			l = ROUNDUP2(slen - buffer_size + 1, op->block_size);
-
+		l = bulk_len(op, slen, buffer_size);
 		tmp_dlen = dlen;
 		res = update_func(op->state, src, l, dst, &tmp_dlen);
 		if (res != TEE_SUCCESS)
@@ -1161,6 +1224,7 @@ static TEE_Result tee_buffer_update(
 		acc_dlen += tmp_dlen;
 	}
 
+buffer_tail:
 	/* Slen is small enough to be contained in buffer. */
 	memcpy(op->buffer + op->buffer_offs, src, slen);
 	op->buffer_offs += slen;
@@ -1170,6 +1234,31 @@ out:
 	return TEE_SUCCESS;
 }
 
+/*
+ * Returns the output length of an update of @src_len bytes when
+ * @buffer_offs bytes are buffered in @operation since earlier updates.
+ */
+static size_t update_req_dlen(TEE_OperationHandle operation,
+			      size_t buffer_offs, size_t src_len)
+{
+	size_t bs = operation->block_size;
+	size_t req_dlen = 0;
+
+	if (bs <= 1)
+		return src_len;
+
+	if (operation->buffer_two_blocks) {
+		if (buffer_offs + src_len > bs * 2) {
+			req_dlen = buffer_offs + src_len - bs * 2;
+			req_dlen = ROUNDUP2(req_dlen, bs);
+		}
+	} else {
+		req_dlen = ((buffer_offs + src_len) / bs) * bs;
+	}
+
+	return req_dlen;
+}
+
 TEE_Result TEE_CipherUpdate(TEE_OperationHandle operation, const void *srcData,
 			    size_t srcLen, void *destData, size_t *destLen)
 {
@@ -1204,23 +1293,7 @@ TEE_Result TEE_CipherUpdate(TEE_OperationHandle operation, const void *srcData,
 		goto out;
 	}
 
-	/* Calculate required dlen */
-	if (operation->block_size > 1) {
-		req_dlen = ((operation->buffer_offs + srcLen) /
-			    operation->block_size) * operation->block_size;
-	} else {
-		req_dlen = srcLen;
-	}
-	if (operation->buffer_two_blocks) {
-		if (operation->buffer_offs + srcLen >
-		    operation->block_size * 2) {
-			req_dlen = operation->buffer_offs + srcLen -
-				   operation->block_size * 2;
-			req_dlen = ROUNDUP2(req_dlen, operation->block_size);
-		} else {
-			req_dlen = 0;
-		}
-	}
+	req_dlen = update_req_dlen(operation, operation->buffer_offs, srcLen);
 	/*
 	 * Check that required destLen is big enough before starting to feed
 	 * data to the algorithm. Errors during feeding of data are fatal as we
@@ -2009,6 +2082,471 @@ TEE_Result __GP11_TEE_AEDecryptFinal(TEE_OperationHandle operation,
 	return res;
 }
 
+/* Cryptographic Operations API - One-shot extensions */
+
+static bool is_nopad_cipher(uint32_t algo)
+{
+	switch (algo) {
+	case TEE_ALG_AES_ECB_NOPAD:
+	case TEE_ALG_AES_CBC_NOPAD:
+	case TEE_ALG_DES_ECB_NOPAD:
+	case TEE_ALG_DES_CBC_NOPAD:
+	case TEE_ALG_DES3_ECB_NOPAD:
+	case TEE_ALG_DES3_CBC_NOPAD:
+	case TEE_ALG_SM4_ECB_NOPAD:
+	case TEE_ALG_SM4_CBC_NOPAD:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Initializes @operation and processes all data with a single system
+ * call. The operation must not be in the middle of a multi-stage
+ * operation and a key must be set unless it's a digest operation.
+ */
+static TEE_Result do_oneshot(TEE_OperationHandle operation, uint32_t op_class,
+			     struct utee_cryp_oneshot *args)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (operation == TEE_HANDLE_NULL ||
+	    operation->info.operationClass != op_class ||
+	    operation->operationState != TEE_OPERATION_STATE_INITIAL)
+		TEE_Panic(0);
+
+	if (op_class != TEE_OPERATION_DIGEST &&
+	    !(operation->info.handleState & TEE_HANDLE_FLAG_KEY_SET))
+		TEE_Panic(0);
+
+	res = _utee_cryp_oneshot(operation->state, args);
+
+	/* A digest operation is initialized again by the system call */
+	if (op_class != TEE_OPERATION_DIGEST)
+		operation->info.handleState &= ~TEE_HANDLE_FLAG_INITIALIZED;
+
+	return res;
+}
+
+TEE_Result TEE_DigestOneShot(TEE_OperationHandle operation, const void *chunk,
+			     size_t chunkLen, void *hash, size_t *hashLen)
+{
+	struct utee_cryp_oneshot args = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!chunk && chunkLen)
+		TEE_Panic(0);
+	__utee_check_inout_annotation(hashLen, sizeof(*hashLen));
+
+	args.src = (vaddr_t)chunk;
+	args.src_len = chunkLen;
+	args.dst = (vaddr_t)hash;
+	args.dst_len = *hashLen;
+
+	res = do_oneshot(operation, TEE_OPERATION_DIGEST, &args);
+	*hashLen = args.dst_len;
+	if (res != TEE_SUCCESS && res != TEE_ERROR_SHORT_BUFFER)
+		TEE_Panic(res);
+
+	return res;
+}
+
+TEE_Result TEE_MACComputeOneShot(TEE_OperationHandle operation,
+				 const void *IV, size_t IVLen,
+				 const void *message, size_t messageLen,
+				 void *mac, size_t *macLen)
+{
+	struct utee_cryp_oneshot args = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	if ((!IV && IVLen) || (!message && messageLen))
+		TEE_Panic(0);
+	__utee_check_inout_annotation(macLen, sizeof(*macLen));
+
+	args.iv = (vaddr_t)IV;
+	args.iv_len = IVLen;
+	args.src = (vaddr_t)message;
+	args.src_len = messageLen;
+	args.dst = (vaddr_t)mac;
+	args.dst_len = *macLen;
+
+	res = do_oneshot(operation, TEE_OPERATION_MAC, &args);
+	*macLen = args.dst_len;
+	if (res != TEE_SUCCESS && res != TEE_ERROR_SHORT_BUFFER)
+		TEE_Panic(res);
+
+	return res;
+}
+
+TEE_Result TEE_CipherOneShot(TEE_OperationHandle operation, const void *IV,
+			     size_t IVLen, const void *srcData, size_t srcLen,
+			     void *destData, size_t *destLen)
+{
+	struct utee_cryp_oneshot args = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	if (operation == TEE_HANDLE_NULL || (!IV && IVLen) ||
+	    (!srcData && srcLen))
+		TEE_Panic(0);
+	if (destLen)
+		__utee_check_inout_annotation(destLen, sizeof(*destLen));
+
+	if (is_nopad_cipher(operation->info.algorithm) &&
+	    srcLen % operation->block_size)
+		TEE_Panic(0);
+
+	if (destLen)
+		args.dst_len = *destLen;
+	if (args.dst_len < srcLen) {
+		if (destLen)
+			*destLen = srcLen;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	args.iv = (vaddr_t)IV;
+	args.iv_len = IVLen;
+	args.src = (vaddr_t)srcData;
+	args.src_len = srcLen;
+	args.dst = (vaddr_t)destData;
+
+	res = do_oneshot(operation, TEE_OPERATION_CIPHER, &args);
+	if (res != TEE_SUCCESS)
+		TEE_Panic(res);
+	if (destLen)
+		*destLen = args.dst_len;
+
+	return TEE_SUCCESS;
+}
+
+/* AES-GCM tag lengths in bytes, see TEE_AEInit() */
+static bool ae_tag_len_ok(TEE_OperationHandle operation, size_t tag_len)
+{
+	if (operation->info.algorithm != TEE_ALG_AES_GCM)
+		return true;
+
+	return tag_len >= 12 && tag_len <= 16;
+}
+
+TEE_Result TEE_AEEncryptOneShot(TEE_OperationHandle operation,
+				const void *nonce, size_t nonceLen,
+				const void *AADdata, size_t AADdataLen,
+				const void *srcData, size_t srcLen,
+				void *destData, size_t *destLen,
+				void *tag, size_t *tagLen)
+{
+	struct utee_cryp_oneshot args = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	if (operation == TEE_HANDLE_NULL || !nonce ||
+	    (!AADdata && AADdataLen) || (!srcData && srcLen))
+		TEE_Panic(0);
+	__utee_check_inout_annotation(destLen, sizeof(*destLen));
+	__utee_check_inout_annotation(tagLen, sizeof(*tagLen));
+
+	if (!ae_tag_len_ok(operation, *tagLen))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (*destLen < srcLen) {
+		*destLen = srcLen;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	args.iv = (vaddr_t)nonce;
+	args.iv_len = nonceLen;
+	args.aad = (vaddr_t)AADdata;
+	args.aad_len = AADdataLen;
+	args.src = (vaddr_t)srcData;
+	args.src_len = srcLen;
+	args.dst = (vaddr_t)destData;
+	args.dst_len = *destLen;
+	args.tag = (vaddr_t)tag;
+	args.tag_len = *tagLen;
+
+	res = do_oneshot(operation, TEE_OPERATION_AE, &args);
+	if (res != TEE_SUCCESS && res != TEE_ERROR_SHORT_BUFFER &&
+	    res != TEE_ERROR_NOT_SUPPORTED)
+		TEE_Panic(res);
+	if (res == TEE_SUCCESS)
+		operation->info.digestLength = *tagLen;
+	if (res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER) {
+		*destLen = args.dst_len;
+		*tagLen = args.tag_len;
+	}
+
+	return res;
+}
+
+TEE_Result TEE_AEDecryptOneShot(TEE_OperationHandle operation,
+				const void *nonce, size_t nonceLen,
+				const void *AADdata, size_t AADdataLen,
+				const void *srcData, size_t srcLen,
+				void *destData, size_t *destLen,
+				const void *tag, size_t tagLen)
+{
+	struct utee_cryp_oneshot args = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	if (operation == TEE_HANDLE_NULL || !nonce ||
+	    (!AADdata && AADdataLen) || (!srcData && srcLen))
+		TEE_Panic(0);
+	__utee_check_inout_annotation(destLen, sizeof(*destLen));
+
+	if (!ae_tag_len_ok(operation, tagLen))
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (*destLen < srcLen) {
+		*destLen = srcLen;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	args.iv = (vaddr_t)nonce;
+	args.iv_len = nonceLen;
+	args.aad = (vaddr_t)AADdata;
+	args.aad_len = AADdataLen;
+	args.src = (vaddr_t)srcData;
+	args.src_len = srcLen;
+	args.dst = (vaddr_t)destData;
+	args.dst_len = *destLen;
+	args.tag = (vaddr_t)tag;
+	args.tag_len = tagLen;
+
+	res = do_oneshot(operation, TEE_OPERATION_AE, &args);
+	if (res != TEE_SUCCESS && res != TEE_ERROR_MAC_INVALID &&
+	    res != TEE_ERROR_NOT_SUPPORTED)
+		TEE_Panic(res);
+	if (res == TEE_SUCCESS) {
+		operation->info.digestLength = tagLen;
+		*destLen = args.dst_len;
+	}
+
+	return res;
+}
+
+/* Cryptographic Operations API - Vectored update extensions */
+
+/*
+ * Number of segments converted on the stack, more segments are converted
+ * in a heap buffer of up to UTEE_CRYP_IOV_MAX segments so each system
+ * call can take as many segments as the TEE Core accepts.
+ */
+#define CRYP_IOV_STACK	8
+
+/*
+ * Passes @iov to _utee_cryp_update_vec() in batches of up to
+ * UTEE_CRYP_IOV_MAX segments. @out is NULL for digest and MAC
+ * operations, else the same array as @iov which receives the lengths of
+ * the output data in its @dst_len fields.
+ */
+static TEE_Result update_vec(TEE_OperationHandle operation,
+			     const struct tee_cryp_iov *iov, size_t iov_cnt,
+			     struct tee_cryp_iov *out)
+{
+	struct utee_cryp_iov stack_uiov[CRYP_IOV_STACK] = { };
+	struct utee_cryp_iov *uiov = stack_uiov;
+	size_t batch = CRYP_IOV_STACK;
+	TEE_Result res = TEE_SUCCESS;
+	size_t cnt = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	if (iov_cnt > CRYP_IOV_STACK) {
+		batch = MIN(iov_cnt, (size_t)UTEE_CRYP_IOV_MAX);
+		uiov = TEE_Malloc(batch * sizeof(*uiov), TEE_MALLOC_NO_FILL);
+		if (!uiov) {
+			/* Still correct, only with more system calls */
+			uiov = stack_uiov;
+			batch = CRYP_IOV_STACK;
+		}
+	}
+
+	for (n = 0; n < iov_cnt; n += cnt) {
+		cnt = MIN(iov_cnt - n, batch);
+		for (m = 0; m < cnt; m++) {
+			uiov[m] = (struct utee_cryp_iov){
+				.src = (vaddr_t)iov[n + m].src,
+				.src_len = iov[n + m].src_len,
+			};
+			if (out) {
+				uiov[m].dst = (vaddr_t)iov[n + m].dst;
+				uiov[m].dst_len = iov[n + m].dst_len;
+			}
+		}
+
+		res = _utee_cryp_update_vec(operation->state, uiov, cnt);
+		if (res)
+			goto out;
+
+		if (out)
+			for (m = 0; m < cnt; m++)
+				out[n + m].dst_len = uiov[m].dst_len;
+	}
+
+out:
+	if (uiov != stack_uiov)
+		TEE_Free(uiov);
+
+	return res;
+}
+
+static void check_vec_src(const struct tee_cryp_iov *iov, size_t iov_cnt)
+{
+	size_t n = 0;
+
+	if (!iov && iov_cnt)
+		TEE_Panic(0);
+
+	for (n = 0; n < iov_cnt; n++)
+		if (!iov[n].src && iov[n].src_len)
+			TEE_Panic(0);
+}
+
+/*
+ * Checks that each segment of @iov has room for the output of the
+ * segment, taking data buffered in @operation by earlier updates into
+ * account. Returns TEE_ERROR_SHORT_BUFFER with the required sizes in the
+ * @dst_len fields of the short segments if any segment is too small.
+ *
+ * *@direct is set to true if no data is buffered before or after any
+ * segment, the segments can then be passed to TEE Core as they are.
+ */
+static TEE_Result check_vec_dst(TEE_OperationHandle operation,
+				struct tee_cryp_iov *iov, size_t iov_cnt,
+				bool *direct)
+{
+	TEE_Result res = TEE_SUCCESS;
+	size_t offs = operation->buffer_offs;
+	size_t req_dlen = 0;
+	size_t n = 0;
+
+	*direct = true;
+	for (n = 0; n < iov_cnt; n++) {
+		__utee_check_outbuf_annotation(iov[n].dst, &iov[n].dst_len);
+		req_dlen = update_req_dlen(operation, offs, iov[n].src_len);
+		offs += iov[n].src_len - req_dlen;
+		if (offs || req_dlen != iov[n].src_len)
+			*direct = false;
+		if (iov[n].dst_len < req_dlen) {
+			iov[n].dst_len = req_dlen;
+			res = TEE_ERROR_SHORT_BUFFER;
+		}
+	}
+
+	return res;
+}
+
+void TEE_DigestUpdateVec(TEE_OperationHandle operation,
+			 const struct tee_cryp_iov *iov, size_t iov_cnt)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (operation == TEE_HANDLE_NULL ||
+	    operation->info.operationClass != TEE_OPERATION_DIGEST)
+		TEE_Panic(0);
+	check_vec_src(iov, iov_cnt);
+
+	operation->operationState = TEE_OPERATION_STATE_ACTIVE;
+
+	res = update_vec(operation, iov, iov_cnt, NULL);
+	if (res != TEE_SUCCESS)
+		TEE_Panic(res);
+}
+
+void TEE_MACUpdateVec(TEE_OperationHandle operation,
+		      const struct tee_cryp_iov *iov, size_t iov_cnt)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (operation == TEE_HANDLE_NULL ||
+	    operation->info.operationClass != TEE_OPERATION_MAC ||
+	    !(operation->info.handleState & TEE_HANDLE_FLAG_INITIALIZED) ||
+	    operation->operationState != TEE_OPERATION_STATE_ACTIVE)
+		TEE_Panic(0);
+	check_vec_src(iov, iov_cnt);
+
+	res = update_vec(operation, iov, iov_cnt, NULL);
+	if (res != TEE_SUCCESS)
+		TEE_Panic(res);
+}
+
+TEE_Result TEE_CipherUpdateVec(TEE_OperationHandle operation,
+			       struct tee_cryp_iov *iov, size_t iov_cnt)
+{
+	TEE_Result res = TEE_SUCCESS;
+	bool direct = false;
+	size_t n = 0;
+
+	if (operation == TEE_HANDLE_NULL ||
+	    operation->info.operationClass != TEE_OPERATION_CIPHER ||
+	    !(operation->info.handleState & TEE_HANDLE_FLAG_INITIALIZED) ||
+	    operation->operationState != TEE_OPERATION_STATE_ACTIVE)
+		TEE_Panic(0);
+	check_vec_src(iov, iov_cnt);
+
+	res = check_vec_dst(operation, iov, iov_cnt, &direct);
+	if (res)
+		return res;
+
+	if (direct) {
+		res = update_vec(operation, iov, iov_cnt, iov);
+		if (res != TEE_SUCCESS)
+			TEE_Panic(res);
+		return TEE_SUCCESS;
+	}
+
+	/* Partial blocks are buffered here, process one segment at a time */
+	for (n = 0; n < iov_cnt; n++) {
+		res = TEE_CipherUpdate(operation, iov[n].src, iov[n].src_len,
+				       iov[n].dst, &iov[n].dst_len);
+		if (res != TEE_SUCCESS)
+			TEE_Panic(res);
+	}
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result TEE_AEUpdateVec(TEE_OperationHandle operation,
+			   struct tee_cryp_iov *iov, size_t iov_cnt)
+{
+	TEE_Result res = TEE_SUCCESS;
+	bool direct = false;
+	size_t n = 0;
+
+	if (operation == TEE_HANDLE_NULL ||
+	    operation->info.operationClass != TEE_OPERATION_AE ||
+	    !(operation->info.handleState & TEE_HANDLE_FLAG_INITIALIZED))
+		TEE_Panic(0);
+	check_vec_src(iov, iov_cnt);
+
+	res = check_vec_dst(operation, iov, iov_cnt, &direct);
+	if (res)
+		return res;
+
+	if (direct) {
+		res = update_vec(operation, iov, iov_cnt, iov);
+		if (res != TEE_SUCCESS)
+			TEE_Panic(res);
+	} else {
+		/* Partial blocks are buffered here */
+		for (n = 0; n < iov_cnt; n++) {
+			res = TEE_AEUpdate(operation, iov[n].src,
+					   iov[n].src_len, iov[n].dst,
+					   &iov[n].dst_len);
+			if (res != TEE_SUCCESS)
+				TEE_Panic(res);
+		}
+	}
+
+	for (n = 0; n < iov_cnt; n++) {
+		if (iov[n].src_len) {
+			operation->operationState = TEE_OPERATION_STATE_ACTIVE;
+			break;
+		}
+	}
+
+	return TEE_SUCCESS;
+}
+
 /* Cryptographic Operations API - Asymmetric Functions */
 
 TEE_Result TEE_AsymmetricEncrypt(TEE_OperationHandle operation,
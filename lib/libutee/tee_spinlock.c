@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2026, Linaro Limited
+ */
+
+#include <atomic.h>
+#include <compiler.h>
+#include <stdbool.h>
+#include <tee_internal_api_extensions.h>
+
+bool tee_spin_trylock(unsigned int *lock)
+{
+	unsigned int unlocked = TEE_SPINLOCK_UNLOCK;
+
+	/* The weak compare and swap may fail spuriously, try again then */
+	while (!atomic_cas_uint(lock, &unlocked, TEE_SPINLOCK_LOCK)) {
+		if (unlocked != TEE_SPINLOCK_UNLOCK)
+			return false;
+	}
+
+	return true;
+}
+
+void tee_spin_lock(unsigned int *lock)
+{
+	while (!tee_spin_trylock(lock))
+		while (atomic_load_uint(lock) != TEE_SPINLOCK_UNLOCK)
+			;
+}
+
+void tee_spin_unlock(unsigned int *lock)
+{
+	__atomic_store_n(lock, TEE_SPINLOCK_UNLOCK, __ATOMIC_RELEASE);
+}
@@ -4,6 +4,7 @@
  * Copyright (c) 2022, Linaro Limited.
  */
 #include <compiler.h>
+#include <config.h>
 #include <link.h>
 #include <malloc.h>
 #include <memtag.h>
@@ -416,10 +417,43 @@ static TEE_Result entry_dump_memstats(unsigned long session_id __unused,
 }
 #endif
 
+/*
+ * The TEE Core lets only invocations of commands with value parameters
+ * execute in parallel with other entries, everything else enters alone.
+ * See CFG_TA_CONCURRENT.
+ */
+static bool is_parallel_entry(unsigned long func,
+			      const struct utee_params *up)
+{
+	size_t n = 0;
+
+	if (!IS_ENABLED(CFG_TA_CONCURRENT) ||
+	    !(ta_head.flags & TA_FLAG_CONCURRENT) ||
+	    func != UTEE_ENTRY_FUNC_INVOKE_COMMAND)
+		return false;
+
+	for (n = 0; n < TEE_NUM_PARAMS; n++) {
+		switch (TEE_PARAM_TYPE_GET(up->types, n)) {
+		case TEE_PARAM_TYPE_MEMREF_INPUT:
+		case TEE_PARAM_TYPE_MEMREF_OUTPUT:
+		case TEE_PARAM_TYPE_MEMREF_INOUT:
+			return false;
+		default:
+			break;
+		}
+	}
+
+	return true;
+}
+
 TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 			struct utee_params *up, unsigned long cmd_id)
 {
 	TEE_Result res;
+	bool parallel = is_parallel_entry(func, up);
+	void *tcb = NULL;
+
+	tcb = __utee_tcb_enter(parallel);
 
 	switch (func) {
 	case UTEE_ENTRY_FUNC_OPEN_SESSION:
@@ -441,6 +475,7 @@ TEE_Result __utee_entry(unsigned long func, unsigned long session_id,
 		break;
 	}
 	ta_header_save_params(0, NULL);
+	__utee_tcb_exit(tcb, parallel);
 
 	return res;
 }
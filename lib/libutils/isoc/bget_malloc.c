@@ -78,6 +78,7 @@
 #define BufStats    1
 #endif
 
+#include <atomic.h>
 #include <compiler.h>
 #include <config.h>
 #include <malloc.h>
@@ -138,7 +139,7 @@ struct malloc_ctx {
 #ifdef BufStats
 	struct pta_stats_alloc mstats;
 #endif
-#ifdef __KERNEL__
+#if defined(__KERNEL__) || defined(CFG_TA_CONCURRENT)
 	unsigned int spinlock;
 #endif
 };
@@ -155,6 +156,25 @@ static void malloc_unlock(struct malloc_ctx *ctx, uint32_t exceptions)
 	cpu_spin_unlock_xrestore(&ctx->spinlock, exceptions);
 }
 
+#elif defined(CFG_TA_CONCURRENT)
+
+/* The TA may be executing on several cores at once */
+static uint32_t malloc_lock(struct malloc_ctx *ctx)
+{
+	unsigned int unlocked = 0;
+
+	while (!atomic_cas_uint(&ctx->spinlock, &unlocked, 1))
+		unlocked = 0;
+
+	return 0;
+}
+
+static void malloc_unlock(struct malloc_ctx *ctx,
+			  uint32_t exceptions __unused)
+{
+	__atomic_store_n(&ctx->spinlock, 0, __ATOMIC_RELEASE);
+}
+
 #else  /* __KERNEL__ */
 
 static uint32_t malloc_lock(struct malloc_ctx *ctx __unused)
@@ -112,6 +112,20 @@ CFG_MSG_LONG_PREFIX_MASK ?= 0x1a
 # Number of threads
 CFG_NUM_THREADS ?= 2
 
+# Number of threads with a preallocated stack. The stacks of the other
+# threads, up to CFG_NUM_THREADS, are allocated from the core heap when a
+# thread is started and freed when it exits, so bursts of concurrent calls
+# can be served without reserving stacks that are idle most of the time.
+# Not used with CFG_WITH_PAGER where the thread stacks are already paged
+# in on demand, or with CFG_NS_VIRTUALIZATION.
+CFG_NUM_THREADS_PREALLOC ?= $(CFG_NUM_THREADS)
+
+# CFG_CORE_MUTEX_SPIN_US sets for how many microseconds a thread spins
+# waiting for a mutex held by a thread executing on another core before
+# waiting in normal world, which costs two world switches. 0 disables
+# spinning.
+CFG_CORE_MUTEX_SPIN_US ?= 20
+
 # API implementation version
 CFG_TEE_API_VERSION ?= GPD-1.1-dev
 
@@ -428,6 +442,30 @@ CFG_WITH_PAGER ?= n
 # Use the pager for user TAs
 CFG_PAGED_USER_TA ?= $(CFG_WITH_PAGER)
 
+# CFG_PAGER_READ_AHEAD_MAX sets the maximum number of pages the pager
+# populates ahead of a fault once sequential faults are detected in a paged
+# region. Only free physical pages are used. 0 disables read-ahead.
+CFG_PAGER_READ_AHEAD_MAX ?= 4
+
+# CFG_PAGER_CLOCK selects clock (second chance) page replacement in the
+# pager. Pages are only hidden, to sample if they are referenced, when the
+# clock hand passes them instead of hiding a third of the pages after each
+# fault. With CFG_PAGER_CLOCK=n the oldest page is replaced.
+CFG_PAGER_CLOCK ?= y
+
+# CFG_CORE_RWP_COMPRESS stores evicted R/W paged pages compressed, and
+# still encrypted and authenticated, in a pool of TA RAM which grows as
+# needed instead of reserving a full page of backing store for each paged
+# page up front. Zero filled and sparse pages use a fraction of a page.
+# When the pool can't grow a page is stored uncompressed in a page of its
+# own instead, only running out of TA RAM entirely is fatal. This covers
+# fobj_rw_paged_alloc() users, that is, user TA memory with
+# CFG_PAGED_USER_TA=y. The R/W paged areas of the core itself are locked
+# and never saved so a pager with only the core paged doesn't gain from
+# this. Only used with CFG_CORE_PAGE_TAG_AND_IV=n.
+CFG_CORE_RWP_COMPRESS ?= n
+$(eval $(call cfg-depends-all,CFG_CORE_RWP_COMPRESS,CFG_WITH_PAGER))
+
 # If paging of user TAs, that is, R/W paging default to enable paging of
 # TAG and IV in order to reduce heap usage.
 CFG_CORE_PAGE_TAG_AND_IV ?= $(CFG_PAGED_USER_TA)
@@ -710,6 +748,11 @@ CFG_CORE_DYN_SHM ?= y
 # memory area).
 CFG_CORE_RESERVED_SHM ?= y
 
+# CFG_CORE_PHYS_MEM_BUDDY, when enabled, lets a buddy allocator decide where
+# to place allocations of secure physical memory (TA RAM and core RAM) to
+# limit fragmentation when TAs are loaded and unloaded repeatedly.
+CFG_CORE_PHYS_MEM_BUDDY ?= y
+
 # Enables support for larger physical addresses, that is, it will define
 # paddr_t as a 64-bit type.
 CFG_CORE_LARGE_PHYS_ADDR ?= n
@@ -1044,6 +1087,19 @@ endif
 # Enable callout service
 CFG_CALLOUT ?= $(CFG_CORE_ASYNC_NOTIF)
 
+# CFG_CALLOUT_SLACK_MS, maximum delay in milliseconds the callout service
+# may add to a timeout in order to let callouts expiring close to each
+# other share one timer interrupt. Callouts are never called early, and
+# periodic callouts don't drift since the next expiry is computed from the
+# previous expiry value. 0 means that each timeout is programmed exactly.
+CFG_CALLOUT_SLACK_MS ?= 0
+
+# CFG_CORE_WORKQUEUE, when enabled drivers can defer work from interrupt
+# handlers and callouts to a thread, see <kernel/workqueue.h>. The work is
+# executed from the bottom half driven by asynchronous notifications.
+CFG_CORE_WORKQUEUE ?= n
+$(eval $(call cfg-depends-all,CFG_CORE_WORKQUEUE,CFG_CORE_ASYNC_NOTIF))
+
 # Enable notification based test watchdog
 CFG_NOTIF_TEST_WD ?= $(call cfg-all-enabled,CFG_ENABLE_EMBEDDED_TESTS \
 		       CFG_CALLOUT CFG_CORE_ASYNC_NOTIF)
@@ -1149,6 +1205,60 @@ CFG_PGT_CACHE_ENTRIES ?= ($(CFG_NUM_THREADS) * 2)
 # STATS_CMD_TA_STATS to get the context of loaded TAs.
 CFG_TA_STATS ?= n
 
+# When a TA which can't be entered concurrently is busy, waiting threads
+# are queued in FIFO order. The same applies to threads waiting for the
+# lock serializing all single-instance TAs with
+# CFG_CONCURRENT_SINGLE_INSTANCE_TA=n. With CFG_TA_BUSY_PRIO=y calls from
+# other TAs are queued in a separate class served ahead of normal world
+# clients, with a bound on how often a waiting normal world client is
+# passed over.
+CFG_TA_BUSY_PRIO ?= y
+
+# Open sessions are looked up by ID in a hash table with
+# 2^CFG_TA_SESSION_HASH_ORDER buckets, shared by all session lists.
+CFG_TA_SESSION_HASH_ORDER ?= 8
+
+# Crypto operation and object handles of a user TA are validated in hash
+# tables with 2^CFG_TA_HANDLE_HASH_ORDER buckets each, per TA instance.
+CFG_TA_HANDLE_HASH_ORDER ?= 6
+
+# With CFG_USER_ACCESS_CACHE=y each thread remembers the last
+# CFG_USER_ACCESS_CACHE_ENTRIES user mode ranges successfully checked by
+# vm_check_access_rights() during the current system call, checking the
+# same range or a part of it again is then done without walking the
+# translation tables. The ranges are forgotten when the system call is
+# entered and left and when a user mapping is removed or changed.
+CFG_USER_ACCESS_CACHE ?= y
+CFG_USER_ACCESS_CACHE_ENTRIES ?= 4
+
+# With CFG_TA_ZERO_COPY_PARAMS=y a memref passed from one user TA to
+# another with TEE_OpenTASession() or TEE_InvokeTACommand() that covers
+# whole pages (UTEE_ZERO_COPY_ALIGN) of the private memory of the calling
+# TA is mapped directly into the called TA. Without it, or for other
+# private buffers which may share pages with unrelated data, libutee copies
+# the buffer into a temporary shareable buffer and back. MEMREF_INPUT
+# parameters mapped this way are read-only in the called TA. Not
+# supported with CFG_PAGED_USER_TA since paged TA memory can't be mapped
+# in two TAs.
+ifeq ($(CFG_PAGED_USER_TA),y)
+$(call force,CFG_TA_ZERO_COPY_PARAMS,n)
+else
+CFG_TA_ZERO_COPY_PARAMS ?= y
+endif
+
+# With CFG_TA_CONCURRENT=y a user TA with TA_FLAG_CONCURRENT set can be
+# invoked from several threads at once. Each concurrent invocation gets a
+# stack of its own, CFG_TA_CONCURRENT_STACKS stacks are allocated in the
+# TA address space in addition to the main stack. Only invocations with
+# value parameters run in parallel, system calls from the same TA instance
+# are serialized. Such invocations can't load libraries with dlopen(). With
+# CFG_TA_CONCURRENT=n the flag is ignored for user TAs.
+# Depends on CFG_CORE_PREALLOC_EL0_TBLS=y since the translation tables of
+# the TA must stay in place while it's active on several cores.
+CFG_TA_CONCURRENT ?= n
+CFG_TA_CONCURRENT_STACKS ?= 3
+$(eval $(call cfg-depends-all,CFG_TA_CONCURRENT,CFG_CORE_PREALLOC_EL0_TBLS))
+
 # Enables best effort mitigations against fault injected when the hardware
 # is tampered with. Details in lib/libutils/ext/include/fault_mitigation.h
 CFG_FAULT_MITIGATION ?= y